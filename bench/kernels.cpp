@@ -0,0 +1,294 @@
+/*
+ * ns per call of the evaluation kernels, as CSV on stdout:
+ *
+ *     benchmark,regime,path,samples,calls,median_ns,mad_ns,min_ns,max_ns
+ *
+ * each benchmark is warmed up and calibrated to ~1 ms samples, then timed
+ * over a number of samples on one pinned CPU; mad is the median absolute
+ * deviation of the samples from the median. compare runs from before and
+ * after a library update to catch regressions in the hot kernels.
+ *
+ * usage: kernels [--samples n] [--cpu k] [filter]
+ *   runs only benchmarks whose name contains filter (all by default)
+ */
+
+#include "dca/any_decline.hpp"
+#include "dca/decline.hpp"
+#include "dca/duong.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+#include "dca/stretched.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+struct options {
+    std::size_t samples = 25;
+    int cpu = 0;
+    std::string filter;
+};
+
+volatile double sink; // keeps results observable
+
+const std::size_t n_inputs = 1024; // a power of two
+std::vector<double> times; // in years, over a 30-year life
+
+bool pin_to_cpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+double median(std::vector<double> x)
+{
+    std::sort(x.begin(), x.end());
+    std::size_t mid = x.size() / 2;
+    return x.size() % 2 ? x[mid] : 0.5 * (x[mid - 1] + x[mid]);
+}
+
+// seconds for n calls of fn(i), i = 0, 1, ...
+template<class Fn>
+double time_calls(Fn& fn, std::size_t n)
+{
+    auto start = std::chrono::steady_clock::now();
+    double acc = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+        acc += fn(i);
+    auto stop = std::chrono::steady_clock::now();
+    sink = acc;
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+/*
+ * time fn, where each call does `per` units of work (e.g. lanes of a
+ * batch), and print a CSV row of ns per unit
+ */
+template<class Fn>
+void bench(const options& opts, const std::string& name,
+        const std::string& regime, const std::string& path, Fn fn,
+        std::size_t per = 1)
+{
+    if (name.find(opts.filter) == std::string::npos)
+        return;
+
+    // calibrate (which also warms up), then one more untimed sample
+    const double target = 1e-3;
+    std::size_t calls = 1;
+    while (time_calls(fn, calls) < target && calls < (std::size_t(1) << 30))
+        calls *= 2;
+    time_calls(fn, calls);
+
+    std::vector<double> ns;
+    for (std::size_t s = 0; s < opts.samples; ++s)
+        ns.push_back(1e9 * time_calls(fn, calls) / (calls * per));
+
+    double mid = median(ns);
+    std::vector<double> deviation;
+    for (double x : ns)
+        deviation.push_back(std::abs(x - mid));
+
+    std::cout << name << ',' << regime << ',' << path << ','
+        << opts.samples << ',' << calls * per << ',' << mid << ','
+        << median(deviation) << ','
+        << *std::min_element(ns.begin(), ns.end()) << ','
+        << *std::max_element(ns.begin(), ns.end()) << '\n';
+}
+
+// rate, cumulative and D, where the model has D(time)
+template<class Decline>
+void bench_model(const options& opts, const std::string& model,
+        const std::string& regime, const Decline& decl)
+{
+    bench(opts, model + "::rate", regime, "scalar", [&](std::size_t i) {
+        return decl.rate(times[i & (n_inputs - 1)]);
+    });
+    bench(opts, model + "::cumulative", regime, "scalar", [&](std::size_t i) {
+        return decl.cumulative(times[i & (n_inputs - 1)]);
+    });
+    bench(opts, model + "::D", regime, "scalar", [&](std::size_t i) {
+        return decl.D(times[i & (n_inputs - 1)]);
+    });
+}
+
+template<dca::decline_rate From, dca::decline_rate To>
+void bench_conversion(const options& opts, const std::string& name)
+{
+    for (double b : { 0.0, 1.0, 0.8 }) {
+        std::vector<double> declines(n_inputs);
+        for (std::size_t i = 0; i < n_inputs; ++i)
+            declines[i] = 0.05 + 0.9 * i / n_inputs;
+        bench(opts, "convert_decline<" + name + ">",
+                "b=" + std::to_string(b).substr(0, 3), "scalar",
+                [&](std::size_t i) {
+                    return dca::convert_decline<From, To>(
+                            declines[i & (n_inputs - 1)], b);
+                });
+    }
+}
+
+void bench_conversions(const options& opts)
+{
+    using namespace dca;
+    bench_conversion<nominal, nominal>(opts, "nominal->nominal");
+    bench_conversion<nominal, tangent_effective>(opts,
+            "nominal->tangent_effective");
+    bench_conversion<nominal, secant_effective>(opts,
+            "nominal->secant_effective");
+    bench_conversion<tangent_effective, nominal>(opts,
+            "tangent_effective->nominal");
+    bench_conversion<tangent_effective, tangent_effective>(opts,
+            "tangent_effective->tangent_effective");
+    bench_conversion<tangent_effective, secant_effective>(opts,
+            "tangent_effective->secant_effective");
+    bench_conversion<secant_effective, nominal>(opts,
+            "secant_effective->nominal");
+    bench_conversion<secant_effective, tangent_effective>(opts,
+            "secant_effective->tangent_effective");
+    bench_conversion<secant_effective, secant_effective>(opts,
+            "secant_effective->secant_effective");
+}
+
+// one cumulative per well of a mixed batch, per object and by the kernel
+void bench_batch(const options& opts)
+{
+    const std::size_t lanes = 64;
+    std::vector<dca::arps_hyperbolic> wells;
+    std::vector<dca::any> erased;
+    std::vector<double> qi(lanes), Di(lanes), b(lanes);
+    for (std::size_t w = 0; w < lanes; ++w) {
+        const double regimes[] = { 0.0, 1.0, 0.5, 1.6 };
+        qi[w] = 1000.0 + 10.0 * w;
+        Di[w] = 0.3 + 0.02 * w;
+        b[w] = regimes[w % 4];
+        wells.emplace_back(qi[w], Di[w], b[w]);
+        erased.emplace_back(wells.back());
+    }
+
+    bench(opts, "hyperbolic_cumulative/64 wells", "mixed b", "scalar",
+            [&](std::size_t i) {
+                double t = times[i & (n_inputs - 1)], sum = 0.0;
+                for (const auto& w : wells)
+                    sum += w.cumulative(t);
+                return sum;
+            }, lanes);
+
+    bench(opts, "hyperbolic_cumulative/64 wells", "mixed b", "any",
+            [&](std::size_t i) {
+                double t = times[i & (n_inputs - 1)], sum = 0.0;
+                for (const auto& w : erased)
+                    sum += w.cumulative(t);
+                return sum;
+            }, lanes);
+
+    std::vector<double> out(lanes);
+    bench(opts, "hyperbolic_cumulative/64 wells", "mixed b", "batch",
+            [&](std::size_t i) {
+                double t = times[i & (n_inputs - 1)];
+                for (std::size_t w = 0; w < lanes; ++w)
+                    out[w] = dca::hyperbolic_cumulative(qi[w], Di[w], b[w],
+                            t);
+                return out[i % lanes];
+            }, lanes);
+}
+
+void usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+        << " [--samples n] [--cpu k] [filter]\n";
+    std::exit(1);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    options opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc)
+            opts.samples = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--cpu" && i + 1 < argc)
+            opts.cpu = std::atoi(argv[++i]);
+        else if (!arg.empty() && arg[0] == '-')
+            usage(argv[0]);
+        else
+            opts.filter = arg;
+    }
+
+    if (!pin_to_cpu(opts.cpu))
+        std::cerr << "Unable to pin to CPU " << opts.cpu
+            << "; timings may be noisy\n";
+
+    for (std::size_t i = 0; i < n_inputs; ++i)
+        times.push_back(30.0 * i / n_inputs);
+
+    std::cout << "benchmark,regime,path,samples,calls,median_ns,mad_ns,"
+        "min_ns,max_ns\n";
+
+    bench(opts, "arps_exponential::rate", "-", "scalar",
+            [decl = dca::arps_exponential(1000.0, 0.4)](std::size_t i) {
+                return decl.rate(times[i & (n_inputs - 1)]);
+            });
+    bench(opts, "arps_exponential::cumulative", "-", "scalar",
+            [decl = dca::arps_exponential(1000.0, 0.4)](std::size_t i) {
+                return decl.cumulative(times[i & (n_inputs - 1)]);
+            });
+
+    bench_model(opts, "arps_hyperbolic", "b=0",
+            dca::arps_hyperbolic(1000.0, 0.8, 0.0));
+    bench_model(opts, "arps_hyperbolic", "b=1",
+            dca::arps_hyperbolic(1000.0, 0.8, 1.0));
+    bench_model(opts, "arps_hyperbolic", "b=1+1e-7",
+            dca::arps_hyperbolic(1000.0, 0.8, 1.0 + 1e-7));
+    bench_model(opts, "arps_hyperbolic", "b=0.8",
+            dca::arps_hyperbolic(1000.0, 0.8, 0.8));
+    bench_model(opts, "arps_hyperbolic_to_exponential", "b=1.2",
+            dca::arps_hyperbolic_to_exponential(1000.0, 0.8, 1.2, 0.08));
+    bench_model(opts, "stretched_exponential", "n=0.4",
+            dca::stretched_exponential(1000.0, 0.6, 0.4));
+    bench_model(opts, "duong", "m=1.2", dca::duong(1000.0, 1.4, 1.2));
+
+    bench_conversions(opts);
+
+    dca::arps_hyperbolic general(365.25 * 1000.0, 0.8, 0.8);
+    dca::any erased(general);
+    bench(opts, "any::rate", "b=0.8", "any", [&](std::size_t i) {
+        return erased.rate(times[i & (n_inputs - 1)]);
+    });
+    bench(opts, "any::cumulative", "b=0.8", "any", [&](std::size_t i) {
+        return erased.cumulative(times[i & (n_inputs - 1)]);
+    });
+
+    std::vector<double> volumes(360);
+    bench(opts, "interval_volumes/360 months", "b=0.8", "scalar",
+            [&](std::size_t i) {
+                dca::interval_volumes(general, volumes.begin(),
+                        times[i & (n_inputs - 1)], 1.0 / 12.0, 360);
+                return volumes.back();
+            });
+    bench(opts, "eur", "b=0.8", "scalar", [&](std::size_t i) {
+        return dca::eur(general, 365.25 * (1.0 + (i & 15)), 30.0);
+    });
+
+    bench_batch(opts);
+}
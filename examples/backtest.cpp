@@ -0,0 +1,109 @@
+/*
+ * Hindcast Comparison of Decline Models and Fitting Techniques
+ *
+ * Each of a set of synthetic wells is refit on its first k months, for
+ * every k from 3 on, and each fit is scored on the months it didn't see.
+ * A forecasting method that does well on this test is one we can trust
+ * early in a well's life; one whose EUR swings as months come in is not.
+ *
+ * We compare three models, each fit from scratch at every k ("cold") and
+ * refit from the previous k's answer ("warm").
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dca/backtest.hpp"
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+
+const double year_days = 365.25;
+const std::size_t n_wells = 200;
+const std::size_t months = 48;
+
+using range = std::pair<std::vector<double>::const_iterator,
+      std::vector<double>::const_iterator>;
+
+template<class Decline>
+void compare(const std::string& model, const std::vector<range>& wells,
+        const dca::backtest_options& base)
+{
+    for (auto start : { dca::backtest_start::cold,
+            dca::backtest_start::warm }) {
+        auto options = base;
+        options.start = start;
+
+        auto begin = std::chrono::steady_clock::now();
+        auto summary = dca::summarize_backtest(
+                dca::backtest_interval_volume<Decline>(wells, 0.0, 1.0 / 12,
+                    options));
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - begin;
+
+        std::cout << std::setw(16) << model
+            << std::setw(6) << (start == dca::backtest_start::cold
+                    ? "cold" : "warm")
+            << std::setw(8) << summary.refits
+            << std::setw(12) << summary.holdout_mape
+            << std::setw(12) << 100.0 * summary.holdout_bias
+            << std::setw(12) << 100.0 * summary.holdout_abs_error
+            << std::setw(12) << 100.0 * summary.eur_drift
+            << std::setw(10) << elapsed.count() << '\n';
+    }
+}
+
+int main()
+{
+    /*
+     * Wells following hyperbolic declines over a range of b, with 10%
+     * month-to-month noise, so that no model fits exactly.
+     */
+    std::mt19937 gen(5489u);
+    std::uniform_real_distribution<double> b_dist(0.3, 1.8),
+        di_dist(0.5, 0.9), noise(0.9, 1.1);
+
+    std::vector<std::vector<double>> production(n_wells);
+    for (auto& vol : production) {
+        double b = b_dist(gen);
+        dca::arps_hyperbolic decl(200.0 * year_days,
+                dca::decline<dca::secant_effective>(di_dist(gen), b), b);
+        for (std::size_t i = 0; i < months; ++i)
+            vol.push_back((decl.cumulative((i + 1) / 12.0)
+                        - decl.cumulative(i / 12.0)) * noise(gen));
+    }
+
+    std::vector<range> wells;
+    for (const auto& vol : production)
+        wells.emplace_back(vol.begin(), vol.end());
+
+    dca::backtest_options options;
+    options.min_history = 3;
+    options.economic_limit = 2.0 * year_days; // 2 bbl/d
+    options.max_time = 30.0;
+
+    /*
+     * Holdout MAPE is the monthly error on the months held out; bias and
+     * |error| compare the total held-out volume with its forecast. EUR
+     * drift is the change in EUR from one month's refit to the next.
+     */
+    std::cout << std::fixed << std::setprecision(2)
+        << std::setw(16) << "model" << std::setw(6) << "fit"
+        << std::setw(8) << "refits" << std::setw(12) << "MAPE %"
+        << std::setw(12) << "bias %" << std::setw(12) << "|error| %"
+        << std::setw(12) << "EUR drift %" << std::setw(10) << "seconds"
+        << '\n';
+
+    compare<dca::arps_exponential>("exponential", wells, options);
+    compare<dca::arps_hyperbolic>("hyperbolic", wells, options);
+    compare<dca::arps_hyperbolic_to_exponential>("hyp-to-exp", wells,
+            options);
+}
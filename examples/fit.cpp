@@ -2,17 +2,21 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <array>
+#include <utility>
+#include <iterator>
 #include <unordered_map>
 #include <cstddef>
 #include <algorithm>
-#include <cstdlib>
 
 #include "dca/decline.hpp"
 #include "dca/exponential.hpp"
 #include "dca/hyperbolic.hpp"
 #include "dca/hyptoexp.hpp"
 #include "dca/bestfit.hpp"
+#include "dca/parse.hpp"
 #include "dca/production.hpp"
+#include "dca/profile.hpp"
 
 namespace params {
 const std::string id_field = "Name";
@@ -27,11 +31,13 @@ using dataset = std::unordered_map<std::string, std::vector<std::string>>;
 
 dataset read_delimited(std::istream& is, char delim = '\t');
 
-template<class F>
-F foreach_well(const dataset& data, F fn,
-        std::string id_field = params::id_field);
+std::vector<double> numeric_column(const std::vector<std::string>& text,
+        const dca::well_index& wells);
 
-void process_well(const dataset& data);
+using range = std::pair<std::vector<double>::const_iterator,
+      std::vector<double>::const_iterator>;
+
+void process_well(const std::string& id, range oil, range gas);
 
 template<class I, class T, class F>
 void for_delimited(I begin, I end, T delim, F fn)
@@ -66,9 +72,21 @@ int main(int argc, char* argv[])
     }
 
     std::cout << params::id_field << '\t'
-        << "OilEUR\tGasEUR\tBoeEUR\tOil.qi\tOil.Di\tOil.b\tOil.shift\t"
-           "Gas.qi\tGas.Di\tGas.b\tGas.shift\n";
-    foreach_well(data, process_well);
+        << "OilEUR\tGasEUR\tBoeEUR\tOil.qi\tOil.Di\tOil.b\t"
+           "Gas.qi\tGas.Di\tGas.b\tShift\n";
+
+    const auto& ids = data.at(params::id_field);
+    dca::well_index wells(ids.begin(), ids.end());
+    auto oil = numeric_column(data.at(params::oil_field), wells);
+    auto gas = numeric_column(data.at(params::gas_field), wells);
+    for (std::size_t w = 0; w < wells.size(); ++w)
+        process_well(ids[wells.row(w)],
+                wells.rows_of(w, oil.cbegin()),
+                wells.rows_of(w, gas.cbegin()));
+
+#ifdef DCA_PROFILE
+    dca::profile::print(std::cerr, dca::profile::snapshot());
+#endif
 }
 
 dataset read_delimited(std::istream& is, char delim)
@@ -98,70 +116,41 @@ dataset read_delimited(std::istream& is, char delim)
     return result;
 }
 
-template<class F>
-F foreach_well(const dataset& data, F fn, std::string id_field)
+std::vector<double> numeric_column(const std::vector<std::string>& text,
+        const dca::well_index& wells)
 {
-    const auto& id = data.at(id_field);
-
-    std::size_t begin_rec = 0, end_rec = 0;
-    for (std::size_t i = 0; i < id.size(); ++i) {
-        if (id[i] != id[begin_rec] || i == id.size() - 1) {
-            if (i == id.size() - 1)
-                end_rec = i;
-
-            dataset well;
-            std::for_each(data.begin(), data.end(),
-                    [&](const std::pair<std::string,
-                        std::vector<std::string>>& column)
-                    {
-                        well[column.first] = std::vector<std::string>(
-                            column.second.data() + begin_rec,
-                            column.second.data() + end_rec + 1);
-                    }
-            );
-            fn(well);
-
-            begin_rec = i;
-        }
-        end_rec = i;
-    }
-
-    return fn;
+    std::vector<double> parsed;
+    std::vector<std::size_t> errors;
+    parsed.reserve(text.size());
+    dca::parse_column(text.begin(), text.end(), std::back_inserter(parsed),
+            std::back_inserter(errors));
+    for (auto row : errors)
+        std::cerr << "Invalid number on row " << row + 2 << ": "
+            << text[row] << '\n';
+
+    if (wells.contiguous())
+        return parsed;
+
+    std::vector<double> result(parsed.size());
+    wells.gather(parsed.begin(), result.begin());
+    return result;
 }
 
-void process_well(const dataset& data)
+void process_well(const std::string& id, range oil, range gas)
 {
-    const auto& oil = data.at(params::oil_field);
-    const auto& gas = data.at(params::gas_field);
-
-    std::vector<double> oil_data(oil.size());
-    std::transform(oil.begin(), oil.end(), oil_data.begin(),
-            [](const std::string& d) {
-                return std::strtod(d.c_str(), nullptr);
-            });
-
-    std::vector<double> gas_data(gas.size());
-    std::transform(gas.begin(), gas.end(), gas_data.begin(),
-            [](const std::string& d) {
-                return std::strtod(d.c_str(), nullptr);
-            });
-
-    // strip leading zeros
-    oil_data.erase(oil_data.begin(),
-            std::find_if(oil_data.begin(), oil_data.end(),
-                [](double p) { return p > 0.0; }));
-
-    gas_data.erase(gas_data.begin(),
-            std::find_if(gas_data.begin(), gas_data.end(),
-                [](double p) { return p > 0.0; }));
-
-    auto shifted_oil = dca::shift_to_peak(oil_data.begin(), oil_data.end());
-    if (std::distance(std::get<0>(shifted_oil), oil_data.end()) < 3)
+    // trim shut-in months and shift both streams to the oil peak: a shared
+    // time origin
+    std::size_t shift;
+    auto cleaned = dca::clean_production(std::array<range, 2> { { oil, gas } },
+            dca::cleaning_options {}, &shift);
+    if (std::distance(cleaned[0].first, cleaned[0].second) < 3
+            || std::distance(cleaned[1].first, cleaned[1].second) < 3)
         return;
-    auto oil_shift = std::distance(oil_data.begin(), std::get<0>(shifted_oil));
-    auto oil_decline =
-        dca::best_from_interval_volume<dca::arps_hyperbolic>(
-            std::get<0>(shifted_oil), oil_data.end(), 0, 1.0 / 12.0);
+
+    auto declines = dca::best_from_interval_volume_joint<dca::arps_hyperbolic>(
+            cleaned, 0, 1.0 / 12.0);
+    const auto& oil_decline = declines[0];
+    const auto& gas_decline = declines[1];
 
     double t_eur;
     auto oil_eur = dca::eur(
@@ -176,20 +165,14 @@ void process_well(const dataset& data)
             &t_eur
     );
 
-    auto shifted_gas = dca::shift_to_peak(gas_data.begin(), gas_data.end());
-    auto gas_shift = std::distance(gas_data.begin(), std::get<0>(shifted_gas));
-    auto gas_decline =
-        dca::best_from_interval_volume<dca::arps_hyperbolic>(
-            std::get<0>(shifted_gas), gas_data.end(), 0, 1.0 / 12.0);
-
     auto gas_eur = dca::arps_hyperbolic_to_exponential(
             gas_decline.qi(),
             gas_decline.Di(),
             gas_decline.b(),
             params::d_final
-            ).cumulative(t_eur - (gas_shift - oil_shift));
+            ).cumulative(t_eur);
 
-    std::cout << data.at(params::id_field)[0] << '\t'
+    std::cout << id << '\t'
         << oil_eur / 1000 << '\t'
         << gas_eur / 1000 << '\t'
         << (oil_eur + gas_eur / 6) / 1000 << '\t'
@@ -197,10 +180,9 @@ void process_well(const dataset& data)
         << dca::convert_decline<dca::nominal, dca::secant_effective>(
                 oil_decline.Di(), oil_decline.b()) << '\t'
         << oil_decline.b() << '\t'
-        << oil_shift << '\t'
         << gas_decline.qi() / 365.25 << '\t'
         << dca::convert_decline<dca::nominal, dca::secant_effective>(
                 gas_decline.Di(), gas_decline.b()) << '\t'
         << gas_decline.b() << '\t'
-        << gas_shift << '\n';
+        << shift << '\n';
 }
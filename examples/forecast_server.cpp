@@ -0,0 +1,515 @@
+/*
+ * Forecast server: loads fitted declines once and answers forecast queries
+ * over a Unix-domain socket.
+ *
+ * usage:
+ *     forecast_server <declines-file> <socket-path>
+ *     forecast_server --query <socket-path> <id> <op> [args...]
+ *
+ * the declines file is tab-delimited with a header row and columns
+ *     UID  Model  qi  Di  b  Df
+ * where Model is one of exp, hyp or h2e (unused trailing columns may be
+ * blank); rates are per year and declines nominal, as in the library.
+ *
+ * protocol (native byte order: the socket is local): each request is
+ *     uint8 op, uint8 model, uint16 id_length, uint32 count,
+ *     id_length bytes of well ID, count doubles of arguments
+ * and each response is
+ *     uint8 status, 3 bytes padding, uint32 count, count doubles
+ *
+ *     op           arguments                  response
+ *     rate         t...                       q(t)...
+ *     cumulative   t...                       Np(t)...
+ *     interval     t0, dt, n                  n interval volumes
+ *     eur          economic limit, max time   EUR, time to EUR
+ *     refit        t0, dt, volumes...         fitted parameters
+ *
+ * refit fits the given interval volumes with the model named by the model
+ * byte and publishes it as the well's decline. a request over the size
+ * limits in params is answered bad request and its connection closed.
+ * connections are persistent and served concurrently, one thread each;
+ * lookups go through a decline_registry, so they never wait on a refit
+ * being published.
+ */
+
+#ifdef _WIN32
+
+#include <iostream>
+
+int main()
+{
+    std::cerr << "forecast_server requires Unix-domain sockets.\n";
+    return 1;
+}
+
+#else
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <iterator>
+#include <exception>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+#include "dca/bestfit.hpp"
+#include "dca/any_decline.hpp"
+#include "dca/registry.hpp"
+
+namespace params {
+
+static const double d_final = dca::decline<dca::tangent_effective>(0.05);
+static const std::size_t max_connections = 256;
+// refits answer with the best fit so far after this long
+static const auto refit_budget = std::chrono::milliseconds(50);
+static const std::size_t max_id_length = 1024;
+static const std::size_t max_args = 1 << 20;
+static const std::size_t max_intervals = 1 << 20; // for one interval query
+
+}
+
+enum op : std::uint8_t {
+    op_rate = 1,
+    op_cumulative = 2,
+    op_interval = 3,
+    op_eur = 4,
+    op_refit = 5
+};
+
+enum model : std::uint8_t {
+    model_exponential = 0,
+    model_hyperbolic = 1,
+    model_hyperbolic_to_exponential = 2
+};
+
+enum status : std::uint8_t {
+    status_ok = 0,
+    status_unknown_well = 1,
+    status_bad_request = 2,
+    status_error = 3
+};
+
+struct request_header {
+    std::uint8_t op;
+    std::uint8_t model;
+    std::uint16_t id_length;
+    std::uint32_t count;
+};
+
+struct response_header {
+    std::uint8_t status;
+    std::uint8_t padding[3];
+    std::uint32_t count;
+};
+
+bool load_declines(std::istream& is, dca::decline_registry& registry);
+bool read_full(int fd, void* buf, std::size_t n);
+bool write_full(int fd, const void* buf, std::size_t n);
+void serve(int client, dca::decline_registry& registry);
+int run_server(const std::string& declines_path,
+        const std::string& socket_path);
+int run_query(const std::vector<std::string>& args);
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    if (args.size() >= 5 && args[1] == "--query")
+        return run_query(args);
+
+    if (args.size() != 3) {
+        std::cerr << "Usage: "
+            << (args.empty() ? "forecast_server" : args[0])
+            << " <declines-file> <socket-path>\n"
+            << "       "
+            << (args.empty() ? "forecast_server" : args[0])
+            << " --query <socket-path> <id> "
+               "rate|cumulative|interval|eur|refit [args...]\n";
+        return 1;
+    }
+
+    return run_server(args[1], args[2]);
+}
+
+bool load_declines(std::istream& is, dca::decline_registry& registry)
+{
+    std::string line;
+    if (!std::getline(is, line)) // header
+        return false;
+
+    std::vector<std::string> ids;
+    std::vector<dca::any> declines;
+
+    while (std::getline(is, line)) {
+        std::istringstream fields(line);
+        std::string id, model;
+        double qi = 0.0, Di = 0.0, b = 0.0, Df = 0.0;
+        if (!std::getline(fields, id, '\t')
+                || !std::getline(fields, model, '\t'))
+            continue;
+        fields >> qi >> Di >> b >> Df;
+
+        try {
+            if (model == "exp")
+                declines.push_back(dca::arps_exponential(qi, Di));
+            else if (model == "hyp")
+                declines.push_back(dca::arps_hyperbolic(qi, Di, b));
+            else if (model == "h2e")
+                declines.push_back(dca::arps_hyperbolic_to_exponential(
+                            qi, Di, b, Df));
+            else {
+                std::cerr << "Unknown model for " << id << ": "
+                    << model << '\n';
+                continue;
+            }
+            ids.push_back(id);
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid decline for " << id << ": "
+                << e.what() << '\n';
+        }
+    }
+
+    // intern every ID at once: one copy of the name table, not one per well
+    std::vector<dca::decline_registry::id_type> wells;
+    wells.reserve(ids.size());
+    registry.intern(ids.begin(), ids.end(), std::back_inserter(wells));
+    for (std::size_t i = 0; i < wells.size(); ++i)
+        registry.publish(wells[i], std::move(declines[i]));
+
+    return true;
+}
+
+bool read_full(int fd, void* buf, std::size_t n)
+{
+    auto p = static_cast<char*>(buf);
+    while (n) {
+        auto got = ::read(fd, p, n);
+        if (got <= 0)
+            return false;
+        p += got;
+        n -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+bool write_full(int fd, const void* buf, std::size_t n)
+{
+    auto p = static_cast<const char*>(buf);
+    while (n) {
+        auto put = ::write(fd, p, n);
+        if (put <= 0)
+            return false;
+        p += put;
+        n -= static_cast<std::size_t>(put);
+    }
+    return true;
+}
+
+// fitted parameters, in constructor order
+std::vector<double> parameters(const dca::arps_exponential& d)
+{
+    return std::vector<double> { d.qi(), d.D() };
+}
+
+std::vector<double> parameters(const dca::arps_hyperbolic& d)
+{
+    return std::vector<double> { d.qi(), d.Di(), d.b() };
+}
+
+std::vector<double> parameters(const dca::arps_hyperbolic_to_exponential& d)
+{
+    return std::vector<double> { d.qi(), d.Di(), d.b(), d.Df() };
+}
+
+dca::fit_options refit_options()
+{
+    dca::fit_options options;
+    options.deadline = std::chrono::steady_clock::now() + params::refit_budget;
+    return options;
+}
+
+template<class Decline>
+std::vector<double> refit(const std::string& id,
+        const std::vector<double>& args, dca::decline_registry& registry)
+{
+    auto best = dca::best_from_interval_volume<Decline>(
+            args.begin() + 2, args.end(), args[0], args[1], refit_options());
+    registry.publish(id, best);
+    return parameters(best);
+}
+
+std::vector<double> refit_h2e(const std::string& id,
+        const std::vector<double>& args, dca::decline_registry& registry)
+{
+    auto hyp = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            args.begin() + 2, args.end(), args[0], args[1], refit_options());
+    dca::arps_hyperbolic_to_exponential best(hyp.qi(), hyp.Di(), hyp.b(),
+            params::d_final);
+    registry.publish(id, best);
+    return parameters(best);
+}
+
+// a whole number of intervals no more than max; checked bitwise for NaN,
+// which -ffast-math compiles comparisons against away
+bool valid_intervals(double n)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &n, sizeof(bits));
+    return ((bits >> 52) & 0x7FF) != 0x7FF && n >= 0.0
+        && n <= static_cast<double>(params::max_intervals)
+        && n == static_cast<double>(static_cast<std::size_t>(n));
+}
+
+status handle(const request_header& req, const std::string& id,
+        const std::vector<double>& args, dca::decline_registry& registry,
+        const dca::decline_registry::reader& reader,
+        std::vector<double>& result)
+{
+    result.clear();
+
+    dca::decline_registry::id_type well = 0;
+    bool known = reader.find(id, well);
+
+    switch (req.op) {
+        case op_rate:
+        case op_cumulative:
+            return known && reader.with(well, [&](const dca::any& d) {
+                    result.reserve(args.size());
+                    for (double t : args)
+                        result.push_back(req.op == op_rate
+                                ? d.rate(t) : d.cumulative(t));
+                }) ? status_ok : status_unknown_well;
+
+        case op_interval:
+            if (args.size() != 3 || !valid_intervals(args[2]))
+                return status_bad_request;
+            return known && reader.with(well, [&](const dca::any& d) {
+                    dca::interval_volumes(d, std::back_inserter(result),
+                            args[0], args[1],
+                            static_cast<std::size_t>(args[2]));
+                }) ? status_ok : status_unknown_well;
+
+        case op_eur:
+            if (args.size() != 2)
+                return status_bad_request;
+            return known && reader.with(well, [&](const dca::any& d) {
+                    double t_eur;
+                    result.push_back(dca::eur(d, args[0], args[1], &t_eur));
+                    result.push_back(t_eur);
+                }) ? status_ok : status_unknown_well;
+
+        case op_refit:
+            if (args.size() < 5)
+                return status_bad_request;
+            switch (req.model) {
+                case model_exponential:
+                    result = refit<dca::arps_exponential>(id, args, registry);
+                    return status_ok;
+                case model_hyperbolic:
+                    result = refit<dca::arps_hyperbolic>(id, args, registry);
+                    return status_ok;
+                case model_hyperbolic_to_exponential:
+                    result = refit_h2e(id, args, registry);
+                    return status_ok;
+                default:
+                    return status_bad_request;
+            }
+
+        default:
+            return status_bad_request;
+    }
+}
+
+void serve(int client, dca::decline_registry& registry)
+{
+    std::unique_ptr<dca::decline_registry::reader> reader;
+    try {
+        reader.reset(new dca::decline_registry::reader(
+                    registry.make_reader()));
+    } catch (const std::out_of_range&) {
+        ::close(client); // too many connections
+        return;
+    }
+
+    // buffers live for the connection: no allocation per request once warm
+    std::string id;
+    std::vector<double> args, result;
+
+    request_header req;
+    while (read_full(client, &req, sizeof(req))) {
+        // refused before allocating; the body goes unread, so the
+        // connection can't continue past it
+        if (req.id_length > params::max_id_length
+                || req.count > params::max_args) {
+            response_header resp {};
+            resp.status = status_bad_request;
+            write_full(client, &resp, sizeof(resp));
+            break;
+        }
+
+        id.resize(req.id_length);
+        args.resize(req.count);
+        if ((req.id_length && !read_full(client, &id[0], req.id_length))
+                || (req.count && !read_full(client, args.data(),
+                        req.count * sizeof(double))))
+            break;
+
+        status st;
+        try {
+            st = handle(req, id, args, registry, *reader, result);
+        } catch (...) {
+            st = status_error;
+        }
+        if (st != status_ok)
+            result.clear();
+
+        response_header resp {};
+        resp.status = st;
+        resp.count = static_cast<std::uint32_t>(result.size());
+        if (!write_full(client, &resp, sizeof(resp))
+                || !write_full(client, result.data(),
+                    result.size() * sizeof(double)))
+            break;
+    }
+
+    ::close(client);
+}
+
+sockaddr_un socket_address(const std::string& path)
+{
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+int run_server(const std::string& declines_path,
+        const std::string& socket_path)
+{
+    dca::decline_registry registry(params::max_connections);
+    std::ifstream in { declines_path };
+    if (!in || !load_declines(in, registry)) {
+        std::cerr << "Unable to read from " << declines_path << '\n';
+        return 1;
+    }
+    std::cerr << "Loaded " << registry.size() << " declines\n";
+
+    ::signal(SIGPIPE, SIG_IGN);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    auto addr = socket_address(socket_path);
+    ::unlink(socket_path.c_str());
+    if (listener < 0
+            || ::bind(listener, reinterpret_cast<sockaddr*>(&addr),
+                sizeof(addr)) < 0
+            || ::listen(listener, SOMAXCONN) < 0) {
+        std::cerr << "Unable to listen on " << socket_path << ": "
+            << std::strerror(errno) << '\n';
+        return 1;
+    }
+
+    while (true) {
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "accept: " << std::strerror(errno) << '\n';
+            break;
+        }
+        std::thread(serve, client, std::ref(registry)).detach();
+    }
+
+    ::close(listener);
+    return 1;
+}
+
+int run_query(const std::vector<std::string>& args)
+{
+    static const std::unordered_map<std::string, op> ops {
+        { "rate", op_rate },
+        { "cumulative", op_cumulative },
+        { "interval", op_interval },
+        { "eur", op_eur },
+        { "refit", op_refit }
+    };
+
+    auto found = ops.find(args[4]);
+    if (found == ops.end()) {
+        std::cerr << "Unknown query " << args[4] << '\n';
+        return 1;
+    }
+
+    const std::string& id = args[3];
+    std::vector<double> values;
+    std::uint8_t model = model_hyperbolic;
+    for (std::size_t i = 5; i < args.size(); ++i) {
+        if (found->second == op_refit && i == 5 && (args[i] == "exp"
+                    || args[i] == "hyp" || args[i] == "h2e")) {
+            model = args[i] == "exp" ? model_exponential
+                : args[i] == "hyp" ? model_hyperbolic
+                : model_hyperbolic_to_exponential;
+            continue;
+        }
+        values.push_back(std::strtod(args[i].c_str(), nullptr));
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    auto addr = socket_address(args[2]);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                sizeof(addr)) < 0) {
+        std::cerr << "Unable to connect to " << args[2] << ": "
+            << std::strerror(errno) << '\n';
+        return 1;
+    }
+
+    request_header req { found->second, model,
+        static_cast<std::uint16_t>(id.size()),
+        static_cast<std::uint32_t>(values.size()) };
+    response_header resp;
+    std::vector<double> result;
+    if (!write_full(fd, &req, sizeof(req))
+            || !write_full(fd, id.data(), id.size())
+            || !write_full(fd, values.data(), values.size() * sizeof(double))
+            || !read_full(fd, &resp, sizeof(resp))) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    result.resize(resp.count);
+    if (!read_full(fd, result.data(), result.size() * sizeof(double))) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    ::close(fd);
+
+    if (resp.status != status_ok) {
+        std::cerr << (resp.status == status_unknown_well ? "Unknown well"
+                : resp.status == status_bad_request ? "Bad request"
+                : "Error") << '\n';
+        return 1;
+    }
+
+    for (double r : result)
+        std::cout << r << '\n';
+    return 0;
+}
+
+#endif
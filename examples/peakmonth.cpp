@@ -6,14 +6,13 @@
 #include <unordered_map>
 #include <cstddef>
 #include <algorithm>
-#include <cstdlib>
-#include <functional>
 
 #include "dca/decline.hpp"
 #include "dca/exponential.hpp"
 #include "dca/hyperbolic.hpp"
 #include "dca/hyptoexp.hpp"
 #include "dca/bestfit.hpp"
+#include "dca/parse.hpp"
 #include "dca/production.hpp"
 
 namespace params {
@@ -31,9 +30,8 @@ using dataset = std::unordered_map<std::string, std::vector<std::string>>;
 
 dataset read_delimited(std::istream& is, char delim = '\t');
 
-template<class F>
-F foreach_well(const dataset& data, F fn,
-        std::string id_field = params::id_field);
+std::vector<double> numeric_column(const std::vector<std::string>& text,
+        const dca::well_index& wells);
 
 template<class I, class T, class F>
 void for_delimited(I begin, I end, T delim, F fn)
@@ -50,8 +48,6 @@ void for_delimited(I begin, I end, T delim, F fn)
 
 int main(int argc, char* argv[])
 {
-    using namespace std::placeholders;
-
     std::vector<std::string> args(argv, argv + argc);
     dataset data;
 
@@ -71,28 +67,28 @@ int main(int argc, char* argv[])
 
     std::cout << "API\tName\tPeak Oil Month\t"
         "Peak Month Oil (bbl)\tPeak Oil Month Gas (mcf)\n";
-    foreach_well(data, [&](const dataset& well) {
-        auto&& oil_text = well.at(params::oil_field);
-        std::vector<double> oil (oil_text.size());
-        std::transform(oil_text.begin(), oil_text.end(), oil.begin(),
-            [](const std::string& s) { return std::strtod(s.c_str(), nullptr); }
-        );
-
-        auto&& gas_text = well.at(params::gas_field);
-        std::vector<double> gas (gas_text.size());
-        std::transform(gas_text.begin(), gas_text.end(), gas.begin(),
-            [](const std::string& s) { return std::strtod(s.c_str(), nullptr); }
-        );
-
-        auto peak = dca::shift_to_peak(oil.begin(), oil.end(), gas.begin());
-
-        std::cout << well.at(params::api_field)[0] << '\t'
-          << well.at(params::name_field)[0] << '\t'
-          << well.at(params::month_field)[
-               std::distance(oil.begin(), std::get<0>(peak))]
+    const auto& ids = data.at(params::id_field);
+    dca::well_index wells(ids.begin(), ids.end());
+    auto oil = numeric_column(data.at(params::oil_field), wells);
+    auto gas = numeric_column(data.at(params::gas_field), wells);
+    const auto& api = data.at(params::api_field);
+    const auto& name = data.at(params::name_field);
+    const auto& month = data.at(params::month_field);
+
+    for (std::size_t w = 0; w < wells.size(); ++w) {
+        auto well_oil = wells.rows_of(w, oil.cbegin());
+        auto well_gas = wells.rows_of(w, gas.cbegin());
+        auto peak = dca::shift_to_peak(well_oil.first, well_oil.second,
+                well_gas.first);
+        auto peak_row = wells.row(w, static_cast<std::size_t>(
+                    std::distance(well_oil.first, std::get<0>(peak))));
+
+        std::cout << api[wells.row(w)] << '\t'
+          << name[wells.row(w)] << '\t'
+          << month[peak_row]
           << '\t' << *std::get<0>(peak) << '\t'
           << *std::get<1>(peak) << '\n';
-    });
+    }
 }
 
 dataset read_delimited(std::istream& is, char delim)
@@ -122,33 +118,22 @@ dataset read_delimited(std::istream& is, char delim)
     return result;
 }
 
-template<class F>
-F foreach_well(const dataset& data, F fn, std::string id_field)
+std::vector<double> numeric_column(const std::vector<std::string>& text,
+        const dca::well_index& wells)
 {
-    const auto& id = data.at(id_field);
-
-    std::size_t begin_rec = 0, end_rec = 0;
-    for (std::size_t i = 0; i < id.size(); ++i) {
-        if (id[i] != id[begin_rec] || i == id.size() - 1) {
-            if (i == id.size() - 1)
-                end_rec = i;
-
-            dataset well;
-            std::for_each(data.begin(), data.end(),
-                    [&](const std::pair<std::string,
-                        std::vector<std::string>>& column)
-                    {
-                        well[column.first] = std::vector<std::string>(
-                            column.second.data() + begin_rec,
-                            column.second.data() + end_rec + 1);
-                    }
-            );
-            fn(well);
-
-            begin_rec = i;
-        }
-        end_rec = i;
-    }
-
-    return fn;
+    std::vector<double> parsed;
+    std::vector<std::size_t> errors;
+    parsed.reserve(text.size());
+    dca::parse_column(text.begin(), text.end(), std::back_inserter(parsed),
+            std::back_inserter(errors));
+    for (auto row : errors)
+        std::cerr << "Invalid number on row " << row + 2 << ": "
+            << text[row] << '\n';
+
+    if (wells.contiguous())
+        return parsed;
+
+    std::vector<double> result(parsed.size());
+    wells.gather(parsed.begin(), result.begin());
+    return result;
 }
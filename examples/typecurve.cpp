@@ -2,18 +2,20 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <array>
+#include <utility>
 #include <iterator>
 #include <unordered_map>
 #include <cstddef>
 #include <algorithm>
-#include <cstdlib>
-#include <functional>
 
 #include "dca/decline.hpp"
 #include "dca/exponential.hpp"
 #include "dca/hyperbolic.hpp"
 #include "dca/hyptoexp.hpp"
 #include "dca/bestfit.hpp"
+#include "dca/forecast.hpp"
+#include "dca/parse.hpp"
 #include "dca/production.hpp"
 
 namespace params {
@@ -32,9 +34,8 @@ using dataset = std::unordered_map<std::string, std::vector<std::string>>;
 
 dataset read_delimited(std::istream& is, char delim = '\t');
 
-template<class F>
-F foreach_well(const dataset& data, F fn,
-        std::string id_field = params::id_field);
+std::vector<double> numeric_column(const std::vector<std::string>& text,
+        const dca::well_index& wells);
 
 template<class I, class T, class F>
 void for_delimited(I begin, I end, T delim, F fn)
@@ -51,8 +52,6 @@ void for_delimited(I begin, I end, T delim, F fn)
 
 int main(int argc, char* argv[])
 {
-    using namespace std::placeholders;
-
     std::vector<std::string> args(argv, argv + argc);
     dataset data;
 
@@ -70,74 +69,45 @@ int main(int argc, char* argv[])
         data = read_delimited(std::cin);
     }
 
-    std::vector<std::vector<double>> oil;
-    std::vector<std::vector<double>> gas;
-    foreach_well(data, [&](const dataset& well) {
-        auto&& oil_text = well.at(params::oil_field);
-        oil.emplace_back(oil_text.size());
-        std::transform(oil_text.begin(), oil_text.end(), oil.back().begin(),
-            [](const std::string& s) { return std::strtod(s.c_str(), nullptr); }
-        );
-
-        auto&& gas_text = well.at(params::gas_field);
-        gas.emplace_back(gas_text.size());
-        std::transform(gas_text.begin(), gas_text.end(), gas.back().begin(),
-            [](const std::string& s) { return std::strtod(s.c_str(), nullptr); }
-        );
-    });
-
-    std::vector<std::pair<
-        std::vector<double>::iterator,
-        std::vector<double>::iterator>> oil_ranges;
-    double oil_avg_shift = 0.0;
-    for (auto& oil_rec : oil) {
-        oil_rec.erase(std::find_if(oil_rec.rbegin(), oil_rec.rend(),
-                    std::bind(std::not_equal_to<double> {}, 0.0, _1)).base(),
-                oil_rec.end());
-        oil_ranges.emplace_back(
-                std::get<0>(dca::shift_to_peak(oil_rec.begin(), oil_rec.end())),
-                oil_rec.end());
-        oil_avg_shift += std::distance(oil_rec.begin(),
-                oil_ranges.back().first);
-    }
-    oil_avg_shift /= oil_ranges.size();
-
-    std::vector<std::pair<
-        std::vector<double>::iterator,
-        std::vector<double>::iterator>> gas_ranges;
-    double gas_avg_shift = 0.0;
-    for (auto& gas_rec : gas) {
-        gas_rec.erase(std::find_if(gas_rec.rbegin(), gas_rec.rend(),
-                    std::bind(std::not_equal_to<double> {}, 0.0, _1)).base(),
-                gas_rec.end());
-        gas_ranges.emplace_back(
-                std::get<0>(dca::shift_to_peak(gas_rec.begin(), gas_rec.end())),
-                gas_rec.end());
-        gas_avg_shift += std::distance(gas_rec.begin(),
-                gas_ranges.back().first);
+    const auto& ids = data.at(params::id_field);
+    dca::well_index wells(ids.begin(), ids.end());
+    auto oil = numeric_column(data.at(params::oil_field), wells);
+    auto gas = numeric_column(data.at(params::gas_field), wells);
+
+    // trim shut-in months, then shift each well's oil and gas to its oil
+    // peak: both type wells share a time origin
+    using range = std::pair<
+        std::vector<double>::const_iterator,
+        std::vector<double>::const_iterator>;
+    std::vector<range> oil_ranges, gas_ranges;
+    double avg_shift = 0.0;
+    for (std::size_t w = 0; w < wells.size(); ++w) {
+        std::size_t shift;
+        auto cleaned = dca::clean_production(std::array<range, 2> { {
+                    wells.rows_of(w, oil.cbegin()),
+                    wells.rows_of(w, gas.cbegin())
+                } }, dca::cleaning_options {}, &shift);
+        oil_ranges.push_back(cleaned[0]);
+        gas_ranges.push_back(cleaned[1]);
+        avg_shift += shift;
     }
-    gas_avg_shift /= gas_ranges.size();
+    avg_shift /= oil_ranges.size();
 
     std::vector<double> oil_tw, gas_tw;
-    dca::aggregate_production(oil_ranges.begin(), oil_ranges.end(),
+    dca::parallel_aggregate_production(oil_ranges.begin(), oil_ranges.end(),
             std::back_inserter(oil_tw), std::floor(oil_ranges.size() / 3),
             params::aggregation);
-    dca::aggregate_production(gas_ranges.begin(), gas_ranges.end(),
+    dca::parallel_aggregate_production(gas_ranges.begin(), gas_ranges.end(),
             std::back_inserter(gas_tw), std::floor(gas_ranges.size() / 3),
             params::aggregation);
 
-    auto oil_tc = dca::best_from_interval_volume<dca::arps_hyperbolic>(
-            oil_tw.begin(), oil_tw.end(), 0, 1.0 / 12.0);
-    auto gas_tc = dca::best_from_interval_volume<dca::arps_hyperbolic>(
-            gas_tw.begin(), gas_tw.end(), 0, 1.0 / 12.0);
-
-    std::vector<double> oil_forecast;
-    dca::interval_volumes(oil_tc, std::back_inserter(oil_forecast),
-            0.0, 1.0 / 12, oil_tw.size());
-
-    std::vector<double> gas_forecast;
-    dca::interval_volumes(gas_tc, std::back_inserter(gas_forecast),
-            0.0, 1.0 / 12, gas_tw.size());
+    auto tcs = dca::best_from_interval_volume_joint<dca::arps_hyperbolic>(
+            std::array<range, 2> { {
+                { oil_tw.begin(), oil_tw.end() },
+                { gas_tw.begin(), gas_tw.end() }
+            } }, 0, 1.0 / 12.0);
+    const auto& oil_tc = tcs[0];
+    const auto& gas_tc = tcs[1];
 
     double t_eur;
     double oil_eur = dca::eur(
@@ -157,22 +127,25 @@ int main(int argc, char* argv[])
             gas_tc.Di(),
             gas_tc.b(),
             params::d_final
-    ).cumulative(t_eur - (gas_avg_shift - oil_avg_shift));
+    ).cumulative(t_eur);
 
-    std::cout << "Oil Avg. Shift: " << oil_avg_shift << " months\n";
+    std::cout << "Avg. Shift: " << avg_shift << " months\n";
     std::cout << "Oil Type Well:\nMonth\tVolume (bbl)\tForecast (bbl)" << '\n';
-    for (std::size_t i = 0; i < oil_tw.size(); ++i)
-        std::cout << i << '\t' <<  oil_tw[i] << '\t' << oil_forecast[i] << '\n';
+    for (const auto& step : dca::forecast(oil_tc, 0.0, 1.0 / 12,
+                oil_tw.size()))
+        std::cout << step.index << '\t' << oil_tw[step.index] << '\t'
+            << step.volume << '\n';
     std::cout << "Oil TC: (qi = " << oil_tc.qi() / 365.25 << " bbl/d, Di = "
         << dca::convert_decline<dca::nominal, dca::secant_effective>(
                 oil_tc.Di(), oil_tc.b()) * 100 << " sec. %/yr, b = "
         << oil_tc.b() << ")\n";
     std::cout << "Oil EUR: " << oil_eur / 1000 << " Mbbl\n";
 
-    std::cout << "Gas Avg. Shift: " << gas_avg_shift << " months\n";
     std::cout << "Gas Type Well:\nMonth\tVolume (mcf)\tForecast (mcf)" << '\n';
-    for (std::size_t i = 0; i < gas_tw.size(); ++i)
-        std::cout << i << '\t' <<  gas_tw[i] << '\t' << gas_forecast[i] << '\n';
+    for (const auto& step : dca::forecast(gas_tc, 0.0, 1.0 / 12,
+                gas_tw.size()))
+        std::cout << step.index << '\t' << gas_tw[step.index] << '\t'
+            << step.volume << '\n';
     std::cout << "Gas TC: (qi = " << gas_tc.qi() / 365.25 << " mcf/d, Di = "
         << dca::convert_decline<dca::nominal, dca::secant_effective>(
                 gas_tc.Di(), gas_tc.b()) * 100 << " sec. %/yr, b = "
@@ -209,33 +182,22 @@ dataset read_delimited(std::istream& is, char delim)
     return result;
 }
 
-template<class F>
-F foreach_well(const dataset& data, F fn, std::string id_field)
+std::vector<double> numeric_column(const std::vector<std::string>& text,
+        const dca::well_index& wells)
 {
-    const auto& id = data.at(id_field);
-
-    std::size_t begin_rec = 0, end_rec = 0;
-    for (std::size_t i = 0; i < id.size(); ++i) {
-        if (id[i] != id[begin_rec] || i == id.size() - 1) {
-            if (i == id.size() - 1)
-                end_rec = i;
-
-            dataset well;
-            std::for_each(data.begin(), data.end(),
-                    [&](const std::pair<std::string,
-                        std::vector<std::string>>& column)
-                    {
-                        well[column.first] = std::vector<std::string>(
-                            column.second.data() + begin_rec,
-                            column.second.data() + end_rec + 1);
-                    }
-            );
-            fn(well);
-
-            begin_rec = i;
-        }
-        end_rec = i;
-    }
-
-    return fn;
+    std::vector<double> parsed;
+    std::vector<std::size_t> errors;
+    parsed.reserve(text.size());
+    dca::parse_column(text.begin(), text.end(), std::back_inserter(parsed),
+            std::back_inserter(errors));
+    for (auto row : errors)
+        std::cerr << "Invalid number on row " << row + 2 << ": "
+            << text[row] << '\n';
+
+    if (wells.contiguous())
+        return parsed;
+
+    std::vector<double> result(parsed.size());
+    wells.gather(parsed.begin(), result.begin());
+    return result;
 }
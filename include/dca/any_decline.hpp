@@ -1,6 +1,9 @@
 #ifndef ANY_DECLINE_HPP
 #define ANY_DECLINE_HPP
 
+#include "codec.hpp"
+
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -42,6 +45,10 @@ class any {
         double rate(double time) const;
         double cumulative(double time) const;
 
+        // the held decline's binary encoding (see codec.hpp)
+        decline_tag tag() const noexcept;
+        std::size_t encode(double* params) const noexcept;
+
 #ifndef DCA_NO_IOSTREAMS
         friend std::ostream& operator<<(std::ostream& os, const any& d);
 #endif
@@ -59,6 +66,9 @@ class any {
             virtual double rate(double time) const = 0;
             virtual double cumulative(double time) const = 0;
 
+            virtual decline_tag tag() const noexcept = 0;
+            virtual std::size_t encode(double* params) const noexcept = 0;
+
 #ifndef DCA_NO_IOSTREAMS
             virtual std::ostream& stream_to(std::ostream& os) const = 0;
 #endif
@@ -95,6 +105,16 @@ class any {
                 return d_.cumulative(time);
             }
 
+            decline_tag tag() const noexcept override
+            {
+                return decline_codec<Decline>::tag(d_);
+            }
+
+            std::size_t encode(double* params) const noexcept override
+            {
+                return decline_codec<Decline>::encode(d_, params);
+            }
+
 #ifndef DCA_NO_IOSTREAMS
             std::ostream& stream_to(std::ostream& os) const override
             {
@@ -150,6 +170,16 @@ inline double any::cumulative(double time) const
     return impl_->cumulative(time);
 }
 
+inline decline_tag any::tag() const noexcept
+{
+    return impl_->tag();
+}
+
+inline std::size_t any::encode(double* params) const noexcept
+{
+    return impl_->encode(params);
+}
+
 #ifdef __GNUC__
 #ifdef __GXX_RTTI
 inline const std::type_info& any::type() const
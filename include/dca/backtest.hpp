@@ -0,0 +1,178 @@
+#ifndef BACKTEST_HPP
+#define BACKTEST_HPP
+
+#include "decline.hpp"
+#include "diagnostics.hpp"
+#include "parallel.hpp"
+
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace dca {
+
+// how each refit of a backtest starts
+enum class backtest_start {
+    cold, // from the usual seed, by the solver in options
+    warm // by BFGS from the previous refit; the first as for cold
+};
+
+struct backtest_options {
+    std::size_t min_history = 3; // steps in the first refit
+    backtest_start start = backtest_start::warm;
+    double economic_limit = 0.0; // for EUR, as a rate
+    double max_time = 30.0; // for EUR, from the start of the well
+    fit_options fit;
+    // warm refits start at a minimum of nearly the same data, so stop
+    // sooner than fit.term_iter (which suits Nelder-Mead) would
+    int warm_term_iter = 2;
+    unsigned threads = 0; // 0: one per hardware thread
+};
+
+// one refit, on a well's first `history` steps, scored on the rest
+struct backtest_step {
+    std::size_t history;
+    fit_status status;
+    double holdout_mape; // percent, over the nonzero held-out volumes
+    double holdout_error; // (forecast - actual) / actual, held-out total
+    double eur;
+    double eur_drift; // relative to the previous refit's; 0 for the first
+};
+
+// accuracy over every refit of a backtest, e.g. of one model and start
+struct backtest_summary {
+    std::size_t wells;
+    std::size_t refits;
+    double holdout_mape; // mean of the refits'
+    double holdout_bias; // mean holdout_error
+    double holdout_abs_error; // mean |holdout_error|
+    double eur_drift; // mean |eur_drift|, over all but each well's first
+};
+
+namespace detail {
+
+// score a fit on the volumes [vol_begin + history, vol_end)
+template<class Decline, class VolIter>
+inline void score_holdout(const Decline& decl, VolIter vol_begin,
+        VolIter vol_end, std::size_t history, double time_initial,
+        double time_step, backtest_step& step)
+{
+    double t = time_initial + history * time_step;
+    double last_cum = decl.cumulative(t);
+    double abs_pct = 0.0, actual = 0.0, forecast = 0.0;
+    std::size_t nonzero = 0;
+    for (auto vol = std::next(vol_begin, history); vol != vol_end; ++vol) {
+        t += time_step;
+        double cum = decl.cumulative(t);
+        double interval = cum - last_cum;
+        last_cum = cum;
+        if (*vol != 0.0) {
+            abs_pct += std::abs((interval - *vol) / *vol);
+            ++nonzero;
+        }
+        actual += *vol;
+        forecast += interval;
+    }
+    step.holdout_mape = nonzero ? 100.0 * abs_pct / nonzero : 0.0;
+    step.holdout_error = actual != 0.0 ? (forecast - actual) / actual : 0.0;
+}
+
+}
+
+/*
+ * hindcast each well: refit on its first k interval volumes, for k from
+ * options.min_history to one short of its length, scoring each fit on the
+ * volumes it didn't see and tracking its EUR as k grows. wells is a
+ * container of (begin, end) volume ranges on the same time grid (as for
+ * best_from_interval_volume_batch); each well's refits run in order, so
+ * that warm starts can chain, and wells run on up to options.threads
+ * threads. returns each well's refits in well order; wells too short for
+ * a holdout have none.
+ */
+template<class Decline, class Wells>
+inline std::vector<std::vector<backtest_step>> backtest_interval_volume(
+        const Wells& wells, double time_initial, double time_step,
+        const backtest_options& options = backtest_options {})
+{
+    using std::begin;
+    using std::end;
+    using range = std::decay_t<decltype(*begin(wells))>;
+    using params = typename detail::decline_traits<Decline>::params;
+
+    std::vector<range> ranges(begin(wells), end(wells));
+    std::vector<std::vector<backtest_step>> result(ranges.size());
+    const std::size_t first = std::max<std::size_t>(options.min_history, 1);
+
+    fit_options warm_options = options.fit;
+    warm_options.term_iter = options.warm_term_iter;
+
+    parallel_for(ranges.size(), [&](std::size_t w) {
+        auto vol_begin = ranges[w].first, vol_end = ranges[w].second;
+        const auto length =
+            static_cast<std::size_t>(std::distance(vol_begin, vol_end));
+
+        params last;
+        double last_eur = 0.0;
+        for (std::size_t k = first; k < length; ++k) {
+            auto history_end = std::next(vol_begin, k);
+            auto fit = options.start == backtest_start::warm && k > first
+                ? fit_from_interval_volume_bfgs<Decline>(vol_begin,
+                        history_end, time_initial, time_step, last,
+                        warm_options)
+                : fit_from_interval_volume<Decline>(vol_begin, history_end,
+                        time_initial, time_step, options.fit);
+            last = fit.params;
+
+            backtest_step step;
+            step.history = k;
+            step.status = fit.status;
+            detail::score_holdout(fit.decline, vol_begin, vol_end, k,
+                    time_initial, time_step, step);
+            step.eur = eur(fit.decline, options.economic_limit,
+                    options.max_time);
+            step.eur_drift = k > first && last_eur != 0.0
+                ? (step.eur - last_eur) / last_eur : 0.0;
+            last_eur = step.eur;
+            result[w].push_back(step);
+        }
+    }, options.threads);
+
+    return result;
+}
+
+inline backtest_summary summarize_backtest(
+        const std::vector<std::vector<backtest_step>>& wells)
+{
+    backtest_summary s {};
+    std::size_t drifts = 0;
+    for (const auto& steps : wells) {
+        if (steps.empty())
+            continue;
+        ++s.wells;
+        for (std::size_t i = 0; i < steps.size(); ++i) {
+            ++s.refits;
+            s.holdout_mape += steps[i].holdout_mape;
+            s.holdout_bias += steps[i].holdout_error;
+            s.holdout_abs_error += std::abs(steps[i].holdout_error);
+            if (i > 0) {
+                ++drifts;
+                s.eur_drift += std::abs(steps[i].eur_drift);
+            }
+        }
+    }
+    if (s.refits) {
+        s.holdout_mape /= s.refits;
+        s.holdout_bias /= s.refits;
+        s.holdout_abs_error /= s.refits;
+    }
+    if (drifts)
+        s.eur_drift /= drifts;
+    return s;
+}
+
+}
+
+#endif
@@ -1,192 +1,1147 @@
 #ifndef BESTFIT_HPP
 #define BESTFIT_HPP
 
+#include "decline.hpp"
 #include "exponential.hpp"
 #include "hyperbolic.hpp"
 #include "hyptoexp.hpp"
+#include "stretched.hpp"
+#include "duong.hpp"
 
 #include "convex.hpp"
+#include "dual.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
+#include "seed.hpp"
 #include "tuple_tools.hpp"
 
 #include <tuple>
+#include <array>
+#include <iterator>
+#include <type_traits>
 #include <numeric>
 #include <algorithm>
 #include <functional>
 #include <cmath>
+#include <chrono>
+#include <cstddef>
 #include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace dca {
 
+enum class fit_solver {
+    nelder_mead, // from the inner simplex of the parameter bounds guess
+    bfgs, // from that simplex's best vertex
+    differential_evolution // within the parameter bounds guess, polished
+};
+
+// how a fit ended: on the solver's own terms, or out of budget
+enum class fit_status { complete, evaluation_limit, deadline };
+
+struct fit_options {
+    fit_solver solver = fit_solver::nelder_mead;
+    int max_iter = 300; // iterations, or generations for evolution
+    std::size_t max_evaluations = 0; // of the objective; 0: no limit
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::time_point::max();
+    double term_eps = std::sqrt(std::numeric_limits<double>::epsilon());
+    int term_iter = 10;
+
+    // Nelder-Mead steps
+    double ref_factor = 1.0;
+    double exp_factor = 2.0;
+    double con_factor = 0.5;
+    double shr_factor = 0.5;
+
+    // differential evolution
+    std::size_t population = 0;
+    double weight = 0.8;
+    double crossover = 0.9;
+    unsigned seed = 5489u;
+};
+
 namespace detail {
 
-template<class Decline, class RateIter, class TimeIter>
-inline double sse_against_rate(const Decline& decl,
-        RateIter rate_begin, RateIter rate_end, TimeIter time_begin)
+// sees each (observation, residual) of an SSE pass; this one ignores them
+struct ignore_residuals {
+    template<class Real>
+    void operator()(double, const Real&) const noexcept { }
+};
+
+template<class Decline, class RateIter, class TimeIter,
+    class Observer = ignore_residuals>
+inline auto sse_against_rate(const Decline& decl,
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin,
+        Observer observe = Observer())
 {
-    return std::inner_product(rate_begin, rate_end, time_begin, 0.0, 
-            std::plus<double>(),
+    DCA_PROFILE_COUNT(objective);
+    using real = std::decay_t<decltype(decl.rate(0.0))>;
+
+    return std::inner_product(rate_begin, rate_end, time_begin, real(0.0),
+            std::plus<real>(),
             [&](double rate, double time) {
-                return std::pow(rate - decl.rate(time), 2);
+                real resid = rate - decl.rate(time);
+                observe(rate, resid);
+                return resid * resid;
             });
 }
 
-template<class Decline, class VolIter>
-inline double sse_against_interval(const Decline& decl,
+template<class Decline, class VolIter, class Observer = ignore_residuals>
+inline auto sse_against_interval(const Decline& decl,
         VolIter vol_begin, VolIter vol_end,
-        double time_initial, double time_step)
+        double time_initial, double time_step,
+        Observer observe = Observer())
 {
+    DCA_PROFILE_COUNT(objective);
+    using real = std::decay_t<decltype(decl.cumulative(0.0))>;
+
     struct cumulator {
         const Decline& d;
-        double cum;
-        double last_cum;
+        real last_cum;
         double t;
         double step;
+        Observer& observe;
 
-        cumulator(const Decline& d, double t_init, double t_step)
-            : d(d), cum(0.0), last_cum(0.0), t(t_init), step(t_step)
+        cumulator(const Decline& d, double t_init, double t_step,
+                Observer& observe)
+            : d(d), last_cum(0.0), t(t_init), step(t_step), observe(observe)
         { }
 
-        double operator()(double sse, double vol)
+        real operator()(const real& sse, double vol)
         {
             t += step;
-            double interval = d.cumulative(t) - last_cum;
+            real interval = d.cumulative(t) - last_cum;
             last_cum += interval;
-            return sse + std::pow(vol - interval, 2);
+            real resid = vol - interval;
+            observe(vol, resid);
+            return sse + resid * resid;
         }
     };
 
-    return std::accumulate(vol_begin, vol_end, 0.0,
-            cumulator(decl, time_initial, time_step));
+    return std::accumulate(vol_begin, vol_end, real(0.0),
+            cumulator(decl, time_initial, time_step, observe));
+}
+
+// SSE and its gradient w.r.t. the parameters in one (dual-number) pass
+template<class Decline, class RateIter, class TimeIter, class... Params,
+    class Observer = ignore_residuals>
+inline double sse_gradient_against_rate(const std::tuple<Params...>& params,
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin,
+        std::array<double, sizeof...(Params)>& gradient,
+        Observer observe = Observer())
+{
+    auto sse = sse_against_rate(
+            tuple::construct<rebind_real_t<Decline, dual<sizeof...(Params)>>>(
+                seed_duals(params)),
+            rate_begin, rate_end, time_begin, observe);
+    gradient = sse.gradient();
+    return sse.value();
+}
+
+template<class Decline, class VolIter, class... Params,
+    class Observer = ignore_residuals>
+inline double sse_gradient_against_interval(
+        const std::tuple<Params...>& params,
+        VolIter vol_begin, VolIter vol_end,
+        double time_initial, double time_step,
+        std::array<double, sizeof...(Params)>& gradient,
+        Observer observe = Observer())
+{
+    auto sse = sse_against_interval(
+            tuple::construct<rebind_real_t<Decline, dual<sizeof...(Params)>>>(
+                seed_duals(params)),
+            vol_begin, vol_end, time_initial, time_step, observe);
+    gradient = sse.gradient();
+    return sse.value();
+}
+
+// best vertex of a simplex, as a starting point for single-point methods
+template<class Fn, class Simplex>
+inline typename Simplex::value_type best_vertex(Fn f, const Simplex& spx)
+{
+    std::array<double, std::tuple_size<Simplex>::value> result;
+    std::transform(spx.begin(), spx.end(), result.begin(), f);
+    return spx[static_cast<std::size_t>(std::distance(result.begin(),
+                std::min_element(result.begin(), result.end())))];
 }
 
 template<class Decline>
 struct decline_traits {
 };
 
+template<class T, std::size_t>
+struct repeat_element {
+    using type = T;
+};
+
+template<class T, class Seq>
+struct repeat_tuple_impl;
+
+template<class T, std::size_t... I>
+struct repeat_tuple_impl<T, std::index_sequence<I...>> {
+    using type = std::tuple<typename repeat_element<T, I>::type...>;
+};
+
+// std::tuple<T, T, ..., T> (N times)
+template<class T, std::size_t N>
+using repeat_tuple_t =
+    typename repeat_tuple_impl<T, std::make_index_sequence<N>>::type;
+
+/*
+ * joint parameters for several phases sharing b: each phase's parameters
+ * other than b, phase by phase, then the shared b
+ */
+template<class Decline, std::size_t Phases>
+struct shared_b_layout {
+    using params = typename decline_traits<Decline>::params;
+
+    static const std::size_t phase_length =
+        std::tuple_size<params>::value - 1;
+    static const std::size_t length = phase_length * Phases + 1;
+    static const std::size_t b_index = decline_traits<Decline>::b_index;
+
+    using joint_params = repeat_tuple_t<double, length>;
+
+    static params phase(const std::array<double, length>& joint,
+            std::size_t p) noexcept
+    {
+        std::array<double, phase_length + 1> result;
+        for (std::size_t i = 0, j = p * phase_length; i < result.size(); ++i)
+            result[i] = (i == b_index) ? joint[length - 1] : joint[j++];
+        return convex::detail::array_to_tuple<params>(result);
+    }
+
+    static joint_params join(const std::array<params, Phases>& phases)
+    {
+        std::array<double, length> result;
+        for (std::size_t p = 0; p < Phases; ++p) {
+            auto phase = convex::detail::tuple_to_array(phases[p]);
+            for (std::size_t i = 0, j = p * phase_length; i < phase.size();
+                    ++i)
+                if (i != b_index)
+                    result[j++] = phase[i];
+        }
+        // b (its seed, or its bounds) is taken from the first phase
+        result[length - 1] = std::get<b_index>(phases[0]);
+        return convex::detail::array_to_tuple<joint_params>(result);
+    }
+};
+
+// joint parameters for several independent phases, phase by phase
+template<class Decline, std::size_t Phases>
+struct separate_layout {
+    using params = typename decline_traits<Decline>::params;
+
+    static const std::size_t phase_length = std::tuple_size<params>::value;
+    static const std::size_t length = phase_length * Phases;
+
+    using joint_params = repeat_tuple_t<double, length>;
+
+    static params phase(const std::array<double, length>& joint,
+            std::size_t p) noexcept
+    {
+        std::array<double, phase_length> result;
+        std::copy_n(joint.begin() + p * phase_length, phase_length,
+                result.begin());
+        return convex::detail::array_to_tuple<params>(result);
+    }
+
+    static joint_params join(const std::array<params, Phases>& phases)
+    {
+        std::array<double, length> result;
+        for (std::size_t p = 0; p < Phases; ++p) {
+            auto phase = convex::detail::tuple_to_array(phases[p]);
+            std::copy(phase.begin(), phase.end(),
+                    result.begin() + p * phase_length);
+        }
+        return convex::detail::array_to_tuple<joint_params>(result);
+    }
+};
+
+template<class Fn, std::size_t... I>
+inline auto generate_array_impl(Fn f, std::index_sequence<I...>)
+{
+    return std::array<decltype(f(std::size_t())), sizeof...(I)> {
+        { f(I)... }
+    };
+}
+
+// { f(0), f(1), ..., f(N - 1) }, for elements without default constructors
+template<std::size_t N, class Fn>
+inline auto generate_array(Fn f)
+{
+    return generate_array_impl(f, std::make_index_sequence<N>());
+}
+
+// 1 / sum of squares, so that each phase counts equally in a joint fit
+template<class VolIter>
+inline double phase_weight(VolIter vol_begin, VolIter vol_end)
+{
+    double ss = std::inner_product(vol_begin, vol_end, vol_begin, 0.0);
+    return ss > 0.0 ? 1.0 / ss : 1.0;
+}
+
+struct fit_budget_exhausted {
+    fit_status status;
+};
+
+// counts objective evaluations against a fit's budget, keeping the best
+template<class Params>
+class fit_monitor {
+    public:
+        explicit fit_monitor(const fit_options& options)
+            : options_(options), evaluations_(0),
+              best_value_(std::numeric_limits<double>::infinity()),
+              recorded_(false) { }
+
+        // call before each evaluation, or each batch of `count` evaluations
+        // (e.g. for a finite-difference gradient); throws
+        // fit_budget_exhausted
+        void charge(std::size_t count = 1)
+        {
+            if (evaluations_ == 0) { // always allow one
+                evaluations_ += count;
+                return;
+            }
+            if (options_.max_evaluations != 0
+                    && evaluations_ + count > options_.max_evaluations)
+                throw fit_budget_exhausted { fit_status::evaluation_limit };
+            if (options_.deadline
+                    != std::chrono::steady_clock::time_point::max()
+                    && std::chrono::steady_clock::now() >= options_.deadline)
+                throw fit_budget_exhausted { fit_status::deadline };
+            evaluations_ += count;
+        }
+
+        void record(const Params& x, double value)
+        {
+            if (!recorded_ || value < best_value_) {
+                best_ = x;
+                best_value_ = value;
+                recorded_ = true;
+            }
+        }
+
+        const Params& best() const noexcept { return best_; }
+        double best_value() const noexcept { return best_value_; }
+
+    private:
+        const fit_options& options_;
+        std::size_t evaluations_;
+        Params best_;
+        double best_value_;
+        bool recorded_;
+};
+
+/*
+ * minimize sse(params) with the chosen solver, starting from seed and
+ * searching around it within bounds; sse_gradient(params, gradient) serves
+ * BFGS, and counts as gradient_cost evaluations against the budget (one
+ * for a dual-number pass, more for finite differences).
+ * when the budget runs out, the best point evaluated so far is the result.
+ */
+template<class Sse, class SseGradient, class Params>
+inline Params minimize(Sse sse, SseGradient sse_gradient, const Params& seed,
+        const std::pair<Params, Params>& bounds, const fit_options& options,
+        fit_status* status, std::size_t gradient_cost = 1)
+{
+    fit_monitor<Params> monitor(options);
+    auto objective = [&](const Params& t) {
+        monitor.charge();
+        double value = sse(t);
+        monitor.record(t, value);
+        return value;
+    };
+
+    Params best;
+    fit_status result = fit_status::complete;
+    try {
+        switch (options.solver) {
+            case fit_solver::nelder_mead:
+                best = convex::nelder_mead(objective,
+                        convex::seeded_simplex(seed, bounds), options.max_iter,
+                        options.term_eps, options.term_iter,
+                        options.ref_factor, options.exp_factor,
+                        options.con_factor, options.shr_factor);
+                break;
+
+            case fit_solver::bfgs:
+                best = convex::bfgs([&](const Params& t, auto& gradient) {
+                            monitor.charge(gradient_cost);
+                            double value = sse_gradient(t, gradient);
+                            monitor.record(t, value);
+                            return value;
+                        },
+                        best_vertex(objective,
+                            convex::seeded_simplex(seed, bounds)),
+                        options.max_iter, options.term_eps,
+                        options.term_iter);
+                break;
+
+            case fit_solver::differential_evolution:
+                best = convex::differential_evolution(objective, bounds,
+                        options.max_iter, options.population, options.weight,
+                        options.crossover, options.max_iter, 1,
+                        options.seed);
+                break;
+        }
+    } catch (const fit_budget_exhausted& e) {
+        result = e.status;
+        if (!(monitor.best_value() < std::numeric_limits<double>::infinity()))
+            throw std::out_of_range("No feasible fit within budget.");
+        best = monitor.best();
+    }
+
+    if (status)
+        *status = result;
+    return best;
+}
+
+// BFGS alone from a given point, e.g. an earlier fit
+template<class SseGradient, class Params>
+inline Params refine(SseGradient sse_gradient, const Params& initial,
+        const fit_options& options, fit_status* status)
+{
+    fit_monitor<Params> monitor(options);
+    Params best;
+    fit_status result = fit_status::complete;
+    try {
+        best = convex::bfgs([&](const Params& t, auto& gradient) {
+                    monitor.charge();
+                    double value = sse_gradient(t, gradient);
+                    monitor.record(t, value);
+                    return value;
+                }, initial, options.max_iter, options.term_eps,
+                options.term_iter);
+    } catch (const fit_budget_exhausted& e) {
+        result = e.status;
+        best = monitor.best_value()
+            < std::numeric_limits<double>::infinity()
+            ? monitor.best() : initial;
+    }
+
+    if (status)
+        *status = result;
+    return best;
+}
+
+/*
+ * each model's traits seed a fit from its data (see seed.hpp), in one or a
+ * few passes, and give a search box around the seed: the initial simplex
+ * spans part of the box, and differential evolution searches all of it.
+ */
 template<>
 struct decline_traits<arps_exponential> {
-    static convex::simplex<double, double> initial_simplex() noexcept
+    using params = std::tuple<double, double>;
+
+    template<class Samples>
+    static params seed(const Samples& samples)
     {
-        return convex::simplex<double, double> {
-            {
-                std::make_tuple(1, 0.01),
-                std::make_tuple(1e6, 0.5),
-                std::make_tuple(1e3, 10.0)
-            }
-        };
+        auto stats = gather_seed_stats(samples);
+        double D = stats.log_rate.valid()
+            ? clamp_seed(-stats.log_rate.slope(), 1e-4, 1e3) : 0.1;
+        double qi = samples.scale(arps_exponential(1.0, D));
+        return params(qi > 0.0 ? qi : stats.peak_rate, D);
     }
 
-    template<class RateIter>
-    static std::pair<std::tuple<double, double>, std::tuple<double, double>>
-    parameter_bounds_guess(RateIter rate_begin, RateIter rate_end)
+    static std::pair<params, params> bounds(const params& seed)
     {
-        double peak_rate = *std::max_element(rate_begin, rate_end);
         return std::make_pair(
-            std::make_tuple(peak_rate / 0.5, 0.0),
-            std::make_tuple(peak_rate * 2.0, 10.0)
+            params(std::get<0>(seed) * 0.5, std::get<1>(seed) * 0.2),
+            params(std::get<0>(seed) * 2.0, std::get<1>(seed) * 5.0)
         );
     }
 };
 
+/*
+ * the best of the exponential, harmonic and loss-ratio estimates of (Di, b),
+ * each with its least-squares qi, with b no less than b_min
+ */
+template<class Samples>
+inline std::tuple<double, double, double> hyperbolic_seed(
+        const Samples& samples, const seed_stats& stats, double b_min)
+{
+    std::tuple<double, double, double> best(stats.peak_rate, 0.1, b_min);
+    double best_sse = std::numeric_limits<double>::infinity();
+
+    auto consider = [&](double Di, double b) {
+        Di = clamp_seed(Di, 1e-4, 1e3);
+        b = clamp_seed(b, b_min, 3.0);
+        double qi = samples.scale(arps_hyperbolic(1.0, Di, b));
+        if (!(qi > 0.0))
+            return;
+        double sse = samples.sse(arps_hyperbolic(qi, Di, b));
+        if (sse < best_sse) {
+            best = std::make_tuple(qi, Di, b);
+            best_sse = sse;
+        }
+    };
+
+    if (stats.log_rate.valid())
+        consider(-stats.log_rate.slope(), 0.0);
+
+    const auto& inv = stats.inverse_rate;
+    if (inv.valid() && inv.intercept() > 0.0 && inv.slope() > 0.0)
+        consider(inv.slope() / inv.intercept(), 1.0);
+
+    const auto& loss = stats.loss_ratio;
+    if (loss.valid() && loss.intercept() > 0.0)
+        consider(1.0 / loss.intercept(), loss.slope());
+
+    return best;
+}
+
 template<>
 struct decline_traits<arps_hyperbolic> {
-    static convex::simplex<double, double, double> initial_simplex() noexcept
-    {
-        return convex::simplex<double, double, double> {
-            {
-                std::make_tuple(1, 0.01, 0.0),
-                std::make_tuple(1e6, 1.0, 0.0),
-                std::make_tuple(1e5, 10.0, 0.0),
-                std::make_tuple(1e4, 5.0, 3.0)
-            }
-        };
+    using params = std::tuple<double, double, double>;
+    static const std::size_t b_index = 2;
+
+    template<class Samples>
+    static params seed(const Samples& samples)
+    {
+        return hyperbolic_seed(samples, gather_seed_stats(samples), 0.0);
     }
 
-    template<class RateIter>
-    static std::pair<std::tuple<double, double, double>,
-        std::tuple<double, double, double>>
-    parameter_bounds_guess(RateIter rate_begin, RateIter rate_end)
+    static std::pair<params, params> bounds(const params& seed)
     {
-        double peak_rate = *std::max_element(rate_begin, rate_end);
+        double b = std::get<2>(seed);
         return std::make_pair(
-            std::make_tuple(peak_rate / 0.5, 0.0, 0.0),
-            std::make_tuple(peak_rate * 2.0, 10.0, 3.0)
+            params(std::get<0>(seed) * 0.5, std::get<1>(seed) * 0.2,
+                std::max(b - 1.0, 0.0)),
+            params(std::get<0>(seed) * 2.0, std::get<1>(seed) * 5.0,
+                std::min(b + 1.0, 5.0))
         );
     }
+
+    // for batch fits: lane w's cumulative, branch-free, and whether the
+    // constructor would accept its parameters
+    static double batch_cumulative(const std::array<const double*, 3>& x,
+            std::size_t w, double time) noexcept
+    {
+        return hyperbolic_cumulative(x[0][w], x[1][w], x[2][w], time);
+    }
+
+    static bool batch_feasible(const std::array<const double*, 3>& x,
+            std::size_t w) noexcept
+    {
+        return x[0][w] >= 0.0 && x[1][w] >= 0.0
+            && x[2][w] >= 0.0 && x[2][w] <= 5.0;
+    }
 };
 
 template<>
 struct decline_traits<arps_hyperbolic_to_exponential> {
-    static convex::simplex<double, double, double, double> initial_simplex()
-      noexcept
-    {
-        return convex::simplex<double, double, double, double> {
-            {
-                std::make_tuple(1, 0.01, 0.1, 0.05),
-                std::make_tuple(1e4, 5.0, 5.0, 0.05),
-                std::make_tuple(5e2, 2.3, 2.0, 0.15),
-                std::make_tuple(1e3, 1.5, 1.5, 0.10),
-                std::make_tuple(50, 1.0, 0.75, 0.05)
-            }
-        };
+    using params = std::tuple<double, double, double, double>;
+    static const std::size_t b_index = 2;
+
+    // Df from the decline reached by the end of the data
+    template<class Samples>
+    static params seed(const Samples& samples)
+    {
+        auto stats = gather_seed_stats(samples);
+        auto hyp = hyperbolic_seed(samples, stats, 0.05);
+        double Di = std::get<1>(hyp), b = std::get<2>(hyp);
+        double Df = clamp_seed(Di / (1.0 + b * Di * stats.time_last),
+                1e-4, 0.5 * Di);
+        double qi = samples.scale(
+                arps_hyperbolic_to_exponential(1.0, Di, b, Df));
+        return params(qi > 0.0 ? qi : std::get<0>(hyp), Di, b, Df);
     }
 
-    template<class RateIter>
-    static std::pair<std::tuple<double, double, double, double>,
-        std::tuple<double, double, double, double>>
-    parameter_bounds_guess(RateIter rate_begin, RateIter rate_end)
+    static std::pair<params, params> bounds(const params& seed)
     {
-        double peak_rate = *std::max_element(rate_begin, rate_end);
+        double b = std::get<2>(seed);
         return std::make_pair(
-            std::make_tuple(peak_rate / 0.5, 0.0, 0.0, 0.0),
-            std::make_tuple(peak_rate * 2.0, 10.0, 3.0, 10.0)
+            params(std::get<0>(seed) * 0.5, std::get<1>(seed) * 0.2,
+                std::max(b - 1.0, 0.05), std::get<3>(seed) * 0.2),
+            params(std::get<0>(seed) * 2.0, std::get<1>(seed) * 5.0,
+                std::min(b + 1.0, 5.0), std::get<3>(seed) * 5.0)
         );
     }
 };
 
+template<>
+struct decline_traits<stretched_exponential> {
+    using params = std::tuple<double, double, double>;
+
+    // n and tau from the power-law decline, ln D against ln t
+    template<class Samples>
+    static params seed(const Samples& samples)
+    {
+        auto stats = gather_seed_stats(samples);
+        double n = 0.5, tau = 1.0;
+        const auto& loss = stats.log_loss;
+        if (loss.valid()) {
+            n = clamp_seed(1.0 + loss.slope(), 0.05, 1.0);
+            tau = clamp_seed(std::exp((std::log(n) - loss.intercept()) / n),
+                    1e-4, 1e4);
+        }
+        double qi = samples.scale(stretched_exponential(1.0, tau, n));
+        return params(qi > 0.0 ? qi : stats.peak_rate, tau, n);
+    }
+
+    static std::pair<params, params> bounds(const params& seed)
+    {
+        double n = std::get<2>(seed);
+        return std::make_pair(
+            params(std::get<0>(seed) * 0.5, std::get<1>(seed) * 0.2,
+                std::max(n - 0.3, 0.05)),
+            params(std::get<0>(seed) * 2.0, std::get<1>(seed) * 5.0,
+                std::min(n + 0.3, 1.0))
+        );
+    }
+};
+
+template<>
+struct decline_traits<duong> {
+    using params = std::tuple<double, double, double>;
+
+    // a and m from the log-log line of q / Np against t
+    template<class Samples>
+    static params seed(const Samples& samples)
+    {
+        auto stats = gather_seed_stats(samples);
+        double a = 1.0, m = 1.2;
+        const auto& ratio = stats.log_rate_cumulative;
+        if (ratio.valid()) {
+            a = clamp_seed(std::exp(ratio.intercept()), 1e-3, 1e2);
+            m = clamp_seed(-ratio.slope(), 0.0, 3.0);
+        }
+        double q1 = samples.scale(duong(1.0, a, m));
+        return params(q1 > 0.0 ? q1 : stats.peak_rate, a, m);
+    }
+
+    static std::pair<params, params> bounds(const params& seed)
+    {
+        double m = std::get<2>(seed);
+        return std::make_pair(
+            params(std::get<0>(seed) * 0.5, std::get<1>(seed) * 0.2,
+                std::max(m - 0.5, 0.0)),
+            params(std::get<0>(seed) * 2.0, std::get<1>(seed) * 5.0,
+                std::min(m + 0.5, 3.0))
+        );
+    }
+};
+
+// whether a model's traits give branch-free batch_cumulative and
+// batch_feasible, for sse_against_interval_lanes
+template<class Traits, class = void>
+struct has_batch_kernel : std::false_type { };
+
+template<class Traits>
+struct has_batch_kernel<Traits,
+    decltype((void)&Traits::batch_cumulative)> : std::true_type { };
+
+/*
+ * a group of wells' volumes, step-major and zero-padded to the longest well,
+ * so that batch kernels can run across lanes one step at a time
+ */
+class interval_lanes {
+    public:
+        template<class Range>
+        interval_lanes(const Range* wells, std::size_t count)
+            : count_(count), steps_(0), length_(count)
+        {
+            for (std::size_t w = 0; w < count; ++w) {
+                length_[w] = static_cast<std::size_t>(
+                        std::distance(wells[w].first, wells[w].second));
+                steps_ = std::max(steps_, length_[w]);
+            }
+            volume_.assign(steps_ * count, 0.0);
+            for (std::size_t w = 0; w < count; ++w) {
+                auto vol = wells[w].first;
+                for (std::size_t k = 0; k < length_[w]; ++k, ++vol)
+                    volume_[k * count + w] = *vol;
+            }
+        }
+
+        std::size_t steps() const noexcept { return steps_; }
+        std::size_t length(std::size_t w) const noexcept { return length_[w]; }
+
+        // the volumes of step k, one per lane
+        const double* step(std::size_t k) const noexcept
+        {
+            return volume_.data() + k * count_;
+        }
+
+    private:
+        std::size_t count_, steps_;
+        std::vector<std::size_t> length_;
+        std::vector<double> volume_;
+};
+
+/*
+ * sse_against_interval for each active lane, as the same sums in the same
+ * order: all lanes step by step, with no branches in the inner loop (lanes
+ * past the end of their wells add nothing)
+ */
+template<class Traits, std::size_t N>
+inline void sse_against_interval_lanes(const std::array<const double*, N>& x,
+        const char* active, std::size_t size, double* values,
+        const interval_lanes& wells, double time_initial, double time_step)
+{
+    std::vector<double> last(size, 0.0), sse(size, 0.0);
+    double t = time_initial;
+    for (std::size_t k = 0; k < wells.steps(); ++k) {
+        t += time_step;
+        const double* vol = wells.step(k);
+        for (std::size_t w = 0; w < size; ++w) {
+            double interval = Traits::batch_cumulative(x, w, t) - last[w];
+            last[w] += interval;
+            double resid = vol[w] - interval;
+            sse[w] += k < wells.length(w) ? resid * resid : 0.0;
+        }
+    }
+
+    for (std::size_t w = 0; w < size; ++w) {
+        if (!active[w])
+            continue;
+        DCA_PROFILE_COUNT(objective);
+        if (Traits::batch_feasible(x, w)) {
+            values[w] = sse[w];
+        } else {
+            DCA_PROFILE_COUNT(infeasible);
+            values[w] = std::numeric_limits<double>::infinity();
+        }
+    }
 }
 
+// the batch objective for nelder_mead_batch: by the model's batch kernel if
+// it has one, else lane by lane through its cumulative
+template<class Decline, class Range>
+class lane_objective {
+    public:
+        using traits = decline_traits<Decline>;
+        using params = typename traits::params;
+
+        lane_objective(const Range* wells, std::size_t count,
+                double time_initial, double time_step)
+            : wells_(wells), lanes_(wells, count),
+              time_initial_(time_initial), time_step_(time_step) { }
+
+        template<std::size_t N>
+        void operator()(const std::array<const double*, N>& x,
+                const char* active, std::size_t size, double* values) const
+        {
+            evaluate(has_batch_kernel<traits>(), x, active, size, values);
+        }
+
+    private:
+        template<std::size_t N>
+        void evaluate(std::true_type, const std::array<const double*, N>& x,
+                const char* active, std::size_t size, double* values) const
+        {
+            sse_against_interval_lanes<traits>(x, active, size, values,
+                    lanes_, time_initial_, time_step_);
+        }
+
+        template<std::size_t N>
+        void evaluate(std::false_type, const std::array<const double*, N>& x,
+                const char* active, std::size_t size, double* values) const
+        {
+            for (std::size_t w = 0; w < size; ++w) {
+                if (!active[w])
+                    continue;
+                std::array<double, N> a;
+                for (std::size_t p = 0; p < N; ++p)
+                    a[p] = x[p][w];
+                try {
+                    values[w] = sse_against_interval(
+                            tuple::construct<Decline>(
+                                convex::detail::array_to_tuple<params>(a)),
+                            wells_[w].first, wells_[w].second,
+                            time_initial_, time_step_);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    values[w] = std::numeric_limits<double>::infinity();
+                }
+            }
+        }
+
+        const Range* wells_;
+        interval_lanes lanes_;
+        double time_initial_, time_step_;
+};
+
+}
+
+/*
+ * least-squares fits from the default starting points, by the solver and
+ * within the budget given in options; if status is non-null it receives
+ * how the fit ended. throws std::out_of_range if the budget ran out before
+ * any feasible point was found.
+ */
 template<class Decline, class RateIter, class TimeIter>
 inline Decline best_from_rate(
-        RateIter rate_begin, RateIter rate_end, TimeIter time_begin)
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin,
+        const fit_options& options = fit_options {},
+        fit_status* status = nullptr)
 {
-    return tuple::construct<Decline>(
-            convex::nelder_mead(
-              [=](const auto &t) {
-                  try {
-                      return detail::sse_against_rate(
-                          tuple::construct<Decline>(t),
-                          rate_begin, rate_end, time_begin);
-                  } catch (...) {
-                      return std::numeric_limits<double>::infinity();
-                  }
-              },
-              convex::inner_simplex(detail::decline_traits<Decline>::
-                  parameter_bounds_guess(rate_begin, rate_end)),
-              300));
+    DCA_PROFILE_SCOPE(fit);
+    auto seed = detail::decline_traits<Decline>::seed(
+            detail::make_rate_samples(rate_begin, rate_end, time_begin));
+    return tuple::construct<Decline>(detail::minimize(
+            [=](const auto& t) {
+                try {
+                    return detail::sse_against_rate(
+                        tuple::construct<Decline>(t),
+                        rate_begin, rate_end, time_begin);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_rate<Decline>(t,
+                        rate_begin, rate_end, time_begin, gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            seed, detail::decline_traits<Decline>::bounds(seed),
+            options, status));
 }
 
 template<class Decline, class VolIter>
 inline Decline best_from_interval_volume(
+        VolIter vol_begin, VolIter vol_end,
+        double time_initial, double time_step,
+        const fit_options& options = fit_options {},
+        fit_status* status = nullptr)
+{
+    DCA_PROFILE_SCOPE(fit);
+    auto seed = detail::decline_traits<Decline>::seed(
+            detail::make_interval_samples(vol_begin, vol_end, time_initial,
+                time_step));
+    return tuple::construct<Decline>(detail::minimize(
+            [=](const auto& t) {
+                try {
+                    return detail::sse_against_interval(
+                        tuple::construct<Decline>(t),
+                        vol_begin, vol_end, time_initial, time_step);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_interval<Decline>(t,
+                        vol_begin, vol_end, time_initial, time_step,
+                        gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            seed, detail::decline_traits<Decline>::bounds(seed),
+            options, status));
+}
+
+namespace detail {
+
+/*
+ * one solve over the joint parameters of all phases (as laid out by
+ * Layout), whose objective walks all phases month by month in one pass
+ */
+template<class Layout, class Decline, class VolIter, std::size_t Phases>
+inline std::array<Decline, Phases> best_from_phases(
+        const std::array<std::pair<VolIter, VolIter>, Phases>& phases,
+        double time_initial, double time_step,
+        const fit_options& options, fit_status* status)
+{
+    DCA_PROFILE_SCOPE(fit);
+    using params = typename Layout::params;
+
+    std::array<double, Phases> weight;
+    std::array<params, Phases> seed, lower, upper;
+    for (std::size_t p = 0; p < Phases; ++p) {
+        weight[p] = phase_weight(phases[p].first, phases[p].second);
+        seed[p] = decline_traits<Decline>::seed(make_interval_samples(
+                    phases[p].first, phases[p].second, time_initial,
+                    time_step));
+        auto bounds = decline_traits<Decline>::bounds(seed[p]);
+        lower[p] = bounds.first;
+        upper[p] = bounds.second;
+    }
+
+    auto joint_decline = [](const auto& t, std::size_t p) {
+        return tuple::construct<Decline>(
+                Layout::phase(convex::detail::tuple_to_array(t), p));
+    };
+
+    auto joint_sse = [=](const auto& t) {
+        DCA_PROFILE_COUNT(objective);
+        try {
+            // one pass over the months, all phases at once
+            auto decl = generate_array<Phases>(
+                    [&](std::size_t p) { return joint_decline(t, p); });
+            std::array<VolIter, Phases> vol;
+            std::array<double, Phases> last_cum;
+            for (std::size_t p = 0; p < Phases; ++p) {
+                vol[p] = phases[p].first;
+                last_cum[p] = 0.0;
+            }
+
+            double sse = 0.0, time = time_initial;
+            for (bool active = true; active; ) {
+                active = false;
+                time += time_step;
+                for (std::size_t p = 0; p < Phases; ++p) {
+                    if (vol[p] == phases[p].second)
+                        continue;
+                    active = true;
+                    double cum = decl[p].cumulative(time);
+                    double resid = *vol[p]++ - (cum - last_cum[p]);
+                    last_cum[p] = cum;
+                    sse += weight[p] * resid * resid;
+                }
+            }
+            return sse;
+        } catch (...) {
+            DCA_PROFILE_COUNT(infeasible);
+            return std::numeric_limits<double>::infinity();
+        }
+    };
+
+    // no dual-number form of the joint SSE: central differences for BFGS,
+    // charged as the 2n + 1 evaluations they make
+    auto joint_sse_gradient = [=](const auto& t, auto& gradient) {
+        auto x = convex::detail::tuple_to_array(t);
+        for (std::size_t r = 0; r < x.size(); ++r) {
+            const double h = 1e-6 * std::max(std::abs(x[r]), 1.0);
+            auto step = x;
+            step[r] = x[r] + h;
+            double up = joint_sse(convex::detail::array_to_tuple<
+                    std::decay_t<decltype(t)>>(step));
+            step[r] = x[r] - h;
+            double down = joint_sse(convex::detail::array_to_tuple<
+                    std::decay_t<decltype(t)>>(step));
+            gradient[r] = (up - down) / (2.0 * h);
+        }
+        return joint_sse(t);
+    };
+
+    // more parameters: proportionally more iterations
+    fit_options joint_options = options;
+    joint_options.max_iter *= static_cast<int>(Phases);
+    auto best = minimize(joint_sse, joint_sse_gradient,
+            Layout::join(seed),
+            std::make_pair(Layout::join(lower), Layout::join(upper)),
+            joint_options, status, 2 * Layout::length + 1);
+
+    return generate_array<Phases>(
+            [&](std::size_t p) { return joint_decline(best, p); });
+}
+
+}
+
+/*
+ * fit several phases (e.g. oil, gas and water) of one well, or type well,
+ * on a shared time grid, in one solve over all phases' parameters: each
+ * range should already be aligned to the same time origin (see
+ * shift_to_peak with tied iterators). each phase's SSE is normalized by
+ * its sum of squares so that no phase dominates on units.
+ */
+template<class Decline, class VolIter, std::size_t Phases>
+inline std::array<Decline, Phases> best_from_interval_volume_joint(
+        const std::array<std::pair<VolIter, VolIter>, Phases>& phases,
+        double time_initial, double time_step,
+        const fit_options& options = fit_options {},
+        fit_status* status = nullptr)
+{
+    return detail::best_from_phases<
+        detail::separate_layout<Decline, Phases>, Decline>(
+                phases, time_initial, time_step, options, status);
+}
+
+// as above, with a single b shared by all phases
+template<class Decline, class VolIter, std::size_t Phases>
+inline std::array<Decline, Phases> best_from_interval_volume_shared_b(
+        const std::array<std::pair<VolIter, VolIter>, Phases>& phases,
+        double time_initial, double time_step,
+        const fit_options& options = fit_options {},
+        fit_status* status = nullptr)
+{
+    return detail::best_from_phases<
+        detail::shared_b_layout<Decline, Phases>, Decline>(
+                phases, time_initial, time_step, options, status);
+}
+
+/*
+ * fit many wells at once: wells are fit `lanes` at a time by lockstep
+ * Nelder-Mead (the same fits as best_from_interval_volume, one per well),
+ * and groups of lanes on up to `threads` threads (0: one per hardware
+ * thread). wells is a container of (begin, end) volume ranges, all on the
+ * same time grid; returns the declines in well order. options give the
+ * iteration limit, tolerances and steps; the solver is always Nelder-Mead,
+ * and evaluation and deadline budgets apply only to single-well fits.
+ * models with a branch-free batch kernel in their traits (arps_hyperbolic)
+ * are evaluated across all lanes of a group at once.
+ */
+template<class Decline, class Wells>
+inline std::vector<Decline> best_from_interval_volume_batch(
+        const Wells& wells, double time_initial, double time_step,
+        const fit_options& options = fit_options {},
+        unsigned threads = 0, std::size_t lanes = 64)
+{
+    using std::begin;
+    using std::end;
+    using traits = detail::decline_traits<Decline>;
+    using range = std::decay_t<decltype(*begin(wells))>;
+    using params = typename traits::params;
+    using simplex =
+        typename convex::detail::simplex_traits<params>::simplex_type;
+
+    std::vector<range> ranges(begin(wells), end(wells));
+    std::vector<params> best(ranges.size());
+    if (lanes == 0)
+        lanes = 1;
+    const std::size_t groups = (ranges.size() + lanes - 1) / lanes;
+
+    parallel_for(groups, [&](std::size_t g) {
+        DCA_PROFILE_SCOPE(fit);
+        const std::size_t first = g * lanes;
+        const std::size_t count = std::min(lanes, ranges.size() - first);
+
+        std::vector<simplex> initial;
+        initial.reserve(count);
+        for (std::size_t w = first; w < first + count; ++w) {
+            auto seed = traits::seed(detail::make_interval_samples(
+                        ranges[w].first, ranges[w].second,
+                        time_initial, time_step));
+            initial.push_back(convex::seeded_simplex(seed,
+                        traits::bounds(seed)));
+        }
+
+        auto found = convex::nelder_mead_batch(
+                detail::lane_objective<Decline, range>(&ranges[first], count,
+                    time_initial, time_step),
+                initial, options.max_iter, options.term_eps,
+                options.term_iter, options.ref_factor, options.exp_factor,
+                options.con_factor, options.shr_factor);
+        std::copy(found.begin(), found.end(), best.begin() + first);
+    }, threads);
+
+    std::vector<Decline> result;
+    result.reserve(best.size());
+    for (const auto& b : best)
+        result.push_back(tuple::construct<Decline>(b));
+    return result;
+}
+
+// quasi-Newton fits with dual-number gradients, e.g. to refit from an
+// earlier solution; the initial tuple gives the decline's parameters in order
+// (the solver in options is ignored)
+template<class Decline, class RateIter, class TimeIter, class... Params>
+inline Decline best_from_rate_bfgs(
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin,
+        const std::tuple<Params...>& initial,
+        const fit_options& options = fit_options {},
+        fit_status* status = nullptr)
+{
+    DCA_PROFILE_SCOPE(fit);
+    return tuple::construct<Decline>(detail::refine(
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_rate<Decline>(t,
+                        rate_begin, rate_end, time_begin, gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            initial, options, status));
+}
+
+template<class Decline, class VolIter, class... Params>
+inline Decline best_from_interval_volume_bfgs(
+        VolIter vol_begin, VolIter vol_end,
+        double time_initial, double time_step,
+        const std::tuple<Params...>& initial,
+        const fit_options& options = fit_options {},
+        fit_status* status = nullptr)
+{
+    DCA_PROFILE_SCOPE(fit);
+    return tuple::construct<Decline>(detail::refine(
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_interval<Decline>(t,
+                        vol_begin, vol_end, time_initial, time_step,
+                        gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            initial, options, status));
+}
+
+// as above, starting from the best vertex of the usual initial simplex
+template<class Decline, class RateIter, class TimeIter>
+inline Decline best_from_rate_bfgs(
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin)
+{
+    fit_options options;
+    options.solver = fit_solver::bfgs;
+    return best_from_rate<Decline>(rate_begin, rate_end, time_begin,
+            options);
+}
+
+template<class Decline, class VolIter>
+inline Decline best_from_interval_volume_bfgs(
         VolIter vol_begin, VolIter vol_end,
         double time_initial, double time_step)
 {
-    return tuple::construct<Decline>(
-            convex::nelder_mead(
-              [=](const auto &t) {
-                  try {
-                      return detail::sse_against_interval(
-                          tuple::construct<Decline>(t),
-                          vol_begin, vol_end, time_initial, time_step);
-                  } catch (...) {
-                      return std::numeric_limits<double>::infinity();
-                  }
-              },
-              convex::inner_simplex(detail::decline_traits<Decline>::
-                  parameter_bounds_guess(vol_begin, vol_end)),
-              300));
+    fit_options options;
+    options.solver = fit_solver::bfgs;
+    return best_from_interval_volume<Decline>(vol_begin, vol_end,
+            time_initial, time_step, options);
 }
 
+/*
+ * the common models and fits, compiled once into libdca.a (one source file
+ * per model, in src): DCA_INSTANTIATE(extern) declares them,
+ * DCA_INSTANTIATE() defines them.
+ * consumers linking libdca.a define DCA_EXTERN_TEMPLATES so as not to
+ * compile them again; header-only use is unaffected.
+ */
+#define DCA_INSTANTIATE_FITS(storage, Decline, Iter) \
+    storage template Decline best_from_rate<Decline, Iter, Iter>( \
+            Iter, Iter, Iter, const fit_options&, fit_status*); \
+    storage template Decline best_from_interval_volume<Decline, Iter>( \
+            Iter, Iter, double, double, const fit_options&, fit_status*);
+
+#define DCA_INSTANTIATE_MODEL(storage, Model, Params) \
+    storage template class Model<dual<Params>>; \
+    storage template double eur<Model<double>>(const Model<double>&, \
+            double, double, double*) noexcept; \
+    storage template double time_to_rate<Model<double>>( \
+            const Model<double>&, double) noexcept; \
+    storage template double time_to_cumulative<Model<double>>( \
+            const Model<double>&, double) noexcept; \
+    DCA_INSTANTIATE_FITS(storage, Model<double>, \
+            std::vector<double>::iterator) \
+    DCA_INSTANTIATE_FITS(storage, Model<double>, \
+            std::vector<double>::const_iterator) \
+    DCA_INSTANTIATE_FITS(storage, Model<double>, const double*)
+
+#define DCA_INSTANTIATE(storage) \
+    DCA_INSTANTIATE_MODEL(storage, basic_arps_exponential, 2) \
+    DCA_INSTANTIATE_MODEL(storage, basic_arps_hyperbolic, 3) \
+    DCA_INSTANTIATE_MODEL(storage, basic_arps_hyperbolic_to_exponential, 4) \
+    DCA_INSTANTIATE_MODEL(storage, basic_stretched_exponential, 3) \
+    DCA_INSTANTIATE_MODEL(storage, basic_duong, 3)
+
+#ifdef DCA_EXTERN_TEMPLATES
+DCA_INSTANTIATE(extern)
+#endif
+
 }
 
 #endif
@@ -0,0 +1,54 @@
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace dca {
+
+// each model's type tag in a binary batch (see serialize.hpp)
+enum class decline_tag : std::uint32_t {
+    none = 0, // no encoding
+    arps_exponential = 1,
+    arps_hyperbolic = 2,
+    arps_hyperbolic_to_exponential = 3,
+    stretched_exponential = 4,
+    duong = 5
+};
+
+const std::size_t max_decline_params = 4;
+
+/*
+ * each model's tag and parameters, specialized beside the model: width is
+ * how many parameters it has (at most max_decline_params), encode writes
+ * them to params and returns width, and decode constructs the model,
+ * throwing std::invalid_argument for another model's tag. declines of
+ * other types have tag none and no encoding.
+ */
+template<class Decline>
+struct decline_codec {
+    static decline_tag tag(const Decline&) noexcept
+    {
+        return decline_tag::none;
+    }
+
+    static std::size_t encode(const Decline&, double*) noexcept
+    {
+        return 0;
+    }
+};
+
+namespace detail {
+
+inline void check_tag(decline_tag tag, decline_tag expected)
+{
+    if (tag != expected)
+        throw std::invalid_argument("Decline type mismatch.");
+}
+
+}
+
+}
+
+#endif
@@ -8,7 +8,12 @@
 #include <algorithm>
 #include <cstddef>
 #include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
 
+#include "parallel.hpp"
+#include "profile.hpp"
 #include "tuple_tools.hpp"
 
 namespace convex {
@@ -185,6 +190,36 @@ struct must_apply {
     static const bool value = type::value;
 };
 
+template<class Tuple, std::size_t... I>
+std::array<double, sizeof...(I)> tuple_to_array_impl(const Tuple& t,
+        std::index_sequence<I...>)
+{
+    return std::array<double, sizeof...(I)> {
+        { static_cast<double>(std::get<I>(t))... }
+    };
+}
+
+template<class... Params>
+std::array<double, sizeof...(Params)> tuple_to_array(
+        const std::tuple<Params...>& t)
+{
+    return tuple_to_array_impl(t,
+            std::make_index_sequence<sizeof...(Params)>());
+}
+
+template<class Tuple, std::size_t N, std::size_t... I>
+Tuple array_to_tuple_impl(const std::array<double, N>& a,
+        std::index_sequence<I...>)
+{
+    return Tuple(static_cast<std::tuple_element_t<I, Tuple>>(a[I])...);
+}
+
+template<class Tuple, std::size_t N>
+Tuple array_to_tuple(const std::array<double, N>& a)
+{
+    return array_to_tuple_impl<Tuple>(a, std::make_index_sequence<N>());
+}
+
 }
 
 template<class... Params>
@@ -203,6 +238,34 @@ inner_simplex(const std::pair<std::tuple<Params...>,
     return inner_simplex;
 }
 
+/*
+ * a simplex from a starting point: seed, plus one vertex per parameter a
+ * step of fraction of its range in limits away, toward the farther limit
+ */
+template<class... Params>
+typename detail::simplex_traits<std::tuple<Params...>>::simplex_type
+seeded_simplex(const std::tuple<Params...>& seed,
+        const std::pair<std::tuple<Params...>,
+        std::tuple<Params...>>& limits, double fraction = 0.25)
+{
+    using tuple_type = std::tuple<Params...>;
+    const auto x = detail::tuple_to_array(seed),
+          lo = detail::tuple_to_array(limits.first),
+          hi = detail::tuple_to_array(limits.second);
+
+    typename detail::simplex_traits<tuple_type>::simplex_type spx;
+    spx[0] = seed;
+    for (std::size_t r = 0; r < x.size(); ++r) {
+        double step = fraction * (hi[r] - lo[r]);
+        if (!(step > 0.0)) // a degenerate range
+            step = fraction * std::max(std::abs(x[r]), 1e-3);
+        auto vertex = x;
+        vertex[r] += hi[r] - x[r] >= x[r] - lo[r] ? step : -step;
+        spx[r + 1] = detail::array_to_tuple<tuple_type>(vertex);
+    }
+    return spx;
+}
+
 template<class Fn, class Simplex,
     class = typename std::enable_if_t<!detail::must_apply<
       Fn, typename Simplex::value_type>::value>>
@@ -246,6 +309,7 @@ typename Simplex::value_type nelder_mead(
     using std::begin;
     using std::end;
 
+    DCA_PROFILE_SCOPE(optimize);
     auto trial_simplex(initial_simplex);
     std::array<typename std::result_of_t<Fn(typename Simplex::value_type)>,
         std::tuple_size<Simplex>::value> result;
@@ -389,6 +453,578 @@ typename Simplex::value_type nelder_mead(
             ref_factor, exp_factor, con_factor, shr_factor);
 }
 
+/*
+ * quasi-Newton (BFGS) minimization from a single starting point.
+ * f(x, gradient) returns the objective at the tuple x and stores its
+ * gradient in the std::array<double, N> gradient; non-finite objective
+ * values are treated as infeasible and backtracked away from.
+ * terminates after term_iter consecutive iterations with a relative
+ * improvement below term_eps, or when no descent step can be found.
+ */
+template<class Fn, class... Params>
+std::tuple<Params...> bfgs(
+        Fn f,
+        const std::tuple<Params...>& initial,
+        int max_iter,
+        double term_eps = std::sqrt(std::numeric_limits<double>::epsilon()),
+        int term_iter = 2,
+        double armijo_factor = 1e-4,
+        double backtrack_factor = 0.5,
+        int max_backtrack = 60)
+{
+    static const std::size_t n = sizeof...(Params);
+    using point = std::array<double, n>;
+    using matrix = std::array<point, n>;
+
+    DCA_PROFILE_SCOPE(optimize);
+    point x = detail::tuple_to_array(initial), grad {};
+
+    // diagonal preconditioning by the magnitude of the starting point:
+    // decline parameters differ in scale by many orders of magnitude
+    point scale;
+    for (std::size_t r = 0; r < n; ++r)
+        scale[r] = std::max(std::abs(x[r]), 1.0);
+
+    auto identity = [&](double gamma) {
+        matrix m {};
+        for (std::size_t r = 0; r < n; ++r)
+            m[r][r] = gamma * scale[r] * scale[r];
+        return m;
+    };
+
+    double fx = f(initial, grad);
+    if (!std::isfinite(fx))
+        return initial;
+
+    matrix inv_hess = identity(1.0);
+    bool fresh = true; // inverse Hessian estimate is the (scaled) identity
+
+    for (int i = 0, t = 0; t < term_iter && i < max_iter; ++i) {
+        point dir;
+        double slope = 0.0;
+        for (std::size_t r = 0; r < n; ++r) {
+            dir[r] = 0.0;
+            for (std::size_t c = 0; c < n; ++c)
+                dir[r] -= inv_hess[r][c] * grad[c];
+            slope += dir[r] * grad[r];
+        }
+
+        if (!(slope < 0.0)) { // not a descent direction: restart
+            if (fresh)
+                break;
+            inv_hess = identity(1.0);
+            fresh = true;
+            continue;
+        }
+
+        point x_next, grad_next {};
+        double f_next = fx;
+
+        // backtracking (Armijo) line search along d
+        auto line_search = [&](const point& d, double d_slope) {
+            // never move a parameter by more than its own magnitude (or 1)
+            // in one step; keeps badly-scaled early steps out of flat regions
+            double step = 1.0;
+            for (std::size_t r = 0; r < n; ++r)
+                if (d[r] != 0.0)
+                    step = std::min(step,
+                            std::max(std::abs(x[r]), 1.0) / std::abs(d[r]));
+
+            for (int k = 0; k < max_backtrack; ++k, step *= backtrack_factor) {
+                for (std::size_t r = 0; r < n; ++r)
+                    x_next[r] = x[r] + step * d[r];
+                f_next = f(
+                        detail::array_to_tuple<std::tuple<Params...>>(x_next),
+                        grad_next);
+                if (std::isfinite(f_next)
+                        && f_next <= fx + armijo_factor * step * d_slope)
+                    return true;
+            }
+            return false;
+        };
+
+        bool accepted = line_search(dir, slope);
+
+        if (!accepted && !fresh) { // retry next time on steepest descent
+            inv_hess = identity(1.0);
+            fresh = true;
+            continue;
+        }
+
+        // steepest descent runs straight into an infeasible region (e.g. a
+        // parameter held at a bound): hold each parameter fixed in turn
+        for (std::size_t fixed = 0; !accepted && fixed < n; ++fixed) {
+            point reduced = dir;
+            reduced[fixed] = 0.0;
+            double reduced_slope = 0.0;
+            for (std::size_t r = 0; r < n; ++r)
+                reduced_slope += reduced[r] * grad[r];
+            if (reduced_slope < 0.0)
+                accepted = line_search(reduced, reduced_slope);
+        }
+
+        if (!accepted)
+            break;
+
+        point s, y, hy;
+        double sy = 0.0, ydy = 0.0;
+        for (std::size_t r = 0; r < n; ++r) {
+            s[r] = x_next[r] - x[r];
+            y[r] = grad_next[r] - grad[r];
+            sy += s[r] * y[r];
+            ydy += y[r] * y[r] * scale[r] * scale[r];
+        }
+
+        if (sy > 0.0 && ydy > 0.0) {
+            // scale the initial estimate to the curvature seen
+            if (fresh)
+                inv_hess = identity(sy / ydy);
+
+            double yhy = 0.0;
+            for (std::size_t r = 0; r < n; ++r) {
+                hy[r] = 0.0;
+                for (std::size_t c = 0; c < n; ++c)
+                    hy[r] += inv_hess[r][c] * y[c];
+                yhy += y[r] * hy[r];
+            }
+
+            for (std::size_t r = 0; r < n; ++r)
+                for (std::size_t c = 0; c < n; ++c)
+                    inv_hess[r][c] += (sy + yhy) * s[r] * s[c] / (sy * sy)
+                        - (hy[r] * s[c] + s[r] * hy[c]) / sy;
+            fresh = false;
+        }
+
+        if (fx - f_next <= term_eps * (std::abs(fx) + term_eps))
+            ++t;
+        else
+            t = 0;
+
+        x = x_next;
+        grad = grad_next;
+        fx = f_next;
+    }
+
+    return detail::array_to_tuple<std::tuple<Params...>>(x);
+}
+
+/*
+ * differential evolution (DE/rand/1/bin) within box bounds: a global
+ * search, for objectives with poor local minima. each generation's trial
+ * points are evaluated together by batch_f(points, values), which takes a
+ * std::vector of tuples and fills the std::vector<double> values (resized
+ * to match); see differential_evolution below for a point-wise objective.
+ * trial points are drawn from a generator seeded with seed, so results
+ * don't depend on how the batch is evaluated. terminates after
+ * max_generations, or once the population's objective values agree within
+ * term_eps (relatively) for term_iter generations. population 0 means ten
+ * points per parameter (at least 8). with polish_iter > 0, the best point
+ * is refined by Nelder-Mead on a simplex spanning the final population.
+ */
+template<class BatchFn, class... Params>
+std::tuple<Params...> differential_evolution_batch(
+        BatchFn batch_f,
+        const std::pair<std::tuple<Params...>, std::tuple<Params...>>& bounds,
+        int max_generations,
+        std::size_t population = 0,
+        double weight = 0.8,
+        double crossover = 0.9,
+        int polish_iter = 300,
+        unsigned seed = 5489u,
+        double term_eps = 1e-8,
+        int term_iter = 10)
+{
+    static const std::size_t n = sizeof...(Params);
+    using tuple_type = std::tuple<Params...>;
+    using point = std::array<double, n>;
+
+    DCA_PROFILE_SCOPE(optimize);
+    if (population == 0)
+        population = std::max<std::size_t>(8, 10 * n);
+    population = std::max<std::size_t>(population, 4); // for rand/1
+
+    const point lo = detail::tuple_to_array(bounds.first),
+          hi = detail::tuple_to_array(bounds.second);
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<std::size_t> pick(0, population - 1),
+        pick_param(0, n - 1);
+
+    std::vector<point> members(population);
+    std::vector<tuple_type> points(population);
+    std::vector<double> values, trial_values;
+    for (std::size_t i = 0; i < population; ++i) {
+        for (std::size_t r = 0; r < n; ++r)
+            members[i][r] = lo[r] + unit(gen) * (hi[r] - lo[r]);
+        points[i] = detail::array_to_tuple<tuple_type>(members[i]);
+    }
+    batch_f(points, values);
+
+    std::vector<point> trials(population);
+    for (int g = 0, t = 0; g < max_generations && t < term_iter; ++g) {
+        for (std::size_t i = 0; i < population; ++i) {
+            std::size_t a, b, c;
+            do { a = pick(gen); } while (a == i);
+            do { b = pick(gen); } while (b == i || b == a);
+            do { c = pick(gen); } while (c == i || c == a || c == b);
+
+            // at least one parameter always comes from the mutant
+            std::size_t forced = pick_param(gen);
+            for (std::size_t r = 0; r < n; ++r) {
+                double x = members[i][r];
+                if (r == forced || unit(gen) < crossover) {
+                    const double base = members[a][r];
+                    x = base + weight * (members[b][r] - members[c][r]);
+                    // bounce back between the base and the violated bound
+                    if (x < lo[r])
+                        x = base - unit(gen) * (base - lo[r]);
+                    else if (x > hi[r])
+                        x = base + unit(gen) * (hi[r] - base);
+                }
+                trials[i][r] = x;
+            }
+            points[i] = detail::array_to_tuple<tuple_type>(trials[i]);
+        }
+
+        batch_f(points, trial_values);
+        for (std::size_t i = 0; i < population; ++i) {
+            if (trial_values[i] <= values[i]) {
+                members[i] = trials[i];
+                values[i] = trial_values[i];
+            }
+        }
+
+        auto extrema = std::minmax_element(values.begin(), values.end());
+        if (*extrema.second - *extrema.first
+                <= term_eps * std::abs(*extrema.first))
+            ++t;
+        else
+            t = 0;
+    }
+
+    auto best = static_cast<std::size_t>(std::distance(values.begin(),
+                std::min_element(values.begin(), values.end())));
+    tuple_type result = detail::array_to_tuple<tuple_type>(members[best]);
+    if (polish_iter <= 0)
+        return result;
+
+    // a simplex from the best point, one step per parameter along the
+    // population's remaining spread
+    typename detail::simplex_traits<tuple_type>::simplex_type spx;
+    spx[0] = result;
+    for (std::size_t r = 0; r < n; ++r) {
+        double spread = 0.0;
+        for (const auto& m : members)
+            spread = std::max(spread, std::abs(m[r] - members[best][r]));
+        if (!(spread > 0.0))
+            spread = 1e-3 * (hi[r] - lo[r]);
+        point vertex = members[best];
+        vertex[r] += vertex[r] + spread <= hi[r] ? spread : -spread;
+        spx[r + 1] = detail::array_to_tuple<tuple_type>(vertex);
+    }
+
+    std::vector<tuple_type> one(1);
+    std::vector<double> one_value;
+    auto polished = nelder_mead([&](const tuple_type& x) {
+                one[0] = x;
+                batch_f(one, one_value);
+                return one_value[0];
+            }, spx, polish_iter);
+
+    one[0] = polished;
+    batch_f(one, one_value);
+    return one_value[0] <= values[best] ? polished : result;
+}
+
+/*
+ * as above, for an objective f(tuple) called point by point; each
+ * generation is evaluated on up to `threads` threads (0: one per hardware
+ * thread), so f must then be safe to call concurrently
+ */
+template<class Fn, class... Params>
+std::tuple<Params...> differential_evolution(
+        Fn f,
+        const std::pair<std::tuple<Params...>, std::tuple<Params...>>& bounds,
+        int max_generations,
+        std::size_t population = 0,
+        double weight = 0.8,
+        double crossover = 0.9,
+        int polish_iter = 300,
+        unsigned threads = 1,
+        unsigned seed = 5489u)
+{
+    return differential_evolution_batch(
+            [&](const std::vector<std::tuple<Params...>>& points,
+                std::vector<double>& values) {
+                values.resize(points.size());
+                dca::parallel_for(points.size(), [&](std::size_t i) {
+                    values[i] = f(points[i]);
+                }, threads);
+            }, bounds, max_generations, population, weight, crossover,
+            polish_iter, seed);
+}
+
+/*
+ * many independent Nelder-Mead problems of the same dimension advanced in
+ * lockstep, one per lane, with the simplexes stored structure-of-arrays
+ * (each coordinate of each vertex contiguous across lanes). each step
+ * evaluates all lanes' trial points at once:
+ *
+ *     batch_f(params, active, lanes, values)
+ *
+ * where params is a std::array<const double*, N> (params[p][lane]), and
+ * values[lane] must be set for each lane with active[lane] nonzero. every
+ * lane makes the same decisions as nelder_mead would on its own problem;
+ * lanes which have converged drop out of the batch. returns each lane's
+ * best vertex.
+ */
+template<class BatchFn, class Simplex>
+std::vector<typename Simplex::value_type> nelder_mead_batch(
+        BatchFn batch_f,
+        const std::vector<Simplex>& initial,
+        int max_iter,
+        double term_eps = std::sqrt(std::numeric_limits<double>::epsilon()),
+        int term_iter = 10,
+        double ref_factor = 1.0,
+        double exp_factor = 2.0,
+        double con_factor = 0.5,
+        double shr_factor = 0.5)
+{
+    using tuple_type = typename Simplex::value_type;
+    static const std::size_t n = std::tuple_size<tuple_type>::value;
+    static const std::size_t vertices = n + 1;
+    using coords = std::array<const double*, n>;
+
+    DCA_PROFILE_SCOPE(optimize);
+    const std::size_t lanes = initial.size();
+
+    // vertex v, coordinate p, lane w at x[(v * n + p) * lanes + w]
+    std::vector<double> x(vertices * n * lanes), fx(vertices * lanes);
+    auto at = [&](std::size_t v, std::size_t p) {
+        return x.data() + (v * n + p) * lanes;
+    };
+    auto vertex_coords = [&](std::size_t v) {
+        coords c;
+        for (std::size_t p = 0; p < n; ++p)
+            c[p] = at(v, p);
+        return c;
+    };
+
+    for (std::size_t w = 0; w < lanes; ++w) {
+        for (std::size_t v = 0; v < vertices; ++v) {
+            auto a = detail::tuple_to_array(initial[w][v]);
+            for (std::size_t p = 0; p < n; ++p)
+                at(v, p)[w] = a[p];
+        }
+    }
+
+    std::vector<char> active(lanes, 1), second(lanes), shrink(lanes);
+    std::vector<std::size_t> best(lanes), worst(lanes);
+    std::vector<int> converged(lanes, 0);
+    std::vector<unsigned char> step(lanes);
+    std::array<std::vector<double>, n> cent, reflect, trial;
+    for (std::size_t p = 0; p < n; ++p) {
+        cent[p].resize(lanes);
+        reflect[p].resize(lanes);
+        trial[p].resize(lanes);
+    }
+    std::vector<double> reflect_res(lanes), trial_res(lanes), values(lanes);
+    auto as_coords = [](const std::array<std::vector<double>, n>& a) {
+        coords c;
+        for (std::size_t p = 0; p < n; ++p)
+            c[p] = a[p].data();
+        return c;
+    };
+
+    auto f_of = [&](std::size_t v, std::size_t w) -> double& {
+        return fx[v * lanes + w];
+    };
+
+    // as std::max_element: the first largest
+    auto first_max = [&](std::size_t w) {
+        std::size_t m = 0;
+        for (std::size_t v = 1; v < vertices; ++v)
+            if (f_of(m, w) < f_of(v, w))
+                m = v;
+        return m;
+    };
+
+    // as std::minmax_element: the first smallest and the last largest
+    auto extrema = [&](std::size_t w) {
+        std::size_t lo = 0, hi = 0;
+        for (std::size_t v = 1; v < vertices; ++v) {
+            if (f_of(v, w) < f_of(lo, w))
+                lo = v;
+            if (!(f_of(v, w) < f_of(hi, w)))
+                hi = v;
+        }
+        best[w] = lo;
+        worst[w] = hi;
+    };
+
+    auto centroid = [&](std::size_t w) {
+        for (std::size_t p = 0; p < n; ++p) {
+            double sum = 0.0;
+            for (std::size_t v = 0; v < vertices; ++v)
+                if (v != worst[w])
+                    sum += at(v, p)[w];
+            cent[p][w] = sum / (vertices - 1);
+        }
+    };
+
+    auto replace_worst = [&](std::size_t w,
+            const std::array<std::vector<double>, n>& from, double value) {
+        for (std::size_t p = 0; p < n; ++p)
+            at(worst[w], p)[w] = from[p][w];
+        f_of(worst[w], w) = value;
+    };
+
+    // evaluate every vertex of the masked lanes
+    auto evaluate_vertices = [&](const std::vector<char>& mask) {
+        for (std::size_t v = 0; v < vertices; ++v) {
+            batch_f(vertex_coords(v), mask.data(), lanes, values.data());
+            for (std::size_t w = 0; w < lanes; ++w)
+                if (mask[w])
+                    f_of(v, w) = values[w];
+        }
+    };
+
+    evaluate_vertices(active);
+    for (std::size_t w = 0; w < lanes; ++w) {
+        extrema(w);
+        centroid(w);
+    }
+
+    enum { expand, accept, outside, inside };
+
+    for (int i = 0; i < max_iter; ++i) {
+        if (std::find(active.begin(), active.end(), 1) == active.end())
+            break;
+
+        for (std::size_t p = 0; p < n; ++p)
+            for (std::size_t w = 0; w < lanes; ++w)
+                reflect[p][w] = cent[p][w] * (1.0 + ref_factor)
+                    + at(worst[w], p)[w] * -ref_factor;
+        batch_f(as_coords(reflect), active.data(), lanes, reflect_res.data());
+
+        // each lane's branch, and its second trial point if it needs one
+        for (std::size_t w = 0; w < lanes; ++w) {
+            second[w] = 0;
+            if (!active[w])
+                continue;
+
+            double rr = reflect_res[w];
+            if (rr < f_of(best[w], w)) {
+                step[w] = expand;
+            } else {
+                bool better_than_second_worst = false;
+                for (std::size_t v = 0; v < vertices; ++v)
+                    if (v != worst[w] && f_of(v, w) > rr)
+                        better_than_second_worst = true;
+                step[w] = better_than_second_worst ? accept
+                    : f_of(worst[w], w) > rr ? outside : inside;
+            }
+
+            second[w] = step[w] != accept;
+            for (std::size_t p = 0; p < n; ++p) {
+                switch (step[w]) {
+                    case expand:
+                        trial[p][w] = cent[p][w] * (1.0 - exp_factor)
+                            + reflect[p][w] * exp_factor;
+                        break;
+                    case outside:
+                        trial[p][w] = cent[p][w] * (1.0 - con_factor)
+                            + reflect[p][w] * con_factor;
+                        break;
+                    case inside:
+                        trial[p][w] = cent[p][w] * (1.0 - con_factor)
+                            + at(worst[w], p)[w] * con_factor;
+                        break;
+                }
+            }
+        }
+        batch_f(as_coords(trial), second.data(), lanes, trial_res.data());
+
+        for (std::size_t w = 0; w < lanes; ++w) {
+            shrink[w] = 0;
+            if (!active[w])
+                continue;
+
+            double rr = reflect_res[w], tr = trial_res[w];
+            switch (step[w]) {
+                case expand:
+                    if (tr < rr)
+                        replace_worst(w, trial, tr);
+                    else
+                        replace_worst(w, reflect, rr);
+                    best[w] = worst[w];
+                    worst[w] = first_max(w);
+                    centroid(w);
+                    break;
+                case accept:
+                    replace_worst(w, reflect, rr);
+                    worst[w] = first_max(w);
+                    centroid(w);
+                    break;
+                case outside:
+                case inside:
+                    if (step[w] == outside
+                            ? tr <= rr : tr < f_of(worst[w], w)) {
+                        replace_worst(w, trial, tr);
+                        worst[w] = first_max(w);
+                        centroid(w);
+                    } else {
+                        shrink[w] = 1;
+                    }
+                    break;
+            }
+        }
+
+        // shrink everything toward best, in the lanes which need it
+        if (std::find(shrink.begin(), shrink.end(), 1) != shrink.end()) {
+            for (std::size_t w = 0; w < lanes; ++w) {
+                if (!shrink[w])
+                    continue;
+                for (std::size_t v = 0; v < vertices; ++v)
+                    if (v != best[w])
+                        for (std::size_t p = 0; p < n; ++p)
+                            at(v, p)[w] = at(best[w], p)[w]
+                                * (1.0 - shr_factor)
+                                + at(v, p)[w] * shr_factor;
+            }
+            evaluate_vertices(shrink);
+            for (std::size_t w = 0; w < lanes; ++w) {
+                if (shrink[w]) {
+                    extrema(w);
+                    centroid(w);
+                }
+            }
+        }
+
+        for (std::size_t w = 0; w < lanes; ++w) {
+            if (!active[w])
+                continue;
+            if (f_of(worst[w], w) - f_of(best[w], w) < term_eps)
+                ++converged[w];
+            else
+                converged[w] = 0;
+            if (converged[w] >= term_iter)
+                active[w] = 0;
+        }
+    }
+
+    std::vector<tuple_type> result;
+    result.reserve(lanes);
+    for (std::size_t w = 0; w < lanes; ++w) {
+        std::array<double, n> a;
+        for (std::size_t p = 0; p < n; ++p)
+            a[p] = at(best[w], p)[w];
+        result.push_back(detail::array_to_tuple<tuple_type>(a));
+    }
+    return result;
+}
+
 }
 
 #endif
@@ -2,7 +2,13 @@
 #define DECLINE_HPP
 
 #include "convex.hpp"
+#include "dual.hpp"
 #include "hyperbolic.hpp"
+#include "profile.hpp"
+#include "tuple_tools.hpp"
+#include <array>
+#include <tuple>
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -20,24 +26,28 @@ inline double convert_decline(double D, double b = 1.0) noexcept;
 template<> inline
 double convert_decline<nominal, nominal>(double D, double) noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     return D;
 }
 
 template<> inline
 double convert_decline<nominal, tangent_effective>(double D, double) noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     return -std::expm1(-D);
 }
 
 template<> inline
 double convert_decline<tangent_effective, nominal>(double D, double) noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     return -std::log1p(-D);
 }
 
 template<> inline
 double convert_decline<nominal, secant_effective>(double D, double b) noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     if (std::abs(b) < std::numeric_limits<double>::epsilon())
         return convert_decline<nominal, tangent_effective>(D);
 
@@ -54,6 +64,7 @@ double convert_decline<nominal, secant_effective>(double D, double b) noexcept
 template<> inline
 double convert_decline<secant_effective, nominal>(double D, double b) noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     if (std::abs(b) < std::numeric_limits<double>::epsilon())
         return convert_decline<tangent_effective, nominal>(D);
 
@@ -70,6 +81,7 @@ template<> inline
 double convert_decline<secant_effective, tangent_effective>(double D, double b)
   noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     double dnom = convert_decline<secant_effective, nominal>(D, b);
     auto exp = arps_exponential(1.0, dnom);
     return 1.0 - exp.rate(1.0);
@@ -79,6 +91,7 @@ template<> inline
 double convert_decline<tangent_effective, tangent_effective>(double D, double)
   noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     return D;
 }
 
@@ -86,6 +99,7 @@ template<> inline
 double convert_decline<tangent_effective, secant_effective>(double D, double b)
   noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     double dnom = convert_decline<tangent_effective, nominal>(D);
     auto hyp = arps_hyperbolic(1.0, dnom, b);
     return 1.0 - hyp.rate(1.0);
@@ -95,6 +109,7 @@ template<> inline
 double convert_decline<secant_effective, secant_effective>(double D, double)
   noexcept
 {
+    DCA_PROFILE_COUNT(convert_decline);
     return D;
 }
 
@@ -128,9 +143,46 @@ inline double eur(const Decline& decline, double economic_limit,
     return decline.cumulative(t_eur);
 }
 
+/*
+ * gradient of EUR w.r.t. the decline parameters; accounts for the time to
+ * the economic limit moving with the parameters (unless capped by max_time)
+ */
+template<class Decline, class... Params>
+inline std::array<double, sizeof...(Params)> eur_gradient(
+        const std::tuple<Params...>& params, double economic_limit,
+        double max_time = std::numeric_limits<double>::infinity(),
+        double* eur_value = nullptr)
+{
+    auto decl = tuple::construct<Decline>(params);
+    double t_eur;
+    double ultimate = eur(decl, economic_limit, max_time, &t_eur);
+    if (eur_value) *eur_value = ultimate;
+
+    auto ad_decl = tuple::construct<
+        detail::rebind_real_t<Decline, dual<sizeof...(Params)>>>(
+                seed_duals(params));
+    auto gradient = ad_decl.cumulative(t_eur).gradient();
+
+    if (t_eur < max_time) {
+        // dt/dp = -(dq/dp) / (dq/dt) at the economic limit
+        auto q = ad_decl.rate(t_eur);
+        double h = std::sqrt(std::numeric_limits<double>::epsilon())
+            * std::max(1.0, t_eur);
+        double dq_dt = (t_eur > h)
+            ? (decl.rate(t_eur + h) - decl.rate(t_eur - h)) / (2.0 * h)
+            : (decl.rate(t_eur + h) - decl.rate(t_eur)) / h;
+        if (dq_dt != 0.0)
+            for (std::size_t i = 0; i < gradient.size(); ++i)
+                gradient[i] -= q.value() * q.gradient(i) / dq_dt;
+    }
+
+    return gradient;
+}
+
 template<class Decline>
 inline double time_to_rate(const Decline& decline, double rate) noexcept
 {
+    DCA_PROFILE_SCOPE(time_solve);
     return std::get<0>(convex::nelder_mead([&](double t) {
                 return (t < 0.0)
                   ? std::numeric_limits<double>::infinity()
@@ -143,6 +195,7 @@ inline double time_to_rate(const Decline& decline, double rate) noexcept
 template<class Decline>
 inline double time_to_cumulative(const Decline& decline, double cum) noexcept
 {
+    DCA_PROFILE_SCOPE(time_solve);
     return std::get<0>(convex::nelder_mead([&](double t) {
                 return (t < 0.0)
                   ? std::numeric_limits<double>::infinity()
@@ -0,0 +1,268 @@
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include "bestfit.hpp"
+#include "dual.hpp"
+#include "profile.hpp"
+#include "tuple_tools.hpp"
+
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace dca {
+
+/*
+ * a fit with its goodness of fit against the data it was fit to; rates for
+ * fit_from_rate, interval volumes for fit_from_interval_volume
+ */
+template<class Decline>
+struct fit_result {
+    Decline decline;
+    typename detail::decline_traits<Decline>::params params;
+    fit_status status;
+    std::size_t count; // of observations
+    double sse;
+    double rmse;
+    double r_squared; // 1 - SSE / sum of squares about the mean
+    double mape; // percent, over the nonzero observations
+    std::vector<double> residuals; // observed - fitted, if asked for
+};
+
+namespace detail {
+
+// running sums of one SSE pass, from its residuals
+class residual_sums {
+    public:
+        explicit residual_sums(bool keep_residuals) noexcept
+            : keep_(keep_residuals) { clear(); }
+
+        void clear() noexcept
+        {
+            count_ = nonzero_ = 0;
+            sum_ = sum_sq_ = sse_ = abs_pct_ = 0.0;
+            residuals_.clear();
+        }
+
+        template<class Real>
+        void operator()(double observed, const Real& resid)
+        {
+            double r = real_value(resid);
+            ++count_;
+            sum_ += observed;
+            sum_sq_ += observed * observed;
+            sse_ += r * r;
+            if (observed != 0.0) {
+                ++nonzero_;
+                abs_pct_ += std::abs(r / observed);
+            }
+            if (keep_)
+                residuals_.push_back(r);
+        }
+
+        template<class Decline, class Params>
+        fit_result<Decline> result(const Params& params, fit_status status)
+        {
+            double n = static_cast<double>(count_);
+            double ss = count_ ? sum_sq_ - sum_ * sum_ / n : 0.0;
+            return fit_result<Decline> {
+                tuple::construct<Decline>(params),
+                params,
+                status,
+                count_,
+                sse_,
+                count_ ? std::sqrt(sse_ / n) : 0.0,
+                ss > 0.0 ? 1.0 - sse_ / ss : 0.0,
+                nonzero_ ? 100.0 * abs_pct_ / nonzero_ : 0.0,
+                std::move(residuals_)
+            };
+        }
+
+    private:
+        bool keep_;
+        std::size_t count_, nonzero_;
+        double sum_, sum_sq_, sse_, abs_pct_;
+        std::vector<double> residuals_;
+};
+
+// passes residuals through to sums held elsewhere
+class residual_observer {
+    public:
+        explicit residual_observer(residual_sums& sums) noexcept
+            : sums_(&sums) { }
+
+        template<class Real>
+        void operator()(double observed, const Real& resid)
+        {
+            (*sums_)(observed, resid);
+        }
+
+    private:
+        residual_sums* sums_;
+};
+
+// the sums of one more SSE pass, at the solver's answer x
+template<class Decline, class Params, class Sse>
+inline fit_result<Decline> result_at(const Params& x, fit_status status,
+        bool keep_residuals, Sse sse)
+{
+    residual_sums sums(keep_residuals);
+    sse(tuple::construct<Decline>(x), residual_observer(sums));
+    return sums.template result<Decline>(x, status);
+}
+
+}
+
+/*
+ * as best_from_rate and best_from_interval_volume, with the SSE, RMSE, R^2,
+ * MAPE and (if residuals is true) residuals of the fit, from one more pass
+ * over the data at the solution
+ */
+template<class Decline, class RateIter, class TimeIter>
+inline fit_result<Decline> fit_from_rate(
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin,
+        const fit_options& options = fit_options {},
+        bool residuals = false)
+{
+    DCA_PROFILE_SCOPE(fit);
+    using traits = detail::decline_traits<Decline>;
+
+    auto seed = traits::seed(
+            detail::make_rate_samples(rate_begin, rate_end, time_begin));
+    fit_status status;
+    auto best = detail::minimize(
+            [=](const auto& t) {
+                try {
+                    return detail::sse_against_rate(
+                        tuple::construct<Decline>(t),
+                        rate_begin, rate_end, time_begin);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_rate<Decline>(t,
+                        rate_begin, rate_end, time_begin, gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            seed, traits::bounds(seed), options, &status);
+
+    return detail::result_at<Decline>(best, status, residuals,
+            [&](const Decline& decl, detail::residual_observer observe) {
+                detail::sse_against_rate(decl, rate_begin, rate_end,
+                        time_begin, observe);
+            });
+}
+
+template<class Decline, class VolIter>
+inline fit_result<Decline> fit_from_interval_volume(
+        VolIter vol_begin, VolIter vol_end,
+        double time_initial, double time_step,
+        const fit_options& options = fit_options {},
+        bool residuals = false)
+{
+    DCA_PROFILE_SCOPE(fit);
+    using traits = detail::decline_traits<Decline>;
+
+    auto seed = traits::seed(detail::make_interval_samples(vol_begin, vol_end,
+                time_initial, time_step));
+    fit_status status;
+    auto best = detail::minimize(
+            [=](const auto& t) {
+                try {
+                    return detail::sse_against_interval(
+                        tuple::construct<Decline>(t),
+                        vol_begin, vol_end, time_initial, time_step);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_interval<Decline>(t,
+                        vol_begin, vol_end, time_initial, time_step,
+                        gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            seed, traits::bounds(seed), options, &status);
+
+    return detail::result_at<Decline>(best, status, residuals,
+            [&](const Decline& decl, detail::residual_observer observe) {
+                detail::sse_against_interval(decl, vol_begin, vol_end,
+                        time_initial, time_step, observe);
+            });
+}
+
+// as above, by BFGS from initial (as best_from_*_bfgs), e.g. an earlier fit
+template<class Decline, class RateIter, class TimeIter>
+inline fit_result<Decline> fit_from_rate_bfgs(
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin,
+        const typename detail::decline_traits<Decline>::params& initial,
+        const fit_options& options = fit_options {},
+        bool residuals = false)
+{
+    DCA_PROFILE_SCOPE(fit);
+    fit_status status;
+    auto best = detail::refine(
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_rate<Decline>(t,
+                        rate_begin, rate_end, time_begin, gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            initial, options, &status);
+
+    return detail::result_at<Decline>(best, status, residuals,
+            [&](const Decline& decl, detail::residual_observer observe) {
+                detail::sse_against_rate(decl, rate_begin, rate_end,
+                        time_begin, observe);
+            });
+}
+
+template<class Decline, class VolIter>
+inline fit_result<Decline> fit_from_interval_volume_bfgs(
+        VolIter vol_begin, VolIter vol_end,
+        double time_initial, double time_step,
+        const typename detail::decline_traits<Decline>::params& initial,
+        const fit_options& options = fit_options {},
+        bool residuals = false)
+{
+    DCA_PROFILE_SCOPE(fit);
+    fit_status status;
+    auto best = detail::refine(
+            [=](const auto& t, auto& gradient) {
+                try {
+                    return detail::sse_gradient_against_interval<Decline>(t,
+                        vol_begin, vol_end, time_initial, time_step,
+                        gradient);
+                } catch (...) {
+                    DCA_PROFILE_COUNT(infeasible);
+                    return std::numeric_limits<double>::infinity();
+                }
+            },
+            initial, options, &status);
+
+    return detail::result_at<Decline>(best, status, residuals,
+            [&](const Decline& decl, detail::residual_observer observe) {
+                detail::sse_against_interval(decl, vol_begin, vol_end,
+                        time_initial, time_step, observe);
+            });
+}
+
+}
+
+#endif
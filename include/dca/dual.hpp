@@ -0,0 +1,334 @@
+#ifndef DUAL_HPP
+#define DUAL_HPP
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <cmath>
+#ifndef DCA_NO_IOSTREAMS
+#include <iostream>
+#endif
+
+namespace dca {
+
+/*
+ * forward-mode automatic differentiation: a dual number carries a value
+ * and its gradient with respect to N independent variables
+ */
+template<std::size_t N>
+class dual {
+    public:
+        dual() noexcept;
+        dual(double value) noexcept; // a constant
+        dual(double value, std::size_t index) noexcept; // the index'th variable
+
+        const double& value() const noexcept;
+        const std::array<double, N>& gradient() const noexcept;
+        const double& gradient(std::size_t index) const noexcept;
+
+        dual& operator+=(const dual& other) noexcept;
+        dual& operator-=(const dual& other) noexcept;
+        dual& operator*=(const dual& other) noexcept;
+        dual& operator/=(const dual& other) noexcept;
+
+        friend dual operator-(const dual& x) noexcept
+        {
+            return dual(-x.value_, x.grad_, -1.0);
+        }
+
+        friend dual operator+(dual x, const dual& y) noexcept
+        {
+            return x += y;
+        }
+
+        friend dual operator+(dual x, double y) noexcept
+        {
+            x.value_ += y;
+            return x;
+        }
+
+        friend dual operator+(double x, dual y) noexcept
+        {
+            y.value_ += x;
+            return y;
+        }
+
+        friend dual operator-(dual x, const dual& y) noexcept
+        {
+            return x -= y;
+        }
+
+        friend dual operator-(dual x, double y) noexcept
+        {
+            x.value_ -= y;
+            return x;
+        }
+
+        friend dual operator-(double x, const dual& y) noexcept
+        {
+            return dual(x - y.value_, y.grad_, -1.0);
+        }
+
+        friend dual operator*(dual x, const dual& y) noexcept
+        {
+            return x *= y;
+        }
+
+        friend dual operator*(const dual& x, double y) noexcept
+        {
+            return dual(x.value_ * y, x.grad_, y);
+        }
+
+        friend dual operator*(double x, const dual& y) noexcept
+        {
+            return dual(x * y.value_, y.grad_, x);
+        }
+
+        friend dual operator/(dual x, const dual& y) noexcept
+        {
+            return x /= y;
+        }
+
+        friend dual operator/(const dual& x, double y) noexcept
+        {
+            return dual(x.value_ / y, x.grad_, 1.0 / y);
+        }
+
+        friend dual operator/(double x, const dual& y) noexcept
+        {
+            double value = x / y.value_;
+            return dual(value, y.grad_, -value / y.value_);
+        }
+
+        friend bool operator<(const dual& x, const dual& y) noexcept
+        {
+            return x.value_ < y.value_;
+        }
+
+        friend bool operator>(const dual& x, const dual& y) noexcept
+        {
+            return x.value_ > y.value_;
+        }
+
+        friend bool operator<=(const dual& x, const dual& y) noexcept
+        {
+            return x.value_ <= y.value_;
+        }
+
+        friend bool operator>=(const dual& x, const dual& y) noexcept
+        {
+            return x.value_ >= y.value_;
+        }
+
+        friend bool operator==(const dual& x, const dual& y) noexcept
+        {
+            return x.value_ == y.value_;
+        }
+
+        friend bool operator!=(const dual& x, const dual& y) noexcept
+        {
+            return x.value_ != y.value_;
+        }
+
+        friend dual exp(const dual& x) noexcept
+        {
+            double value = std::exp(x.value_);
+            return dual(value, x.grad_, value);
+        }
+
+        friend dual expm1(const dual& x) noexcept
+        {
+            return dual(std::expm1(x.value_), x.grad_, std::exp(x.value_));
+        }
+
+        friend dual log(const dual& x) noexcept
+        {
+            return dual(std::log(x.value_), x.grad_, 1.0 / x.value_);
+        }
+
+        friend dual log1p(const dual& x) noexcept
+        {
+            return dual(std::log1p(x.value_), x.grad_, 1.0 / (1.0 + x.value_));
+        }
+
+        friend dual sqrt(const dual& x) noexcept
+        {
+            double value = std::sqrt(x.value_);
+            return dual(value, x.grad_, 0.5 / value);
+        }
+
+        friend dual abs(const dual& x) noexcept
+        {
+            return x.value_ < 0.0 ? -x : x;
+        }
+
+        friend dual pow(const dual& x, double y) noexcept
+        {
+            return dual(std::pow(x.value_, y), x.grad_,
+                    y * std::pow(x.value_, y - 1.0));
+        }
+
+        friend dual pow(double x, const dual& y) noexcept
+        {
+            double value = std::pow(x, y.value_);
+            return dual(value, y.grad_, value * std::log(x));
+        }
+
+        friend dual pow(const dual& x, const dual& y) noexcept
+        {
+            // d(x^y) = y x^(y - 1) dx + x^y log(x) dy
+            double value = std::pow(x.value_, y.value_);
+            dual result(value, x.grad_,
+                    y.value_ * std::pow(x.value_, y.value_ - 1.0));
+            if (x.value_ > 0.0) {
+                double dy = value * std::log(x.value_);
+                for (std::size_t i = 0; i < N; ++i)
+                    result.grad_[i] += dy * y.grad_[i];
+            }
+            return result;
+        }
+
+    private:
+        double value_;
+        std::array<double, N> grad_;
+
+        dual(double value, const std::array<double, N>& grad,
+                double scale) noexcept;
+};
+
+template<std::size_t N>
+inline dual<N>::dual() noexcept
+    : value_(0.0), grad_() { }
+
+template<std::size_t N>
+inline dual<N>::dual(double value) noexcept
+    : value_(value), grad_() { }
+
+template<std::size_t N>
+inline dual<N>::dual(double value, std::size_t index) noexcept
+    : value_(value), grad_()
+{
+    grad_[index] = 1.0;
+}
+
+template<std::size_t N>
+inline dual<N>::dual(double value, const std::array<double, N>& grad,
+        double scale) noexcept
+    : value_(value)
+{
+    for (std::size_t i = 0; i < N; ++i)
+        grad_[i] = grad[i] * scale;
+}
+
+template<std::size_t N>
+inline const double& dual<N>::value() const noexcept
+{
+    return value_;
+}
+
+template<std::size_t N>
+inline const std::array<double, N>& dual<N>::gradient() const noexcept
+{
+    return grad_;
+}
+
+template<std::size_t N>
+inline const double& dual<N>::gradient(std::size_t index) const noexcept
+{
+    return grad_[index];
+}
+
+template<std::size_t N>
+inline dual<N>& dual<N>::operator+=(const dual& other) noexcept
+{
+    value_ += other.value_;
+    for (std::size_t i = 0; i < N; ++i)
+        grad_[i] += other.grad_[i];
+    return *this;
+}
+
+template<std::size_t N>
+inline dual<N>& dual<N>::operator-=(const dual& other) noexcept
+{
+    value_ -= other.value_;
+    for (std::size_t i = 0; i < N; ++i)
+        grad_[i] -= other.grad_[i];
+    return *this;
+}
+
+template<std::size_t N>
+inline dual<N>& dual<N>::operator*=(const dual& other) noexcept
+{
+    for (std::size_t i = 0; i < N; ++i)
+        grad_[i] = grad_[i] * other.value_ + value_ * other.grad_[i];
+    value_ *= other.value_;
+    return *this;
+}
+
+template<std::size_t N>
+inline dual<N>& dual<N>::operator/=(const dual& other) noexcept
+{
+    value_ /= other.value_;
+    for (std::size_t i = 0; i < N; ++i)
+        grad_[i] = (grad_[i] - value_ * other.grad_[i]) / other.value_;
+    return *this;
+}
+
+#ifndef DCA_NO_IOSTREAMS
+template<std::size_t N>
+inline std::ostream& operator<<(std::ostream& os, const dual<N>& d)
+{
+    return os << d.value();
+}
+#endif
+
+namespace detail {
+
+template<class Decline, class Real>
+struct rebind_real {
+};
+
+// arps_hyperbolic -> basic_arps_hyperbolic<dual<3>>, etc.
+template<template<class> class Decline, class From, class Real>
+struct rebind_real<Decline<From>, Real> {
+    using type = Decline<Real>;
+};
+
+template<class Decline, class Real>
+using rebind_real_t = typename rebind_real<Decline, Real>::type;
+
+template<class Tuple, std::size_t... I>
+inline auto seed_duals_impl(const Tuple& t, std::index_sequence<I...>)
+{
+    return std::make_tuple(
+            dual<sizeof...(I)>(static_cast<double>(std::get<I>(t)), I)...);
+}
+
+}
+
+// the value of a real, dual or not
+inline double real_value(double x) noexcept
+{
+    return x;
+}
+
+template<std::size_t N>
+inline double real_value(const dual<N>& x) noexcept
+{
+    return x.value();
+}
+
+// make each element of a parameter tuple an independent variable
+template<class... Params>
+inline std::tuple<decltype((void)std::declval<Params>(),
+        dual<sizeof...(Params)>())...>
+seed_duals(const std::tuple<Params...>& params) noexcept
+{
+    return detail::seed_duals_impl(params,
+            std::make_index_sequence<sizeof...(Params)>());
+}
+
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef DUONG_HPP
+#define DUONG_HPP
+
+#include "codec.hpp"
+#include "profile.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#ifndef DCA_NO_IOSTREAMS
+#include <iostream>
+#endif
+
+namespace dca {
+
+/*
+ * Duong's fracture-flow model: q / Np = a t^-m, so
+ *
+ *     q = q1 t^-m exp(a g(t)),   Np = q1 / a * (exp(a g(t)) - exp(-a / u))
+ *
+ * with u = 1 - m and g(t) = (t^u - 1) / u (ln t at m = 1). the exp(-a / u)
+ * term is Np's limit at t = 0, zero for m >= 1.
+ */
+template<class Real>
+class basic_duong {
+    public:
+        basic_duong(Real q1, Real a, Real m);
+
+        const Real& q1() const noexcept;
+        const Real& a() const noexcept;
+        const Real& m() const noexcept;
+
+        Real rate(Real time) const noexcept;
+        Real cumulative(Real time) const noexcept;
+        Real D(Real time) const noexcept;
+
+    private:
+        Real q1_;
+        Real a_;
+        Real m_;
+
+        Real g(Real log_time) const noexcept;
+
+        static constexpr double eps_ = 1e-5;
+};
+
+using duong = basic_duong<double>;
+
+template<class Real>
+inline basic_duong<Real>::basic_duong(Real q1, Real a, Real m)
+    : q1_(q1), a_(a), m_(m)
+{
+    if (q1_ < 0.0)
+        throw std::out_of_range("q1 must be non-negative.");
+    if (!(a_ > 0.0))
+        throw std::out_of_range("a must be positive.");
+    if (m_ < 0.0)
+        throw std::out_of_range("m must be non-negative.");
+    if (m_ > 3.0)
+        throw std::out_of_range("m is implausibly high.");
+}
+
+template<class Real>
+inline const Real& basic_duong<Real>::q1() const noexcept
+{
+    return q1_;
+}
+
+template<class Real>
+inline const Real& basic_duong<Real>::a() const noexcept
+{
+    return a_;
+}
+
+template<class Real>
+inline const Real& basic_duong<Real>::m() const noexcept
+{
+    return m_;
+}
+
+template<class Real>
+inline Real basic_duong<Real>::rate(Real time) const noexcept
+{
+    using std::exp;
+    using std::log;
+
+    DCA_PROFILE_COUNT(rate);
+    if (time <= 0.0) return 0.0;
+    Real log_time = log(time);
+    return q1_ * exp(a_ * g(log_time) - m_ * log_time);
+}
+
+template<class Real>
+inline Real basic_duong<Real>::cumulative(Real time) const noexcept
+{
+    using std::exp;
+    using std::log;
+
+    DCA_PROFILE_COUNT(cumulative);
+    if (time <= 0.0) return 0.0;
+    Real u = 1.0 - m_;
+    Real np = exp(a_ * g(log(time)));
+    if (u > eps_)
+        np -= exp(-a_ / u);
+    return q1_ / a_ * np;
+}
+
+template<class Real>
+inline Real basic_duong<Real>::D(Real time) const noexcept
+{
+    using std::pow;
+
+    return m_ / time - a_ * pow(time, -m_);
+}
+
+template<class Real>
+inline Real basic_duong<Real>::g(Real log_time) const noexcept
+{
+    using std::abs;
+    using std::expm1;
+
+    Real u = 1.0 - m_;
+    if (abs(u) < eps_) // first-order in u; keeps the m-derivative at m = 1
+        return log_time * (1.0 + 0.5 * u * log_time);
+    return expm1(u * log_time) / u;
+}
+
+/*
+ * the span of time over which a Duong rate falls. d ln q / d ln t is
+ * a t^(1 - m) - m, so for m > 1 the rate climbs to a peak at
+ * (a / m)^(1 / (m - 1)) and declines from there on; for m < 1 it falls to
+ * a trough at (m / a)^(1 / (1 - m)) and climbs again. an unbounded end, or
+ * the start of a span that never comes, is max() for lack of inf.
+ */
+inline std::pair<double, double> declining_span(const duong& decline) noexcept
+{
+    using std::abs;
+    using std::exp;
+    using std::log;
+
+    const double never = std::numeric_limits<double>::max();
+    double a = decline.a(), m = decline.m(), u = 1.0 - m;
+    if (!(m > 0.0)) // q = q1 exp(a g(t)) only climbs
+        return std::make_pair(never, never);
+    if (abs(u) < 1e-5) // a power law, t^(a - 1)
+        return a > 1.0 ? std::make_pair(never, never)
+                       : std::make_pair(0.0, never);
+    double turn = exp(log(m / a) / u);
+    return u < 0.0 ? std::make_pair(turn, never) : std::make_pair(0.0, turn);
+}
+
+/*
+ * the time at which a Duong rate falls through rate, on its declining span;
+ * zero if it never climbs above rate, max() if it never falls through it.
+ * the generic Nelder-Mead search would find the crossing on the climb.
+ */
+inline double time_to_rate(const duong& decline, double rate) noexcept
+{
+    DCA_PROFILE_SCOPE(time_solve);
+    const double never = std::numeric_limits<double>::max();
+    auto span = declining_span(decline);
+    double lo = span.first, hi = span.second;
+    if (lo >= never)
+        return never;
+    if (lo > 0.0 && !(decline.rate(lo) > rate))
+        return 0.0;
+
+    if (hi < never) {
+        if (!(decline.rate(hi) < rate))
+            return never;
+    } else {
+        hi = std::max(2.0 * lo, 1.0);
+        while (decline.rate(hi) > rate) {
+            if (hi > 0.25 * never)
+                return never;
+            lo = hi;
+            hi *= 2.0;
+        }
+    }
+
+    for (int i = 0; i < 200 && hi - lo > 1e-12 * hi; ++i) {
+        double t = 0.5 * (lo + hi);
+        if (decline.rate(t) > rate)
+            lo = t;
+        else
+            hi = t;
+    }
+    return 0.5 * (lo + hi);
+}
+
+#ifndef DCA_NO_IOSTREAMS
+template<class Real>
+inline std::ostream& operator<<(std::ostream& os, const basic_duong<Real>& d)
+{
+    return os << "<Duong decline: (q1 = " << d.q1() << ", a = " << d.a()
+        << ", m = " << d.m() << ")>";
+}
+#endif
+
+template<>
+struct decline_codec<duong> {
+    static constexpr std::size_t width = 3;
+
+    static decline_tag tag(const duong&) noexcept
+    {
+        return decline_tag::duong;
+    }
+
+    static std::size_t encode(const duong& d, double* params) noexcept
+    {
+        params[0] = d.q1();
+        params[1] = d.a();
+        params[2] = d.m();
+        return width;
+    }
+
+    static duong decode(decline_tag tag, const double* params)
+    {
+        detail::check_tag(tag, decline_tag::duong);
+        return duong(params[0], params[1], params[2]);
+    }
+};
+
+#ifdef DCA_EXTERN_TEMPLATES // compiled into libdca.a
+extern template class basic_duong<double>;
+#endif
+
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef EXPONENTIAL_HPP
 #define EXPONENTIAL_HPP
 
+#include "codec.hpp"
+#include "profile.hpp"
 #include <stdexcept>
 #include <cmath>
 #ifndef DCA_NO_IOSTREAMS
@@ -9,24 +11,47 @@
 
 namespace dca {
 
-class arps_exponential {
+template<class Real>
+class basic_arps_exponential {
     public:
-        arps_exponential(double qi, double D);
+        basic_arps_exponential(Real qi, Real D);
 
-        const double& qi() const noexcept;
-        const double& D() const noexcept;
+        const Real& qi() const noexcept;
+        const Real& D() const noexcept;
 
-        double rate(double time) const noexcept;
-        double cumulative(double time) const noexcept;
+        Real rate(Real time) const noexcept;
+        Real cumulative(Real time) const noexcept;
 
     private:
-        double qi_;
-        double D_;
-
-        static constexpr double eps_ = 1e-5;
+        Real qi_;
+        Real D_;
 };
 
-inline arps_exponential::arps_exponential(double qi, double D)
+using arps_exponential = basic_arps_exponential<double>;
+
+namespace detail {
+
+const double series_cutoff = 1e-3; // series below, truncation error < 1e-16
+
+// expm1(z) / z
+template<class Real>
+inline Real expm1_ratio(const Real& z) noexcept
+{
+    using std::abs;
+    using std::expm1;
+
+    bool small = abs(z) < series_cutoff;
+    Real safe = small ? Real(1.0) : z;
+    Real series = 1.0 + z * (0.5 + z * (1.0 / 6.0 + z * (1.0 / 24.0
+                    + z * (1.0 / 120.0))));
+    Real ratio = expm1(safe) / safe;
+    return small ? series : ratio;
+}
+
+}
+
+template<class Real>
+inline basic_arps_exponential<Real>::basic_arps_exponential(Real qi, Real D)
     : qi_(qi), D_(D)
 {
     if (qi_ < 0.0)
@@ -35,38 +60,76 @@ inline arps_exponential::arps_exponential(double qi, double D)
         throw std::out_of_range("D must be non-negative.");
 }
 
-inline const double& arps_exponential::qi() const noexcept
+template<class Real>
+inline const Real& basic_arps_exponential<Real>::qi() const noexcept
 {
     return qi_;
 }
 
-inline const double& arps_exponential::D() const noexcept
+template<class Real>
+inline const Real& basic_arps_exponential<Real>::D() const noexcept
 {
     return D_;
 }
 
-inline double arps_exponential::rate(double time) const noexcept
+template<class Real>
+inline Real basic_arps_exponential<Real>::rate(Real time) const noexcept
 {
+    using std::exp;
+
+    DCA_PROFILE_COUNT(rate);
     if (time < 0.0) return 0.0;
-    return qi_ * std::exp(-D_ * time);
+    return qi_ * exp(-D_ * time);
 }
 
-inline double arps_exponential::cumulative(double time) const noexcept
+template<class Real>
+inline Real basic_arps_exponential<Real>::cumulative(Real time) const
+  noexcept
 {
+    DCA_PROFILE_COUNT(cumulative);
     if (time < 0.0) return 0.0;
-    if (D_ < eps_)
-        return qi_ * time;
-    return qi_ / D_ * (1.0 - std::exp(-D_ * time));
+    // qi (1 - exp(-D t)) / D, well-defined (with its D-derivative) at D = 0
+    return qi_ * time * detail::expm1_ratio(-D_ * time);
 }
 
 #ifndef DCA_NO_IOSTREAMS
-inline std::ostream& operator<<(std::ostream& os, const arps_exponential& d)
+template<class Real>
+inline std::ostream& operator<<(std::ostream& os,
+        const basic_arps_exponential<Real>& d)
 {
     return os << "<Arps exponential decline: (qi = " << d.qi() << ", D = "
         << d.D() << ")>";
 }
 #endif
 
+template<>
+struct decline_codec<arps_exponential> {
+    static constexpr std::size_t width = 2;
+
+    static decline_tag tag(const arps_exponential&) noexcept
+    {
+        return decline_tag::arps_exponential;
+    }
+
+    static std::size_t encode(const arps_exponential& d, double* params)
+        noexcept
+    {
+        params[0] = d.qi();
+        params[1] = d.D();
+        return width;
+    }
+
+    static arps_exponential decode(decline_tag tag, const double* params)
+    {
+        detail::check_tag(tag, decline_tag::arps_exponential);
+        return arps_exponential(params[0], params[1]);
+    }
+};
+
+#ifdef DCA_EXTERN_TEMPLATES // compiled into libdca.a
+extern template class basic_arps_exponential<double>;
+#endif
+
 }
 
 #endif
@@ -0,0 +1,302 @@
+#ifndef FORECAST_HPP
+#define FORECAST_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace dca {
+
+// one step of a forecast grid; time is the end of the step
+struct forecast_step {
+    std::size_t index;
+    double time;
+    double rate; // at time
+    double cumulative; // at time
+    double volume; // over the step
+};
+
+/*
+ * steps through a decline's forecast on a time grid, evaluating each step
+ * only as it's reached (the same volumes as interval_volumes). iteration
+ * ends after the requested number of steps, or at the first step ending
+ * below a minimum rate (e.g. an economic limit), whichever comes first.
+ */
+template<class Decline>
+class forecast_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = forecast_step;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const forecast_step*;
+        using reference = const forecast_step&;
+
+        forecast_iterator() noexcept; // past the end
+        forecast_iterator(std::shared_ptr<const Decline> decline,
+                double time_begin, double time_step, std::size_t steps,
+                double min_rate);
+
+        reference operator*() const noexcept { return step_; }
+        pointer operator->() const noexcept { return &step_; }
+
+        forecast_iterator& operator++();
+        forecast_iterator operator++(int);
+
+        bool operator==(const forecast_iterator& other) const noexcept;
+        bool operator!=(const forecast_iterator& other) const noexcept;
+
+    private:
+        void evaluate(double cumulative_before);
+
+        std::shared_ptr<const Decline> decline_;
+        double time_begin_;
+        double time_step_;
+        std::size_t steps_;
+        double min_rate_;
+        forecast_step step_;
+        bool end_;
+};
+
+// a single field of each step: rate, cumulative or volume
+template<class Decline>
+class forecast_field_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = double;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const double*;
+        using reference = const double&;
+
+        forecast_field_iterator() noexcept : field_(nullptr) { }
+        forecast_field_iterator(forecast_iterator<Decline> it,
+                double forecast_step::* field) noexcept
+            : it_(it), field_(field) { }
+
+        reference operator*() const noexcept { return (*it_).*field_; }
+        pointer operator->() const noexcept { return &**this; }
+
+        forecast_field_iterator& operator++() { ++it_; return *this; }
+        forecast_field_iterator operator++(int)
+        {
+            auto old = *this;
+            ++it_;
+            return old;
+        }
+
+        bool operator==(const forecast_field_iterator& other) const noexcept
+        {
+            return it_ == other.it_;
+        }
+
+        bool operator!=(const forecast_field_iterator& other) const noexcept
+        {
+            return it_ != other.it_;
+        }
+
+    private:
+        forecast_iterator<Decline> it_;
+        double forecast_step::* field_;
+};
+
+template<class Iter>
+class forecast_view {
+    public:
+        forecast_view(Iter begin, Iter end) : begin_(begin), end_(end) { }
+
+        Iter begin() const { return begin_; }
+        Iter end() const { return end_; }
+
+    private:
+        Iter begin_;
+        Iter end_;
+};
+
+/*
+ * a lazy forecast over a copy of the decline, shared with its iterators
+ * (so they may outlive the range, e.g. a temporary). until_rate and take
+ * narrow the range without evaluating anything; rates, cumulatives and
+ * volumes view one field of each step, e.g. to zip with a price deck via
+ * std::inner_product.
+ */
+template<class Decline>
+class forecast_range {
+    public:
+        static const std::size_t unbounded =
+            std::numeric_limits<std::size_t>::max();
+
+        forecast_range(const Decline& decline, double time_begin,
+                double time_step, std::size_t steps = unbounded,
+                double min_rate = -std::numeric_limits<double>::max());
+
+        forecast_iterator<Decline> begin() const;
+        forecast_iterator<Decline> end() const noexcept;
+
+        forecast_range until_rate(double min_rate) const;
+        forecast_range take(std::size_t steps) const;
+
+        forecast_view<forecast_field_iterator<Decline>> rates() const;
+        forecast_view<forecast_field_iterator<Decline>> cumulatives() const;
+        forecast_view<forecast_field_iterator<Decline>> volumes() const;
+
+    private:
+        forecast_view<forecast_field_iterator<Decline>> field(
+                double forecast_step::* f) const;
+
+        std::shared_ptr<const Decline> decline_;
+        double time_begin_;
+        double time_step_;
+        std::size_t steps_;
+        double min_rate_;
+};
+
+template<class Decline>
+const std::size_t forecast_range<Decline>::unbounded;
+
+template<class Decline>
+inline forecast_range<Decline> forecast(const Decline& decline,
+        double time_begin, double time_step,
+        std::size_t steps = forecast_range<Decline>::unbounded)
+{
+    return forecast_range<Decline>(decline, time_begin, time_step, steps);
+}
+
+template<class Decline>
+inline forecast_iterator<Decline>::forecast_iterator() noexcept
+    : time_begin_(0.0), time_step_(0.0), steps_(0),
+      min_rate_(0.0), step_(), end_(true) { }
+
+template<class Decline>
+inline forecast_iterator<Decline>::forecast_iterator(
+        std::shared_ptr<const Decline> decline, double time_begin,
+        double time_step, std::size_t steps, double min_rate)
+    : decline_(std::move(decline)), time_begin_(time_begin),
+      time_step_(time_step), steps_(steps), min_rate_(min_rate), step_(),
+      end_(steps == 0)
+{
+    if (!end_) {
+        step_.index = 0;
+        evaluate(decline_->cumulative(time_begin));
+    }
+}
+
+template<class Decline>
+inline void forecast_iterator<Decline>::evaluate(double cumulative_before)
+{
+    // from the grid origin, so time doesn't drift over long forecasts
+    step_.time = time_begin_ + (step_.index + 1) * time_step_;
+    step_.rate = decline_->rate(step_.time);
+    step_.cumulative = decline_->cumulative(step_.time);
+    step_.volume = step_.cumulative - cumulative_before;
+    end_ = step_.rate < min_rate_;
+}
+
+template<class Decline>
+inline forecast_iterator<Decline>& forecast_iterator<Decline>::operator++()
+{
+    if (++step_.index == steps_)
+        end_ = true;
+    else
+        evaluate(step_.cumulative);
+    return *this;
+}
+
+template<class Decline>
+inline forecast_iterator<Decline> forecast_iterator<Decline>::operator++(int)
+{
+    auto old = *this;
+    ++*this;
+    return old;
+}
+
+template<class Decline>
+inline bool forecast_iterator<Decline>::operator==(
+        const forecast_iterator& other) const noexcept
+{
+    if (end_ || other.end_)
+        return end_ == other.end_;
+    return step_.index == other.step_.index;
+}
+
+template<class Decline>
+inline bool forecast_iterator<Decline>::operator!=(
+        const forecast_iterator& other) const noexcept
+{
+    return !(*this == other);
+}
+
+template<class Decline>
+inline forecast_range<Decline>::forecast_range(const Decline& decline,
+        double time_begin, double time_step, std::size_t steps,
+        double min_rate)
+    : decline_(std::make_shared<const Decline>(decline)),
+      time_begin_(time_begin), time_step_(time_step), steps_(steps),
+      min_rate_(min_rate) { }
+
+template<class Decline>
+inline forecast_iterator<Decline> forecast_range<Decline>::begin() const
+{
+    return forecast_iterator<Decline>(decline_, time_begin_, time_step_,
+            steps_, min_rate_);
+}
+
+template<class Decline>
+inline forecast_iterator<Decline> forecast_range<Decline>::end()
+  const noexcept
+{
+    return forecast_iterator<Decline>();
+}
+
+template<class Decline>
+inline forecast_range<Decline> forecast_range<Decline>::until_rate(
+        double min_rate) const
+{
+    auto result = *this;
+    result.min_rate_ = std::max(min_rate_, min_rate);
+    return result;
+}
+
+template<class Decline>
+inline forecast_range<Decline> forecast_range<Decline>::take(
+        std::size_t steps) const
+{
+    auto result = *this;
+    result.steps_ = std::min(steps_, steps);
+    return result;
+}
+
+template<class Decline>
+inline forecast_view<forecast_field_iterator<Decline>>
+forecast_range<Decline>::rates() const
+{
+    return field(&forecast_step::rate);
+}
+
+template<class Decline>
+inline forecast_view<forecast_field_iterator<Decline>>
+forecast_range<Decline>::cumulatives() const
+{
+    return field(&forecast_step::cumulative);
+}
+
+template<class Decline>
+inline forecast_view<forecast_field_iterator<Decline>>
+forecast_range<Decline>::volumes() const
+{
+    return field(&forecast_step::volume);
+}
+
+template<class Decline>
+inline forecast_view<forecast_field_iterator<Decline>>
+forecast_range<Decline>::field(double forecast_step::* f) const
+{
+    return forecast_view<forecast_field_iterator<Decline>>(
+            forecast_field_iterator<Decline>(begin(), f),
+            forecast_field_iterator<Decline>(end(), f));
+}
+
+}
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace dca {
+
+namespace detail {
+
+/*
+ * Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers", 2010): integer-only shortest-digit generation. output
+ * always round-trips and is the shortest possible for ~99.9% of doubles
+ * (otherwise one digit longer).
+ */
+struct diy_fp {
+    std::uint64_t f;
+    int e;
+
+    diy_fp(std::uint64_t f, int e) noexcept : f(f), e(e) { }
+
+    explicit diy_fp(double d) noexcept
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        int biased_e = static_cast<int>((bits >> 52) & 0x7FF);
+        std::uint64_t significand = bits & ((std::uint64_t(1) << 52) - 1);
+        if (biased_e != 0) {
+            f = significand + (std::uint64_t(1) << 52);
+            e = biased_e - 1075;
+        } else {
+            f = significand;
+            e = -1074;
+        }
+    }
+
+    diy_fp operator-(const diy_fp& rhs) const noexcept
+    {
+        return diy_fp(f - rhs.f, e);
+    }
+
+    // 64 x 64 -> upper 64 bits, rounded
+    diy_fp operator*(const diy_fp& rhs) const noexcept
+    {
+        const std::uint64_t m32 = 0xFFFFFFFFu;
+        std::uint64_t a = f >> 32, b = f & m32;
+        std::uint64_t c = rhs.f >> 32, d = rhs.f & m32;
+        std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        std::uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+        tmp += std::uint64_t(1) << 31;
+        return diy_fp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),
+                e + rhs.e + 64);
+    }
+
+    diy_fp normalize() const noexcept
+    {
+        diy_fp res = *this;
+        while (!(res.f & (std::uint64_t(1) << 63))) {
+            res.f <<= 1;
+            --res.e;
+        }
+        return res;
+    }
+
+    diy_fp normalize_boundary() const noexcept
+    {
+        diy_fp res = *this;
+        while (!(res.f & (std::uint64_t(1) << 53))) {
+            res.f <<= 1;
+            --res.e;
+        }
+        res.f <<= 10;
+        res.e -= 10;
+        return res;
+    }
+
+    void normalized_boundaries(diy_fp& minus, diy_fp& plus) const noexcept
+    {
+        plus = diy_fp((f << 1) + 1, e - 1).normalize_boundary();
+        minus = (f == (std::uint64_t(1) << 52))
+            ? diy_fp((f << 2) - 1, e - 2)
+            : diy_fp((f << 1) - 1, e - 1);
+        minus.f <<= minus.e - plus.e;
+        minus.e = plus.e;
+    }
+};
+
+// 10^k for k = -348, -340, ..., 340, normalized
+inline diy_fp cached_power(int e, int& k) noexcept
+{
+    static const std::uint64_t f[] = {
+        UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76),
+        UINT64_C(0x8b16fb203055ac76), UINT64_C(0xcf42894a5dce35ea),
+        UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df),
+        UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f),
+        UINT64_C(0xbe5691ef416bd60c), UINT64_C(0x8dd01fad907ffc3c),
+        UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+        UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d),
+        UINT64_C(0x823c12795db6ce57), UINT64_C(0xc21094364dfb5637),
+        UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7),
+        UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5),
+        UINT64_C(0xb23867fb2a35b28e), UINT64_C(0x84c8d4dfd2c63f3b),
+        UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+        UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6),
+        UINT64_C(0xf3e2f893dec3f126), UINT64_C(0xb5b5ada8aaff80b8),
+        UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053),
+        UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd),
+        UINT64_C(0xa6dfbd9fb8e5b88f), UINT64_C(0xf8a95fcf88747d94),
+        UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+        UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac),
+        UINT64_C(0xe45c10c42a2b3b06), UINT64_C(0xaa242499697392d3),
+        UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb),
+        UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c),
+        UINT64_C(0x9c40000000000000), UINT64_C(0xe8d4a51000000000),
+        UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+        UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70),
+        UINT64_C(0xd5d238a4abe98068), UINT64_C(0x9f4f2726179a2245),
+        UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8),
+        UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a),
+        UINT64_C(0x924d692ca61be758), UINT64_C(0xda01ee641a708dea),
+        UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+        UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2),
+        UINT64_C(0xc83553c5c8965d3d), UINT64_C(0x952ab45cfa97a0b3),
+        UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25),
+        UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece),
+        UINT64_C(0x88fcf317f22241e2), UINT64_C(0xcc20ce9bd35c78a5),
+        UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+        UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c),
+        UINT64_C(0xbb764c4ca7a44410), UINT64_C(0x8bab8eefb6409c1a),
+        UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129),
+        UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429),
+        UINT64_C(0x80444b5e7aa7cf85), UINT64_C(0xbf21e44003acdd2d),
+        UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+        UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9),
+        UINT64_C(0xaf87023b9bf0ee6b)
+    };
+    static const std::int16_t binary_e[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+        -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+        -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+        -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+        -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+        109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+        375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+        641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+        907, 933, 960, 986, 1013, 1039, 1066
+    };
+
+    // smallest k with the product's exponent in [-60, -32]
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = static_cast<int>(dk);
+    if (dk - ik > 0.0)
+        ++ik;
+    auto index = static_cast<unsigned>((ik >> 3) + 1);
+    k = -(-348 + static_cast<int>(index << 3));
+    return diy_fp(f[index], binary_e[index]);
+}
+
+inline void grisu_round(char* buffer, int length, std::uint64_t delta,
+        std::uint64_t rest, std::uint64_t ten_kappa, std::uint64_t wp_w)
+  noexcept
+{
+    while (rest < wp_w && delta - rest >= ten_kappa
+            && (rest + ten_kappa < wp_w
+                || wp_w - rest > rest + ten_kappa - wp_w)) {
+        --buffer[length - 1];
+        rest += ten_kappa;
+    }
+}
+
+inline int count_digits(std::uint32_t n) noexcept
+{
+    int digits = 1;
+    while (n >= 10) {
+        n /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+inline void digit_gen(const diy_fp& w, const diy_fp& mp, std::uint64_t delta,
+        char* buffer, int& length, int& k) noexcept
+{
+    static const std::uint32_t pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000
+    };
+
+    const diy_fp one(std::uint64_t(1) << -mp.e, mp.e);
+    const diy_fp wp_w = mp - w;
+    auto p1 = static_cast<std::uint32_t>(mp.f >> -one.e);
+    std::uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = count_digits(p1);
+    length = 0;
+
+    while (kappa > 0) {
+        std::uint32_t d = p1 / pow10[kappa - 1];
+        p1 %= pow10[kappa - 1];
+        if (d || length)
+            buffer[length++] = static_cast<char>('0' + d);
+        --kappa;
+        std::uint64_t tmp = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+        if (tmp <= delta) {
+            k += kappa;
+            grisu_round(buffer, length, delta, tmp,
+                    static_cast<std::uint64_t>(pow10[kappa]) << -one.e,
+                    wp_w.f);
+            return;
+        }
+    }
+
+    while (true) {
+        p2 *= 10;
+        delta *= 10;
+        auto d = static_cast<char>(p2 >> -one.e);
+        if (d || length)
+            buffer[length++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta) {
+            k += kappa;
+            int index = -kappa;
+            grisu_round(buffer, length, delta, p2, one.f,
+                    wp_w.f * (index < 10 ? pow10[index] : 0));
+            return;
+        }
+    }
+}
+
+// digits of a positive, finite value, and its decimal exponent
+inline void grisu2(double value, char* buffer, int& length, int& k) noexcept
+{
+    const diy_fp v(value);
+    diy_fp w_m(0, 0), w_p(0, 0);
+    v.normalized_boundaries(w_m, w_p);
+
+    const diy_fp c_mk = cached_power(w_p.e, k);
+    const diy_fp w = v.normalize() * c_mk;
+    diy_fp wp = w_p * c_mk;
+    diy_fp wm = w_m * c_mk;
+    ++wm.f;
+    --wp.f;
+    digit_gen(w, wp, wp.f - wm.f, buffer, length, k);
+}
+
+}
+
+// room for any double formatted by format_shortest
+const std::size_t max_formatted_length = 25;
+
+/*
+ * write the shortest (see detail::grisu2) text which reads back as
+ * exactly value; plain notation for magnitudes in [1e-6, 1e21), otherwise
+ * scientific. returns the number of characters written (no terminator).
+ */
+inline std::size_t format_shortest(double value, char* out) noexcept
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char* p = out;
+
+    if (bits >> 63) {
+        *p++ = '-';
+        bits &= ~(std::uint64_t(1) << 63);
+        std::memcpy(&value, &bits, sizeof(bits));
+    }
+
+    if (((bits >> 52) & 0x7FF) == 0x7FF) { // checked bitwise: -ffast-math
+        const char* text = (bits & ((std::uint64_t(1) << 52) - 1))
+            ? "nan" : "inf";
+        if (text[0] == 'n')
+            p = out; // no sign on NaN
+        std::memcpy(p, text, 3);
+        return static_cast<std::size_t>(p + 3 - out);
+    }
+
+    if (bits == 0) {
+        *p++ = '0';
+        return static_cast<std::size_t>(p - out);
+    }
+
+    char digits[18];
+    int length, k;
+    detail::grisu2(value, digits, length, k);
+    int point = length + k; // digits[0] is 10^(point - 1)
+
+    if (k >= 0 && point <= 21) {
+        // 1234e7 -> 12340000000
+        std::memcpy(p, digits, static_cast<std::size_t>(length));
+        p += length;
+        for (int i = 0; i < k; ++i)
+            *p++ = '0';
+    } else if (point > 0 && point <= 21) {
+        // 1234e-2 -> 12.34
+        std::memcpy(p, digits, static_cast<std::size_t>(point));
+        p += point;
+        *p++ = '.';
+        std::memcpy(p, digits + point, static_cast<std::size_t>(-k));
+        p += -k;
+    } else if (point > -6 && point <= 0) {
+        // 1234e-6 -> 0.001234
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = point; i < 0; ++i)
+            *p++ = '0';
+        std::memcpy(p, digits, static_cast<std::size_t>(length));
+        p += length;
+    } else {
+        // 1234e30 -> 1.234e33
+        *p++ = digits[0];
+        if (length > 1) {
+            *p++ = '.';
+            std::memcpy(p, digits + 1, static_cast<std::size_t>(length - 1));
+            p += length - 1;
+        }
+        *p++ = 'e';
+        int exp10 = point - 1;
+        if (exp10 < 0) {
+            *p++ = '-';
+            exp10 = -exp10;
+        }
+        if (exp10 >= 100)
+            *p++ = static_cast<char>('0' + exp10 / 100);
+        if (exp10 >= 10)
+            *p++ = static_cast<char>('0' + exp10 / 10 % 10);
+        *p++ = static_cast<char>('0' + exp10 % 10);
+    }
+
+    return static_cast<std::size_t>(p - out);
+}
+
+}
+
+#endif
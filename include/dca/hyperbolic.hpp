@@ -1,7 +1,9 @@
 #ifndef HYPERBOLIC_HPP
 #define HYPERBOLIC_HPP
 
+#include "codec.hpp"
 #include "exponential.hpp"
+#include "profile.hpp"
 #include <stdexcept>
 #include <cmath>
 #ifndef DCA_NO_IOSTREAMS
@@ -10,30 +12,81 @@
 
 namespace dca {
 
-class arps_hyperbolic {
+template<class Real>
+class basic_arps_hyperbolic {
     public:
-        arps_hyperbolic(double qi, double Di, double b);
+        basic_arps_hyperbolic(Real qi, Real Di, Real b);
 
-        const double& qi() const noexcept;
-        const double& Di() const noexcept;
-        const double& b() const noexcept;
+        const Real& qi() const noexcept;
+        const Real& Di() const noexcept;
+        const Real& b() const noexcept;
 
-        double rate(double time) const noexcept;
-        double cumulative(double time) const noexcept;
-        double D(double time) const noexcept;
+        Real rate(Real time) const noexcept;
+        Real cumulative(Real time) const noexcept;
+        Real D(Real time) const noexcept;
 
     private:
-        double qi_;
-        double Di_;
-        double b_;
+        Real qi_;
+        Real Di_;
+        Real b_;
+};
 
-        double harmonic_rate(double time) const noexcept;
-        double harmonic_cumulative(double time) const noexcept;
+using arps_hyperbolic = basic_arps_hyperbolic<double>;
 
-        static constexpr double eps_ = 1e-5;
-};
+namespace detail {
+
+// log1p(y) / y, y >= 0
+template<class Real>
+inline Real log1p_ratio(const Real& y) noexcept
+{
+    using std::log1p;
+
+    bool small = y < series_cutoff;
+    Real safe = small ? Real(1.0) : y;
+    Real series = 1.0 + y * (-0.5 + y * (1.0 / 3.0 + y * (-0.25 + y * 0.2)));
+    Real ratio = log1p(safe) / safe;
+    return small ? series : ratio;
+}
+
+}
+
+/*
+ * the hyperbolic rate and cumulative in one form for all b in [0, 5]
+ * (exponential at b = 0, harmonic at b = 1): with x = Di t and
+ * s = ln(1 + b x) / b = x L(b x),
+ *
+ *     q = qi exp(-s),  Np = qi t L(b x) E((b - 1) s)
+ *
+ * where L(y) = log1p(y) / y and E(z) = expm1(z) / z, each by its series near
+ * 0 (so derivatives survive at b = 0 and b = 1). there's no division by b,
+ * Di or 1 - b and no branch on them, only selects: batches of mixed wells
+ * run straight-line code. both are zero before t = 0.
+ */
+template<class Real>
+inline Real hyperbolic_rate(const Real& qi, const Real& Di, const Real& b,
+        const Real& time) noexcept
+{
+    using std::exp;
 
-inline arps_hyperbolic::arps_hyperbolic(double qi, double Di, double b)
+    Real t = time < 0.0 ? Real(0.0) : time;
+    Real x = Di * t;
+    Real q = qi * exp(-x * detail::log1p_ratio(b * x));
+    return time < 0.0 ? Real(0.0) : q;
+}
+
+template<class Real>
+inline Real hyperbolic_cumulative(const Real& qi, const Real& Di,
+        const Real& b, const Real& time) noexcept
+{
+    Real t = time < 0.0 ? Real(0.0) : time;
+    Real x = Di * t;
+    Real l = detail::log1p_ratio(b * x);
+    return qi * t * l * detail::expm1_ratio((b - 1.0) * x * l);
+}
+
+template<class Real>
+inline basic_arps_hyperbolic<Real>::basic_arps_hyperbolic(
+        Real qi, Real Di, Real b)
     : qi_(qi), Di_(Di), b_(b)
 {
     if (qi_ < 0.0)
@@ -46,64 +99,83 @@ inline arps_hyperbolic::arps_hyperbolic(double qi, double Di, double b)
         throw std::out_of_range("b is implausibly high.");
 }
 
-inline const double& arps_hyperbolic::qi() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic<Real>::qi() const noexcept
 {
     return qi_;
 }
 
-inline const double& arps_hyperbolic::Di() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic<Real>::Di() const noexcept
 {
     return Di_;
 }
 
-inline const double& arps_hyperbolic::b() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic<Real>::b() const noexcept
 {
     return b_;
 }
 
-inline double arps_hyperbolic::rate(double time) const noexcept
+template<class Real>
+inline Real basic_arps_hyperbolic<Real>::rate(Real time) const noexcept
 {
-    if (time < 0.0) return 0.0;
-    if (b_ < eps_) return arps_exponential(qi_, Di_).rate(time);
-    if (std::abs(1.0 - b_) < eps_) return harmonic_rate(time);
-
-    return qi_ * std::pow(1.0 + b_ * Di_ * time, -1.0 / b_);
+    DCA_PROFILE_COUNT(rate);
+    return hyperbolic_rate(qi_, Di_, b_, time);
 }
 
-inline double arps_hyperbolic::cumulative(double time) const noexcept
+template<class Real>
+inline Real basic_arps_hyperbolic<Real>::cumulative(Real time) const noexcept
 {
-    if (time <= 0.0) return 0.0;
-    if (Di_ < eps_) return qi_ * time;
-    if (b_ < eps_) return arps_exponential(qi_, Di_).cumulative(time);
-    if (std::abs(1.0 - b_) < eps_) return harmonic_cumulative(time);
-
-    return qi_ / ((1.0 - b_) * Di_) *
-        (1.0 - std::pow(1.0 + b_ * Di_ * time, 1.0 - (1.0 / b_)));
+    DCA_PROFILE_COUNT(cumulative);
+    return hyperbolic_cumulative(qi_, Di_, b_, time);
 }
 
-inline double arps_hyperbolic::D(double time) const noexcept
+template<class Real>
+inline Real basic_arps_hyperbolic<Real>::D(Real time) const noexcept
 {
     return Di_ / (1.0 + b_ * Di_ * time);
 }
 
-double arps_hyperbolic::harmonic_rate(double time) const noexcept
-{
-    return qi_ / (1.0 + Di_ * time);
-}
-
-double arps_hyperbolic::harmonic_cumulative(double time) const noexcept
-{
-    return qi_ / Di_ * std::log(1.0 + Di_ * time);
-}
-
 #ifndef DCA_NO_IOSTREAMS
-inline std::ostream& operator<<(std::ostream& os, const arps_hyperbolic& d)
+template<class Real>
+inline std::ostream& operator<<(std::ostream& os,
+        const basic_arps_hyperbolic<Real>& d)
 {
     return os << "<Arps hyperbolic decline: (qi = " << d.qi() << ", Di = "
         << d.Di() << ", b = " << d.b() << ")>";
 }
 #endif
 
+template<>
+struct decline_codec<arps_hyperbolic> {
+    static constexpr std::size_t width = 3;
+
+    static decline_tag tag(const arps_hyperbolic&) noexcept
+    {
+        return decline_tag::arps_hyperbolic;
+    }
+
+    static std::size_t encode(const arps_hyperbolic& d, double* params)
+        noexcept
+    {
+        params[0] = d.qi();
+        params[1] = d.Di();
+        params[2] = d.b();
+        return width;
+    }
+
+    static arps_hyperbolic decode(decline_tag tag, const double* params)
+    {
+        detail::check_tag(tag, decline_tag::arps_hyperbolic);
+        return arps_hyperbolic(params[0], params[1], params[2]);
+    }
+};
+
+#ifdef DCA_EXTERN_TEMPLATES // compiled into libdca.a
+extern template class basic_arps_hyperbolic<double>;
+#endif
+
 }
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef HYP2EXP_HPP
 #define HYP2EXP_HPP
 
+#include "codec.hpp"
 #include "exponential.hpp"
 #include "hyperbolic.hpp"
 #include <stdexcept>
@@ -11,29 +12,37 @@
 
 namespace dca {
 
-class arps_hyperbolic_to_exponential :
-  private arps_hyperbolic, private arps_exponential {
+template<class Real>
+class basic_arps_hyperbolic_to_exponential :
+  private basic_arps_hyperbolic<Real>, private basic_arps_exponential<Real> {
     public:
-        arps_hyperbolic_to_exponential
-            (double qi, double Di, double b, double Df);
+        basic_arps_hyperbolic_to_exponential
+            (Real qi, Real Di, Real b, Real Df);
 
-        const double& qi() const noexcept;
-        const double& Di() const noexcept;
-        const double& b() const noexcept;
-        const double& Df() const noexcept;
+        const Real& qi() const noexcept;
+        const Real& Di() const noexcept;
+        const Real& b() const noexcept;
+        const Real& Df() const noexcept;
 
-        double rate(double time) const noexcept;
-        double cumulative(double time) const noexcept;
-        double D(double time) const noexcept;
+        Real rate(Real time) const noexcept;
+        Real cumulative(Real time) const noexcept;
+        Real D(Real time) const noexcept;
 
     private:
-        double t_trans_;
+        using hyperbolic = basic_arps_hyperbolic<Real>;
+        using exponential = basic_arps_exponential<Real>;
+
+        Real t_trans_;
 };
 
-inline arps_hyperbolic_to_exponential::arps_hyperbolic_to_exponential(
-        double qi, double Di, double b, double Df)
-    : arps_hyperbolic(qi, Di, b),
-      arps_exponential(arps_hyperbolic::rate((Di / Df - 1.0) / (b * Di)), Df),
+using arps_hyperbolic_to_exponential =
+    basic_arps_hyperbolic_to_exponential<double>;
+
+template<class Real>
+inline basic_arps_hyperbolic_to_exponential<Real>::
+basic_arps_hyperbolic_to_exponential(Real qi, Real Di, Real b, Real Df)
+    : hyperbolic(qi, Di, b),
+      exponential(hyperbolic::rate((Di / Df - 1.0) / (b * Di)), Df),
       t_trans_((Di / Df - 1.0) / (b * Di))
 {
     if (Df <= 0) throw std::out_of_range("Df must be non-negative.");
@@ -41,58 +50,104 @@ inline arps_hyperbolic_to_exponential::arps_hyperbolic_to_exponential(
     // will be treated as wholly exponential
 }
 
-inline const double& arps_hyperbolic_to_exponential::qi() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic_to_exponential<Real>::qi() const
+  noexcept
 {
-    return arps_hyperbolic::qi();
+    return hyperbolic::qi();
 }
 
-inline const double& arps_hyperbolic_to_exponential::Di() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic_to_exponential<Real>::Di() const
+  noexcept
 {
-    return arps_hyperbolic::Di();
+    return hyperbolic::Di();
 }
 
-inline const double& arps_hyperbolic_to_exponential::b() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic_to_exponential<Real>::b() const
+  noexcept
 {
-    return arps_hyperbolic::b();
+    return hyperbolic::b();
 }
 
-inline const double& arps_hyperbolic_to_exponential::Df() const noexcept
+template<class Real>
+inline const Real& basic_arps_hyperbolic_to_exponential<Real>::Df() const
+  noexcept
 {
-    return arps_exponential::D();
+    return exponential::D();
 }
 
-inline double arps_hyperbolic_to_exponential::rate(double time) const noexcept
+template<class Real>
+inline Real basic_arps_hyperbolic_to_exponential<Real>::rate(Real time) const
+  noexcept
 {
     if (time < t_trans_)
-        return arps_hyperbolic::rate(time);
-    return arps_exponential::rate(time - t_trans_);
+        return hyperbolic::rate(time);
+    return exponential::rate(time - t_trans_);
 }
 
-inline double arps_hyperbolic_to_exponential::cumulative(double time) const
-  noexcept
+template<class Real>
+inline Real basic_arps_hyperbolic_to_exponential<Real>::cumulative(Real time)
+  const noexcept
 {
     if (time < t_trans_)
-        return arps_hyperbolic::cumulative(time);
-    return arps_hyperbolic::cumulative(t_trans_) +
-        arps_exponential::cumulative(time - t_trans_);
+        return hyperbolic::cumulative(time);
+    return hyperbolic::cumulative(t_trans_) +
+        exponential::cumulative(time - t_trans_);
 }
 
-inline double arps_hyperbolic_to_exponential::D(double time) const noexcept
+template<class Real>
+inline Real basic_arps_hyperbolic_to_exponential<Real>::D(Real time) const
+  noexcept
 {
     if (time < t_trans_)
-        return arps_hyperbolic::D(time);
-    return arps_exponential::D();
+        return hyperbolic::D(time);
+    return exponential::D();
 }
 
 #ifndef DCA_NO_IOSTREAMS
+template<class Real>
 inline std::ostream& operator<<(std::ostream& os,
-        const arps_hyperbolic_to_exponential& d)
+        const basic_arps_hyperbolic_to_exponential<Real>& d)
 {
     return os << "<Arps hyperbolic-to-exponential decline: (qi = " << d.qi() << ", Di = "
         << d.Di() << ", b = " << d.b() << ", Df = " << d.Df() << ")>";
 }
 #endif
 
+template<>
+struct decline_codec<arps_hyperbolic_to_exponential> {
+    static constexpr std::size_t width = 4;
+
+    static decline_tag tag(const arps_hyperbolic_to_exponential&) noexcept
+    {
+        return decline_tag::arps_hyperbolic_to_exponential;
+    }
+
+    static std::size_t encode(const arps_hyperbolic_to_exponential& d,
+            double* params) noexcept
+    {
+        params[0] = d.qi();
+        params[1] = d.Di();
+        params[2] = d.b();
+        params[3] = d.Df();
+        return width;
+    }
+
+    static arps_hyperbolic_to_exponential decode(decline_tag tag,
+            const double* params)
+    {
+        detail::check_tag(tag, decline_tag::arps_hyperbolic_to_exponential);
+        return arps_hyperbolic_to_exponential(params[0], params[1],
+                params[2], params[3]);
+    }
+};
+
+#ifdef DCA_EXTERN_TEMPLATES // compiled into libdca.a
+extern template class basic_arps_hyperbolic_to_exponential<double>;
+#endif
+
 }
 
 #endif
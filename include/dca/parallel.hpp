@@ -0,0 +1,98 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dca {
+
+inline unsigned default_threads() noexcept
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// how many threads parallel_for runs for n indices: at most one per grain
+inline unsigned parallel_threads(std::size_t n, unsigned threads = 0,
+        std::size_t grain = 1) noexcept
+{
+    if (threads == 0)
+        threads = default_threads();
+    if (grain == 0)
+        grain = 1;
+    std::size_t chunks = (n + grain - 1) / grain;
+    if (threads > chunks)
+        threads = static_cast<unsigned>(chunks);
+    return std::max(1u, threads);
+}
+
+/*
+ * as parallel_for below, calling fn(i, worker) with the index in
+ * [0, parallel_threads(n, threads, grain)) of the thread running it, e.g.
+ * to pick that thread's scratch buffers
+ */
+template<class Fn>
+inline void parallel_for_worker(std::size_t n, Fn fn, unsigned threads = 0,
+        std::size_t grain = 1)
+{
+    if (grain == 0)
+        grain = 1;
+    threads = parallel_threads(n, threads, grain);
+
+    if (threads <= 1) {
+        for (std::size_t i = 0; i < n; ++i)
+            fn(i, 0u);
+        return;
+    }
+
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    auto work = [&](unsigned worker) {
+        try {
+            std::size_t begin;
+            while ((begin = next.fetch_add(grain)) < n) {
+                std::size_t end = std::min(begin + grain, n);
+                for (std::size_t i = begin; i < end; ++i)
+                    fn(i, worker);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error)
+                error = std::current_exception();
+            next = n; // stop handing out work
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(work, t);
+    work(0);
+    for (auto& thread : pool)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/*
+ * call fn(i) for each i in [0, n) on up to `threads` threads (0: one per
+ * hardware thread), handing out `grain` consecutive indices at a time.
+ * the first exception thrown by fn is rethrown once all threads finish.
+ */
+template<class Fn>
+inline void parallel_for(std::size_t n, Fn fn, unsigned threads = 0,
+        std::size_t grain = 1)
+{
+    parallel_for_worker(n, [&](std::size_t i, unsigned) { fn(i); },
+            threads, grain);
+}
+
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef PARSE_HPP
+#define PARSE_HPP
+
+#include "profile.hpp"
+
+#include <clocale>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dca {
+
+class parse_error : public std::invalid_argument {
+    public:
+        parse_error(std::size_t index, const std::string& text)
+            : std::invalid_argument("Invalid number \"" + text + "\"."),
+              index_(index), text_(text) { }
+
+        std::size_t index() const noexcept { return index_; }
+        const std::string& text() const noexcept { return text_; }
+
+    private:
+        std::size_t index_;
+        std::string text_;
+};
+
+struct parse_options {
+    parse_options()
+        : missing_tokens({ "", "NA", "N/A", "null" }),
+          missing_value(0.0), error_value(0.0) { }
+
+    // cells (after trimming blanks) which mean "no value"
+    std::vector<std::string> missing_tokens;
+    double missing_value; // default: as for a month with no production
+    double error_value; // for unparseable cells, when not throwing
+};
+
+namespace detail {
+
+inline bool is_blank(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// exactly representable powers of ten
+inline double exact_pow10(int e) noexcept
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    return pow10[e];
+}
+
+}
+
+/*
+ * parse a plain decimal number ([+-]digits[.digits][(e|E)[+-]digits]),
+ * locale-independently; false if [begin, end) is anything else. numbers
+ * with at most 19 significant digits and a small enough exponent (nearly
+ * all production data) are converted directly and exactly rounded; the
+ * rest fall back to strtod, given the C locale's decimal point in place of
+ * the '.'.
+ */
+inline bool parse_double(const char* begin, const char* end, double& value)
+{
+    const char* p = begin;
+    bool negative = false;
+    if (p != end && (*p == '+' || *p == '-'))
+        negative = (*p++ == '-');
+
+    std::uint64_t mantissa = 0;
+    int digits = 0, dropped = 0, exp10 = 0;
+    bool any_digits = false;
+
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+        any_digits = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+            if (mantissa)
+                ++digits;
+        } else {
+            ++dropped;
+        }
+    }
+
+    if (p != end && *p == '.') {
+        for (++p; p != end && *p >= '0' && *p <= '9'; ++p) {
+            any_digits = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                if (mantissa)
+                    ++digits;
+                --exp10;
+            } else {
+                ++dropped;
+            }
+        }
+    }
+
+    if (!any_digits)
+        return false;
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool exp_negative = false;
+        if (p != end && (*p == '+' || *p == '-'))
+            exp_negative = (*p++ == '-');
+        if (p == end || *p < '0' || *p > '9')
+            return false;
+        int e = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p)
+            if (e < 100000)
+                e = e * 10 + (*p - '0');
+        exp10 += exp_negative ? -e : e;
+    }
+
+    if (p != end)
+        return false;
+
+    // Clinger's fast path: both operands exact, so one rounding
+    if (!dropped && mantissa < (std::uint64_t(1) << 53)
+            && exp10 >= -22 && exp10 <= 22) {
+        double m = static_cast<double>(mantissa);
+        value = exp10 < 0 ? m / detail::exact_pow10(-exp10)
+                          : m * detail::exact_pow10(exp10);
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    // strtod reads the decimal point of whatever C locale is in force
+    std::string text(begin, end);
+    auto point = text.find('.');
+    if (point != std::string::npos)
+        text.replace(point, 1, std::localeconv()->decimal_point);
+    value = std::strtod(text.c_str(), nullptr);
+    return true;
+}
+
+namespace detail {
+
+// trim blanks, match missing tokens, parse; false if unparseable
+inline bool parse_cell(const char* begin, const char* end,
+        const parse_options& options, double& value)
+{
+    while (begin != end && is_blank(*begin))
+        ++begin;
+    while (end != begin && is_blank(*(end - 1)))
+        --end;
+
+    auto length = static_cast<std::size_t>(end - begin);
+    for (const auto& token : options.missing_tokens) {
+        if (token.size() == length
+                && std::equal(token.begin(), token.end(), begin)) {
+            value = options.missing_value;
+            return true;
+        }
+    }
+
+    return parse_double(begin, end, value);
+}
+
+}
+
+/*
+ * parse a column of text cells (e.g. from read_delimited: anything with
+ * data() and size()); throws parse_error at the first unparseable cell
+ */
+template<class TextIter, class OutIter>
+inline OutIter parse_column(TextIter begin, TextIter end, OutIter out,
+        const parse_options& options = parse_options {})
+{
+    DCA_PROFILE_SCOPE(parse);
+    for (std::size_t i = 0; begin != end; ++begin, ++i) {
+        const auto& cell = *begin;
+        double value;
+        if (!detail::parse_cell(cell.data(), cell.data() + cell.size(),
+                    options, value))
+            throw parse_error(i, std::string(cell.data(),
+                        cell.data() + cell.size()));
+        *out++ = value;
+    }
+    return out;
+}
+
+// as above, but writes options.error_value and the cell's index to errors
+template<class TextIter, class OutIter, class ErrorIter>
+inline OutIter parse_column(TextIter begin, TextIter end, OutIter out,
+        ErrorIter errors, const parse_options& options = parse_options {})
+{
+    DCA_PROFILE_SCOPE(parse);
+    for (std::size_t i = 0; begin != end; ++begin, ++i) {
+        const auto& cell = *begin;
+        double value;
+        if (!detail::parse_cell(cell.data(), cell.data() + cell.size(),
+                    options, value)) {
+            value = options.error_value;
+            *errors++ = i;
+        }
+        *out++ = value;
+    }
+    return out;
+}
+
+/*
+ * parse a block of raw text holding fields separated by delim or line
+ * breaks (one column per line, or a row of values), without splitting it
+ * into strings first; unparseable fields are handled as by the previous
+ * overload. a trailing line break does not make an extra field.
+ */
+template<class OutIter, class ErrorIter>
+inline OutIter parse_block(const char* begin, const char* end, char delim,
+        OutIter out, ErrorIter errors,
+        const parse_options& options = parse_options {})
+{
+    DCA_PROFILE_SCOPE(parse);
+    std::size_t i = 0;
+    while (begin != end) {
+        const char* field_end = begin;
+        while (field_end != end && *field_end != delim
+                && *field_end != '\n')
+            ++field_end;
+
+        double value;
+        if (!detail::parse_cell(begin, field_end, options, value)) {
+            value = options.error_value;
+            *errors++ = i;
+        }
+        *out++ = value;
+        ++i;
+
+        begin = field_end;
+        if (begin != end)
+            ++begin;
+    }
+    return out;
+}
+
+}
+
+#endif
@@ -1,12 +1,18 @@
 #ifndef PRODUCTION_HPP
 #define PRODUCTION_HPP
 
+#include "parallel.hpp"
+#include "profile.hpp"
+
 #include <cstddef>
+#include <array>
 #include <tuple>
 #include <iterator>
 #include <algorithm>
+#include <functional>
 #include <utility>
 #include <vector>
+#include <unordered_map>
 #include <cmath>
 #include <stdexcept>
 
@@ -50,15 +56,146 @@ shift_to_peak(RateIter major_begin, RateIter major_end,
     return result;
 }
 
-template<class AggFn, class ProdRangeIter, class OutIter,
-    class=decltype(std::declval<ProdRangeIter>()->first)>
-inline OutIter aggregate_production(
-        ProdRangeIter prod_begin, ProdRangeIter prod_end, OutIter out,
-        std::size_t min_streams, AggFn aggregate)
+struct cleaning_options {
+    bool trim_leading = true; // months before first production
+    bool trim_trailing = true; // months after last production
+    bool shift_to_peak = true; // start at the major stream's peak
+    double shut_in_rate = 0.0; // at or below this, a month is shut in
+};
+
+/*
+ * clean several tied production streams (e.g. oil and gas for one well)
+ * without copying: returns views into the originals. leading trimming and
+ * the shift to peak follow the major (first) stream and apply to all, so
+ * the streams keep a shared time origin; trailing shut-in months are
+ * trimmed per stream. the views feed aggregate_production and best_from_*
+ * directly.
+ */
+template<class ProdIter, std::size_t N>
+inline std::array<std::pair<ProdIter, ProdIter>, N> clean_production(
+        const std::array<std::pair<ProdIter, ProdIter>, N>& streams,
+        const cleaning_options& options = cleaning_options {},
+        std::size_t* offset = nullptr)
 {
-    std::vector<typename std::iterator_traits<ProdRangeIter>::value_type>
-        streams(prod_begin, prod_end);
-    std::vector<double> prod(streams.size());
+    static_assert(N > 0, "at least one stream is required");
+    DCA_PROFILE_SCOPE(clean);
+
+    auto producing = [&](double p) { return p > options.shut_in_rate; };
+    auto major = streams[0];
+
+    // one pass over the major stream for both first production and peak
+    std::size_t shift = 0, first = 0, i = 0;
+    bool found_first = false;
+    auto peak = major.first;
+    for (auto it = major.first; it != major.second; ++it, ++i) {
+        if (!found_first && producing(*it)) {
+            first = i;
+            found_first = true;
+        }
+        if (*it > *peak) {
+            peak = it;
+            shift = i;
+        }
+    }
+    if (!found_first)
+        first = i;
+
+    if (!options.shift_to_peak)
+        shift = options.trim_leading ? first : 0;
+
+    std::array<std::pair<ProdIter, ProdIter>, N> result;
+    for (std::size_t s = 0; s < N; ++s) {
+        auto begin = streams[s].first, end = streams[s].second;
+
+        auto length = static_cast<std::size_t>(std::distance(begin, end));
+        std::advance(begin, std::min(shift, length));
+
+        if (options.trim_trailing) {
+            while (end != begin && !producing(*std::prev(end)))
+                --end;
+        }
+
+        result[s] = std::make_pair(begin, end);
+    }
+
+    if (offset)
+        *offset = shift;
+
+    return result;
+}
+
+template<class ProdIter>
+inline std::pair<ProdIter, ProdIter> clean_production(
+        ProdIter begin, ProdIter end,
+        const cleaning_options& options = cleaning_options {},
+        std::size_t* offset = nullptr)
+{
+    return clean_production(
+            std::array<std::pair<ProdIter, ProdIter>, 1> { {
+                std::make_pair(begin, end)
+            } }, options, offset)[0];
+}
+
+// write the index (from begin) of each shut-in month to out
+template<class ProdIter, class OutIter>
+inline OutIter shut_in_months(ProdIter begin, ProdIter end, OutIter out,
+        double shut_in_rate = 0.0)
+{
+    for (std::size_t i = 0; begin != end; ++begin, ++i)
+        if (*begin <= shut_in_rate)
+            *out++ = i;
+    return out;
+}
+
+/*
+ * write the index of each producing month which differs by more than a
+ * factor of `ratio` from the median of the producing months within
+ * `window` months either side of it
+ */
+template<class ProdIter, class OutIter>
+inline OutIter flag_outliers(ProdIter begin, ProdIter end, OutIter out,
+        double ratio = 3.0, std::size_t window = 3,
+        double shut_in_rate = 0.0)
+{
+    auto n = static_cast<std::size_t>(std::distance(begin, end));
+    std::vector<double> neighbors;
+    neighbors.reserve(2 * window);
+
+    auto it = begin;
+    for (std::size_t i = 0; i < n; ++i, ++it) {
+        if (*it <= shut_in_rate)
+            continue;
+
+        neighbors.clear();
+        std::size_t lo = i > window ? i - window : 0;
+        std::size_t hi = std::min(i + window + 1, n);
+        auto nb = std::next(begin, lo);
+        for (std::size_t j = lo; j < hi; ++j, ++nb)
+            if (j != i && *nb > shut_in_rate)
+                neighbors.push_back(*nb);
+
+        if (neighbors.empty())
+            continue;
+
+        auto mid = neighbors.begin() + neighbors.size() / 2;
+        std::nth_element(neighbors.begin(), mid, neighbors.end());
+        if (*it > *mid * ratio || *it * ratio < *mid)
+            *out++ = i;
+    }
+
+    return out;
+}
+
+namespace detail {
+
+// aggregate_production over caller-owned (consumed) streams and scratch
+template<class AggFn, class ProdRange, class OutIter>
+inline OutIter aggregate_streams(std::vector<ProdRange>& streams,
+        std::vector<double>& prod, OutIter out, std::size_t min_streams,
+        AggFn aggregate)
+{
+    DCA_PROFILE_SCOPE(aggregate);
+    prod.resize(streams.size());
 
     while (true) {
         std::size_t active_streams = 0;
@@ -67,7 +204,8 @@ inline OutIter aggregate_production(
             if (stream.first != stream.second)
                 prod[active_streams++] = *stream.first++;
 
-        if (active_streams < min_streams)
+        // stop once every stream is exhausted, even for min_streams = 0
+        if (active_streams < min_streams || active_streams == 0)
             break;
 
         *out++ = aggregate(prod.data(), prod.data() + active_streams);
@@ -76,6 +214,77 @@ inline OutIter aggregate_production(
     return out;
 }
 
+template<class AggFn, class ProdRange, class OutIter>
+inline OutIter aggregate_streams_parallel(
+        const std::vector<ProdRange>& streams, OutIter out,
+        std::size_t min_streams, AggFn aggregate, unsigned threads)
+{
+    DCA_PROFILE_SCOPE(aggregate);
+
+    std::vector<std::size_t> lengths;
+    lengths.reserve(streams.size());
+    for (const auto& stream : streams)
+        lengths.push_back(static_cast<std::size_t>(
+                    std::distance(stream.first, stream.second)));
+
+    /*
+     * month m has as many active streams as there are streams longer than
+     * m, so the serial loop stops at the need'th longest stream's length
+     */
+    std::size_t need = std::max<std::size_t>(min_streams, 1), months = 0;
+    if (need <= lengths.size()) {
+        std::vector<std::size_t> sorted(lengths);
+        std::nth_element(sorted.begin(), sorted.begin() + (need - 1),
+                sorted.end(), std::greater<std::size_t>());
+        months = sorted[need - 1];
+    }
+
+    if (threads == 0)
+        threads = default_threads();
+    std::size_t blocks = std::min<std::size_t>(months,
+            std::size_t(4) * threads);
+    std::vector<double> result(months);
+
+    // each block of months gathers from every stream, in stream order
+    parallel_for(blocks, [&](std::size_t block) {
+        std::size_t first = months * block / blocks;
+        std::size_t last = months * (block + 1) / blocks;
+
+        using prod_iter = decltype(streams.front().first);
+        std::vector<prod_iter> pos;
+        pos.reserve(streams.size());
+        for (std::size_t s = 0; s < streams.size(); ++s)
+            pos.push_back(std::next(streams[s].first,
+                        std::min(first, lengths[s])));
+
+        std::vector<double> prod(streams.size());
+        for (std::size_t m = first; m < last; ++m) {
+            std::size_t active_streams = 0;
+            for (std::size_t s = 0; s < streams.size(); ++s)
+                if (lengths[s] > m)
+                    prod[active_streams++] = *pos[s]++;
+            result[m] = aggregate(prod.data(), prod.data() + active_streams);
+        }
+    }, threads);
+
+    return std::copy(result.begin(), result.end(), out);
+}
+
+}
+
+template<class AggFn, class ProdRangeIter, class OutIter,
+    class=decltype(std::declval<ProdRangeIter>()->first)>
+inline OutIter aggregate_production(
+        ProdRangeIter prod_begin, ProdRangeIter prod_end, OutIter out,
+        std::size_t min_streams, AggFn aggregate)
+{
+    std::vector<typename std::iterator_traits<ProdRangeIter>::value_type>
+        streams(prod_begin, prod_end);
+    std::vector<double> prod;
+    return detail::aggregate_streams(streams, prod, out, min_streams,
+            aggregate);
+}
+
 template<class AggFn, class ProdContIter, class OutIter,
     class=typename std::iterator_traits<ProdContIter>::value_type::value_type,
     class=void>
@@ -99,6 +308,47 @@ inline OutIter aggregate_production(
             min_streams, aggregate);
 }
 
+/*
+ * as aggregate_production, with identical output, but aggregating blocks of
+ * months on up to `threads` threads (0: one per hardware thread). aggregate
+ * must be safe to call concurrently; random-access ranges avoid rescanning
+ * each stream up to the start of every block.
+ */
+template<class AggFn, class ProdRangeIter, class OutIter,
+    class=decltype(std::declval<ProdRangeIter>()->first)>
+inline OutIter parallel_aggregate_production(
+        ProdRangeIter prod_begin, ProdRangeIter prod_end, OutIter out,
+        std::size_t min_streams, AggFn aggregate, unsigned threads = 0)
+{
+    std::vector<typename std::iterator_traits<ProdRangeIter>::value_type>
+        streams(prod_begin, prod_end);
+    return detail::aggregate_streams_parallel(streams, out, min_streams,
+            aggregate, threads);
+}
+
+template<class AggFn, class ProdContIter, class OutIter,
+    class=typename std::iterator_traits<ProdContIter>::value_type::value_type,
+    class=void>
+inline OutIter parallel_aggregate_production(
+        ProdContIter prod_begin, ProdContIter prod_end, OutIter out,
+        std::size_t min_streams, AggFn aggregate, unsigned threads = 0)
+{
+    using std::begin;
+    using std::end;
+    using prod_cont =
+        typename std::iterator_traits<ProdContIter>::value_type;
+    using prod_it = decltype(begin(std::declval<const prod_cont&>()));
+
+    std::vector<std::pair<prod_it, prod_it>> streams;
+    std::transform(prod_begin, prod_end, std::back_inserter(streams),
+            [](const prod_cont& cont) {
+                return std::make_pair(begin(cont), end(cont));
+            });
+
+    return detail::aggregate_streams_parallel(streams, out, min_streams,
+            aggregate, threads);
+}
+
 struct mean {
     template<class ProdIter>
     double operator()(ProdIter begin, ProdIter end) const noexcept
@@ -138,6 +388,146 @@ class percentile {
         const double pct_;
 };
 
+struct well_span {
+    std::size_t offset; // first row, in well order
+    std::size_t length; // rows
+};
+
+/*
+ * per-well row ranges over a table with one row per well-month, built
+ * once in O(rows) by hashing the ID column. rows needn't be grouped by ID:
+ * wells are numbered by first appearance, and gather() lays a column out
+ * in well order (stable within each well), once, after which every well
+ * is a view (offset, length) into it. if the rows were already grouped,
+ * well order is row order and no gather is needed.
+ */
+class well_index {
+    public:
+        template<class IdIter>
+        well_index(IdIter id_begin, IdIter id_end);
+
+        std::size_t size() const noexcept; // wells
+        std::size_t rows() const noexcept;
+        bool contiguous() const noexcept; // well order is row order
+
+        const well_span& operator[](std::size_t well) const noexcept;
+        std::vector<well_span>::const_iterator begin() const noexcept;
+        std::vector<well_span>::const_iterator end() const noexcept;
+
+        // the (row order) row of a well's i'th row, e.g. to look up its ID
+        std::size_t row(std::size_t well, std::size_t i = 0) const noexcept;
+
+        // copy a column (in row order) to out, in well order
+        template<class ColIter, class OutIter>
+        OutIter gather(ColIter column, OutIter out) const;
+
+        // a well's rows in a column laid out in well order
+        template<class ColIter>
+        std::pair<ColIter, ColIter> rows_of(std::size_t well,
+                ColIter column) const;
+
+    private:
+        std::vector<well_span> wells_;
+        std::vector<std::size_t> order_; // row for each well-ordered slot
+        bool contiguous_;
+};
+
+template<class IdIter>
+inline well_index::well_index(IdIter id_begin, IdIter id_end)
+    : contiguous_(true)
+{
+    DCA_PROFILE_SCOPE(group);
+    using id_type = typename std::iterator_traits<IdIter>::value_type;
+    std::unordered_map<id_type, std::size_t> numbers;
+    std::vector<std::size_t> row_well;
+
+    std::size_t last = 0;
+    for (auto it = id_begin; it != id_end; ++it) {
+        auto found = numbers.find(*it);
+        if (found == numbers.end()) {
+            found = numbers.emplace(*it, wells_.size()).first;
+            wells_.push_back(well_span { 0, 0 });
+        } else if (found->second != last) {
+            contiguous_ = false; // a well seen before, after another
+        }
+        last = found->second;
+        row_well.push_back(found->second);
+        ++wells_[found->second].length;
+    }
+
+    std::size_t offset = 0;
+    for (auto& w : wells_) {
+        w.offset = offset;
+        offset += w.length;
+    }
+
+    // counting sort of rows by well: stable
+    std::vector<std::size_t> fill(wells_.size(), 0);
+    order_.resize(row_well.size());
+    for (std::size_t row = 0; row < row_well.size(); ++row) {
+        auto w = row_well[row];
+        order_[wells_[w].offset + fill[w]++] = row;
+    }
+}
+
+inline std::size_t well_index::size() const noexcept
+{
+    return wells_.size();
+}
+
+inline std::size_t well_index::rows() const noexcept
+{
+    return order_.size();
+}
+
+inline bool well_index::contiguous() const noexcept
+{
+    return contiguous_;
+}
+
+inline const well_span& well_index::operator[](std::size_t well) const
+  noexcept
+{
+    return wells_[well];
+}
+
+inline std::vector<well_span>::const_iterator well_index::begin() const
+  noexcept
+{
+    return wells_.begin();
+}
+
+inline std::vector<well_span>::const_iterator well_index::end() const
+  noexcept
+{
+    return wells_.end();
+}
+
+inline std::size_t well_index::row(std::size_t well, std::size_t i) const
+  noexcept
+{
+    return order_[wells_[well].offset + i];
+}
+
+template<class ColIter, class OutIter>
+inline OutIter well_index::gather(ColIter column, OutIter out) const
+{
+    if (contiguous_)
+        return std::copy(column, std::next(column, order_.size()), out);
+
+    for (auto row : order_)
+        *out++ = column[row];
+    return out;
+}
+
+template<class ColIter>
+inline std::pair<ColIter, ColIter> well_index::rows_of(std::size_t well,
+        ColIter column) const
+{
+    auto begin = std::next(column, wells_[well].offset);
+    return std::make_pair(begin, std::next(begin, wells_[well].length));
+}
+
 template<class OutIter, class Numeric>
 inline OutIter step_series(OutIter begin, OutIter end,
         Numeric init, Numeric step)
@@ -0,0 +1,242 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#ifndef DCA_NO_IOSTREAMS
+#include <iomanip>
+#include <iostream>
+#endif
+
+/*
+ * hot-path counters and scoped timers, compiled in with -DDCA_PROFILE and
+ * to nothing otherwise. each thread counts into its own slots (no shared
+ * cache lines, no atomic read-modify-writes); snapshot() merges them with
+ * the totals of threads which have exited.
+ *
+ *     DCA_PROFILE_COUNT(probe)  count one event
+ *     DCA_PROFILE_SCOPE(probe)  count one event, and time it to scope exit
+ *
+ * timed probes nest (a fit includes its optimizer run), so their times are
+ * inclusive.
+ */
+#ifdef DCA_PROFILE
+#define DCA_PROFILE_CAT_(a, b) a ## b
+#define DCA_PROFILE_CAT(a, b) DCA_PROFILE_CAT_(a, b)
+#define DCA_PROFILE_COUNT(probe) \
+    ::dca::profile::count(::dca::profile::probe)
+#define DCA_PROFILE_SCOPE(probe) \
+    ::dca::profile::scoped_timer DCA_PROFILE_CAT(dca_profile_timer_, \
+            __LINE__)(::dca::profile::probe)
+#else
+#define DCA_PROFILE_COUNT(probe) ((void)0)
+#define DCA_PROFILE_SCOPE(probe) ((void)0)
+#endif
+
+namespace dca {
+
+namespace profile {
+
+enum probe : unsigned {
+    rate, // model rate() calls
+    cumulative, // model cumulative() calls
+    convert_decline,
+    objective, // fit objective evaluations
+    infeasible, // objective points rejected by a decline's constructor
+    fit,
+    optimize, // optimizer runs
+    time_solve, // time_to_rate, time_to_cumulative
+    clean,
+    aggregate,
+    parse,
+    group, // building a well_index
+    write, // forecast_writer flushes
+    probe_count
+};
+
+inline const char* probe_name(probe p) noexcept
+{
+    static const char* names[probe_count] = {
+        "rate", "cumulative", "convert_decline", "objective", "infeasible",
+        "fit", "optimize", "time_solve", "clean", "aggregate", "parse",
+        "group", "write"
+    };
+    return p < probe_count ? names[p] : "unknown";
+}
+
+struct entry {
+    const char* name;
+    std::uint64_t count;
+    double seconds; // zero for untimed probes
+};
+
+using report = std::array<entry, probe_count>;
+
+namespace detail {
+
+struct counters {
+    std::array<std::atomic<std::uint64_t>, probe_count> count;
+    std::array<std::atomic<std::uint64_t>, probe_count> nanos;
+
+    counters() noexcept { clear(); }
+
+    void clear() noexcept
+    {
+        for (std::size_t p = 0; p < probe_count; ++p) {
+            count[p].store(0, std::memory_order_relaxed);
+            nanos[p].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// only the owning thread writes, so a plain load and store will do
+inline void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) noexcept
+{
+    a.store(a.load(std::memory_order_relaxed) + n,
+            std::memory_order_relaxed);
+}
+
+struct registry {
+    std::mutex lock;
+    std::vector<counters*> live;
+    counters exited;
+};
+
+inline registry& global()
+{
+    static registry r;
+    return r;
+}
+
+struct thread_counters {
+    counters c;
+
+    thread_counters()
+    {
+        auto& g = global();
+        std::lock_guard<std::mutex> guard(g.lock);
+        g.live.push_back(&c);
+    }
+
+    ~thread_counters()
+    {
+        auto& g = global();
+        std::lock_guard<std::mutex> guard(g.lock);
+        for (std::size_t p = 0; p < probe_count; ++p) {
+            bump(g.exited.count[p],
+                    c.count[p].load(std::memory_order_relaxed));
+            bump(g.exited.nanos[p],
+                    c.nanos[p].load(std::memory_order_relaxed));
+        }
+        g.live.erase(std::find(g.live.begin(), g.live.end(), &c));
+    }
+};
+
+inline counters& local()
+{
+    thread_local thread_counters t;
+    return t.c;
+}
+
+}
+
+inline void count(probe p, std::uint64_t n = 1)
+{
+    detail::bump(detail::local().count[p], n);
+}
+
+class scoped_timer {
+    public:
+        explicit scoped_timer(probe p)
+            : counters_(detail::local()), probe_(p),
+              start_(std::chrono::steady_clock::now()) { }
+
+        ~scoped_timer()
+        {
+            auto elapsed = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start_).count();
+            detail::bump(counters_.count[probe_], 1);
+            detail::bump(counters_.nanos[probe_],
+                    static_cast<std::uint64_t>(elapsed));
+        }
+
+        scoped_timer(const scoped_timer&) = delete;
+        scoped_timer& operator=(const scoped_timer&) = delete;
+
+    private:
+        detail::counters& counters_;
+        probe probe_;
+        std::chrono::steady_clock::time_point start_;
+};
+
+// totals over all threads, past and present
+inline report snapshot()
+{
+    report result;
+    for (unsigned p = 0; p < probe_count; ++p)
+        result[p] = entry { probe_name(static_cast<probe>(p)), 0, 0.0 };
+
+    auto add = [&](const detail::counters& c) {
+        for (std::size_t p = 0; p < probe_count; ++p) {
+            result[p].count += c.count[p].load(std::memory_order_relaxed);
+            result[p].seconds += 1e-9 * static_cast<double>(
+                    c.nanos[p].load(std::memory_order_relaxed));
+        }
+    };
+
+    auto& g = detail::global();
+    std::lock_guard<std::mutex> guard(g.lock);
+    add(g.exited);
+    for (auto c : g.live)
+        add(*c);
+    return result;
+}
+
+/*
+ * zero all counters; counts made concurrently with a reset may survive it
+ * (call between pipeline stages)
+ */
+inline void reset()
+{
+    auto& g = detail::global();
+    std::lock_guard<std::mutex> guard(g.lock);
+    g.exited.clear();
+    for (auto c : g.live)
+        c->clear();
+}
+
+#ifndef DCA_NO_IOSTREAMS
+// the probes which fired, one per line
+inline std::ostream& print(std::ostream& os, const report& r)
+{
+    auto flags = os.flags();
+    os << std::left << std::setw(16) << "probe" << std::right
+        << std::setw(16) << "count" << std::setw(14) << "seconds" << '\n';
+    for (const auto& e : r) {
+        if (e.count == 0)
+            continue;
+        os << std::left << std::setw(16) << e.name << std::right
+            << std::setw(16) << e.count << std::setw(14);
+        if (e.seconds > 0.0)
+            os << e.seconds;
+        else
+            os << '-';
+        os << '\n';
+    }
+    os.flags(flags);
+    return os;
+}
+#endif
+
+}
+
+}
+
+#endif
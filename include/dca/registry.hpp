@@ -0,0 +1,372 @@
+#ifndef REGISTRY_HPP
+#define REGISTRY_HPP
+
+#include "any_decline.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dca {
+
+/*
+ * fitted declines keyed by interned well ID, for many concurrent readers
+ * and occasional publishers. each well's decline is an immutable snapshot;
+ * publishing swaps in a new snapshot atomically, and old snapshots are
+ * reclaimed once no reader can still hold them (epoch-based reclamation).
+ * lookups through a reader are wait-free: a handful of atomic loads and
+ * stores, no locks. publishers serialize among themselves.
+ */
+class decline_registry {
+    public:
+        using id_type = std::uint32_t;
+
+        static const id_type max_wells =
+            (id_type(1) << 12) * (id_type(1) << 12);
+
+        class reader;
+
+        explicit decline_registry(std::size_t max_readers = 64);
+        ~decline_registry() noexcept;
+
+        decline_registry(const decline_registry&) = delete;
+        decline_registry& operator=(const decline_registry&) = delete;
+
+        /*
+         * intern well names (from forward iterators), returning their IDs.
+         * each call that adds names copies the name table, so intern many
+         * wells in one call (then publish by ID), not one name at a time.
+         */
+        id_type intern(const std::string& name);
+        template<class NameIter, class OutIter>
+        OutIter intern(NameIter begin, NameIter end, OutIter out);
+
+        void publish(id_type id, any decline);
+        void publish(const std::string& name, any decline);
+
+        std::size_t size() const noexcept; // interned wells
+
+        // free retired snapshots no reader can reach; returns the number
+        std::size_t reclaim();
+
+        // one per reading thread; throws if max_readers are in use
+        reader make_reader();
+
+    private:
+        static const std::size_t segment_bits = 12;
+        static const std::size_t segment_size = std::size_t(1) << segment_bits;
+        static const std::uint64_t idle = ~std::uint64_t(0);
+        static const std::size_t reclaim_threshold = 1024;
+
+        using name_table = std::unordered_map<std::string, id_type>;
+        using slot = std::atomic<const any*>;
+
+        struct reader_record {
+            std::atomic<std::uint64_t> epoch;
+            std::atomic<bool> in_use;
+            char padding[64 - sizeof(std::atomic<std::uint64_t>)
+                - sizeof(std::atomic<bool>)]; // one per cache line
+        };
+
+        struct retired {
+            std::uint64_t epoch;
+            void* ptr;
+            void (*destroy)(void*);
+        };
+
+        template<class T>
+        static void destroy(void* p) noexcept
+        {
+            delete static_cast<T*>(p);
+        }
+
+        std::uint64_t pin(reader_record& r) const noexcept;
+        void unpin(reader_record& r) const noexcept;
+        const any* load(id_type id) const noexcept;
+        slot& slot_for(id_type id);
+        template<class T>
+        void retire(T* p); // with write_lock_ held
+
+        std::atomic<std::uint64_t> epoch_;
+        std::atomic<const name_table*> names_;
+        std::atomic<id_type> size_;
+        std::unique_ptr<std::atomic<slot*>[]> segments_;
+        std::unique_ptr<reader_record[]> readers_;
+        std::size_t max_readers_;
+
+        std::mutex write_lock_;
+        std::vector<retired> retired_;
+};
+
+class decline_registry::reader {
+    public:
+        reader(reader&& other) noexcept;
+        reader& operator=(reader&&) = delete;
+        ~reader() noexcept;
+
+        // call fn(const any&) with id's current snapshot, if any
+        template<class Fn>
+        bool with(id_type id, Fn fn) const;
+
+        bool find(const std::string& name, id_type& id) const;
+
+    private:
+        friend class decline_registry;
+
+        reader(const decline_registry* registry, reader_record* record)
+            noexcept;
+
+        const decline_registry* registry_;
+        reader_record* record_;
+};
+
+inline decline_registry::decline_registry(std::size_t max_readers)
+    : epoch_(0), names_(new name_table()), size_(0),
+      segments_(new std::atomic<slot*>[std::size_t(1) << segment_bits]),
+      readers_(new reader_record[max_readers]), max_readers_(max_readers)
+{
+    for (std::size_t i = 0; i < (std::size_t(1) << segment_bits); ++i)
+        segments_[i].store(nullptr, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < max_readers; ++i) {
+        readers_[i].epoch.store(idle, std::memory_order_relaxed);
+        readers_[i].in_use.store(false, std::memory_order_relaxed);
+    }
+}
+
+inline decline_registry::~decline_registry() noexcept
+{
+    for (std::size_t s = 0; s < (std::size_t(1) << segment_bits); ++s) {
+        slot* segment = segments_[s].load(std::memory_order_relaxed);
+        if (!segment)
+            continue;
+        for (std::size_t i = 0; i < segment_size; ++i)
+            delete segment[i].load(std::memory_order_relaxed);
+        delete[] segment;
+    }
+    delete names_.load(std::memory_order_relaxed);
+    for (auto& r : retired_)
+        r.destroy(r.ptr);
+}
+
+inline decline_registry::id_type decline_registry::intern(
+        const std::string& name)
+{
+    id_type id = 0;
+    intern(&name, &name + 1, &id);
+    return id;
+}
+
+template<class NameIter, class OutIter>
+inline OutIter decline_registry::intern(NameIter begin, NameIter end,
+        OutIter out)
+{
+    {
+        std::lock_guard<std::mutex> lock(write_lock_);
+
+        const name_table* old_names = names_.load(std::memory_order_acquire);
+        if (std::all_of(begin, end, [=](const std::string& name) {
+                    return old_names->count(name) != 0;
+                })) {
+            return std::transform(begin, end, out,
+                    [=](const std::string& name) {
+                        return old_names->find(name)->second;
+                    });
+        }
+
+        // copy-on-write: readers keep using the old table until it's retired
+        std::unique_ptr<name_table> names(new name_table(*old_names));
+        names->reserve(names->size() + std::distance(begin, end));
+        id_type next = size_.load(std::memory_order_relaxed);
+
+        while (begin != end) {
+            auto found = names->find(*begin);
+            if (found == names->end()) {
+                if (next == max_wells)
+                    throw std::out_of_range("Too many wells.");
+                slot_for(next); // allocate the segment before publishing
+                found = names->emplace(*begin, next++).first;
+            }
+            *out++ = found->second;
+            ++begin;
+        }
+
+        size_.store(next, std::memory_order_release);
+        names_.store(names.release(), std::memory_order_seq_cst);
+        retire(const_cast<name_table*>(old_names));
+    }
+
+    // a whole table, not one snapshot: free it as soon as no reader holds it
+    reclaim();
+    return out;
+}
+
+inline void decline_registry::publish(id_type id, any decline)
+{
+    if (id >= size_.load(std::memory_order_acquire))
+        throw std::out_of_range("Unknown well ID.");
+
+    std::unique_ptr<const any> snapshot(new any(std::move(decline)));
+    std::size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(write_lock_);
+        const any* old = slot_for(id).exchange(snapshot.release(),
+                std::memory_order_seq_cst);
+        if (old)
+            retire(const_cast<any*>(old));
+        pending = retired_.size();
+    }
+
+    if (pending >= reclaim_threshold)
+        reclaim();
+}
+
+inline void decline_registry::publish(const std::string& name, any decline)
+{
+    publish(intern(name), std::move(decline));
+}
+
+inline std::size_t decline_registry::size() const noexcept
+{
+    return size_.load(std::memory_order_acquire);
+}
+
+inline std::size_t decline_registry::reclaim()
+{
+    std::vector<retired> reclaimable;
+    {
+        std::lock_guard<std::mutex> lock(write_lock_);
+
+        std::uint64_t oldest = idle;
+        for (std::size_t i = 0; i < max_readers_; ++i)
+            oldest = std::min(oldest,
+                    readers_[i].epoch.load(std::memory_order_seq_cst));
+
+        auto keep = std::partition(retired_.begin(), retired_.end(),
+                [=](const retired& r) { return r.epoch >= oldest; });
+        reclaimable.assign(keep, retired_.end());
+        retired_.erase(keep, retired_.end());
+    }
+
+    for (auto& r : reclaimable)
+        r.destroy(r.ptr);
+    return reclaimable.size();
+}
+
+inline decline_registry::reader decline_registry::make_reader()
+{
+    for (std::size_t i = 0; i < max_readers_; ++i) {
+        bool expected = false;
+        if (readers_[i].in_use.compare_exchange_strong(expected, true))
+            return reader(this, &readers_[i]);
+    }
+    throw std::out_of_range("Too many registry readers.");
+}
+
+inline std::uint64_t decline_registry::pin(reader_record& r) const noexcept
+{
+    /*
+     * announce the epoch before loading any pointer: a snapshot retired at
+     * or after this epoch may still be reached, so it won't be reclaimed
+     */
+    std::uint64_t e = epoch_.load(std::memory_order_seq_cst);
+    r.epoch.store(e, std::memory_order_seq_cst);
+    return e;
+}
+
+inline void decline_registry::unpin(reader_record& r) const noexcept
+{
+    r.epoch.store(idle, std::memory_order_release);
+}
+
+inline const any* decline_registry::load(id_type id) const noexcept
+{
+    if (id >= size_.load(std::memory_order_acquire))
+        return nullptr;
+    slot* segment = segments_[id >> segment_bits].load(
+            std::memory_order_acquire);
+    return segment[id & (segment_size - 1)].load(std::memory_order_seq_cst);
+}
+
+inline decline_registry::slot& decline_registry::slot_for(id_type id)
+{
+    auto& segment = segments_[id >> segment_bits];
+    slot* s = segment.load(std::memory_order_acquire);
+    if (!s) {
+        s = new slot[segment_size];
+        for (std::size_t i = 0; i < segment_size; ++i)
+            s[i].store(nullptr, std::memory_order_relaxed);
+        segment.store(s, std::memory_order_release);
+    }
+    return s[id & (segment_size - 1)];
+}
+
+template<class T>
+inline void decline_registry::retire(T* p)
+{
+    retired_.push_back(retired {
+        epoch_.fetch_add(1, std::memory_order_seq_cst), p, &destroy<T>
+    });
+}
+
+inline decline_registry::reader::reader(const decline_registry* registry,
+        reader_record* record) noexcept
+    : registry_(registry), record_(record) { }
+
+inline decline_registry::reader::reader(reader&& other) noexcept
+    : registry_(other.registry_), record_(other.record_)
+{
+    other.record_ = nullptr;
+}
+
+inline decline_registry::reader::~reader() noexcept
+{
+    if (record_)
+        record_->in_use.store(false, std::memory_order_release);
+}
+
+template<class Fn>
+inline bool decline_registry::reader::with(id_type id, Fn fn) const
+{
+    struct unpin_guard {
+        const decline_registry* registry;
+        reader_record* record;
+        ~unpin_guard() { registry->unpin(*record); }
+    };
+
+    registry_->pin(*record_);
+    unpin_guard guard { registry_, record_ };
+
+    const any* snapshot = registry_->load(id);
+    if (!snapshot)
+        return false;
+    fn(*snapshot);
+    return true;
+}
+
+inline bool decline_registry::reader::find(const std::string& name,
+        id_type& id) const
+{
+    registry_->pin(*record_);
+    const name_table* names =
+        registry_->names_.load(std::memory_order_seq_cst);
+    auto found = names->find(name);
+    bool result = found != names->end();
+    if (result)
+        id = found->second;
+    registry_->unpin(*record_);
+    return result;
+}
+
+}
+
+#endif
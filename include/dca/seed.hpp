@@ -0,0 +1,248 @@
+#ifndef SEED_HPP
+#define SEED_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dca {
+
+namespace detail {
+
+// least-squares line through (x, y) points, accumulated in one pass
+class line_fit {
+    public:
+        line_fit() noexcept : n_(0), sx_(0.0), sy_(0.0), sxx_(0.0), sxy_(0.0)
+        { }
+
+        void add(double x, double y) noexcept
+        {
+            ++n_;
+            sx_ += x;
+            sy_ += y;
+            sxx_ += x * x;
+            sxy_ += x * y;
+        }
+
+        // at least two distinct x values
+        bool valid() const noexcept { return n_ >= 2 && denominator() > 0.0; }
+
+        double slope() const noexcept
+        {
+            return (n_ * sxy_ - sx_ * sy_) / denominator();
+        }
+
+        double intercept() const noexcept
+        {
+            return (sy_ - slope() * sx_) / n_;
+        }
+
+    private:
+        double denominator() const noexcept { return n_ * sxx_ - sx_ * sx_; }
+
+        double n_;
+        double sx_, sy_, sxx_, sxy_;
+};
+
+/*
+ * the linearisations used to seed decline fits, from one pass over the
+ * data as (time, rate, cumulative) samples:
+ *
+ *     ln q = ln qi - D t            (exponential)
+ *     1 / q = 1 / qi + (Di / qi) t  (harmonic)
+ *     1 / D = 1 / Di + b t          (hyperbolic loss ratio)
+ *     ln D = ln(n / tau^n) + (n - 1) ln t  (stretched exponential)
+ *     ln(q / Np) = ln a - m ln t    (Duong)
+ *
+ * D at each step is the slope of rate against cumulative between
+ * successive samples.
+ */
+struct seed_stats {
+    line_fit log_rate;
+    line_fit inverse_rate;
+    line_fit loss_ratio;
+    line_fit log_loss;
+    line_fit log_rate_cumulative;
+    double peak_rate = 0.0;
+    double time_last = 0.0;
+};
+
+template<class Samples>
+inline seed_stats gather_seed_stats(const Samples& samples)
+{
+    seed_stats s;
+    bool first = true;
+    double last_t = 0.0, last_q = 0.0, last_np = 0.0;
+    samples.each([&](double t, double q, double np) {
+        if (q > 0.0) {
+            s.log_rate.add(t, std::log(q));
+            s.inverse_rate.add(t, 1.0 / q);
+            if (t > 0.0 && np > 0.0)
+                s.log_rate_cumulative.add(std::log(t), std::log(q / np));
+        }
+        if (!first && np > last_np) {
+            double d = -(q - last_q) / (np - last_np);
+            double mid = 0.5 * (t + last_t);
+            if (d > 0.0) {
+                s.loss_ratio.add(mid, 1.0 / d);
+                if (mid > 0.0)
+                    s.log_loss.add(std::log(mid), std::log(d));
+            }
+        }
+        s.peak_rate = std::max(s.peak_rate, q);
+        s.time_last = t;
+        first = false;
+        last_t = t;
+        last_q = q;
+        last_np = np;
+    });
+    return s;
+}
+
+// rates observed at given times; cumulatives by the trapezoid rule
+template<class RateIter, class TimeIter>
+class rate_samples {
+    public:
+        rate_samples(RateIter rate_begin, RateIter rate_end,
+                TimeIter time_begin)
+            : rate_begin_(rate_begin), rate_end_(rate_end),
+              time_begin_(time_begin) { }
+
+        template<class Fn>
+        void each(Fn fn) const
+        {
+            auto time = time_begin_;
+            double np = 0.0, last_t = 0.0, last_q = 0.0;
+            for (auto rate = rate_begin_; rate != rate_end_; ++rate, ++time) {
+                double t = *time, q = *rate;
+                if (rate != rate_begin_)
+                    np += 0.5 * (q + last_q) * (t - last_t);
+                fn(t, q, np);
+                last_t = t;
+                last_q = q;
+            }
+        }
+
+        // least-squares qi for the shape of unit, a decline with qi = 1
+        template<class Decline>
+        double scale(const Decline& unit) const
+        {
+            double num = 0.0, den = 0.0;
+            auto time = time_begin_;
+            for (auto rate = rate_begin_; rate != rate_end_; ++rate, ++time) {
+                double g = unit.rate(*time);
+                num += *rate * g;
+                den += g * g;
+            }
+            return den > 0.0 ? num / den : 0.0;
+        }
+
+        template<class Decline>
+        double sse(const Decline& decl) const
+        {
+            double result = 0.0;
+            auto time = time_begin_;
+            for (auto rate = rate_begin_; rate != rate_end_; ++rate, ++time) {
+                double resid = *rate - decl.rate(*time);
+                result += resid * resid;
+            }
+            return result;
+        }
+
+    private:
+        RateIter rate_begin_, rate_end_;
+        TimeIter time_begin_;
+};
+
+/*
+ * volumes over successive steps from time_initial (as for
+ * sse_against_interval); each is an average rate at the step's midpoint
+ */
+template<class VolIter>
+class interval_samples {
+    public:
+        interval_samples(VolIter vol_begin, VolIter vol_end,
+                double time_initial, double time_step)
+            : vol_begin_(vol_begin), vol_end_(vol_end),
+              time_initial_(time_initial), time_step_(time_step) { }
+
+        template<class Fn>
+        void each(Fn fn) const
+        {
+            double t = time_initial_ + 0.5 * time_step_, np = 0.0;
+            for (auto vol = vol_begin_; vol != vol_end_; ++vol) {
+                fn(t, *vol / time_step_, np + 0.5 * *vol);
+                np += *vol;
+                t += time_step_;
+            }
+        }
+
+        template<class Decline>
+        double scale(const Decline& unit) const
+        {
+            double num = 0.0, den = 0.0;
+            each_interval(unit, [&](double vol, double g) {
+                num += vol * g;
+                den += g * g;
+            });
+            return den > 0.0 ? num / den : 0.0;
+        }
+
+        template<class Decline>
+        double sse(const Decline& decl) const
+        {
+            double result = 0.0;
+            each_interval(decl, [&](double vol, double interval) {
+                double resid = vol - interval;
+                result += resid * resid;
+            });
+            return result;
+        }
+
+    private:
+        // observed and modeled volumes, step by step
+        template<class Decline, class Fn>
+        void each_interval(const Decline& decl, Fn fn) const
+        {
+            double t = time_initial_, last_cum = 0.0;
+            for (auto vol = vol_begin_; vol != vol_end_; ++vol) {
+                t += time_step_;
+                double cum = decl.cumulative(t);
+                fn(*vol, cum - last_cum);
+                last_cum = cum;
+            }
+        }
+
+        VolIter vol_begin_, vol_end_;
+        double time_initial_, time_step_;
+};
+
+template<class RateIter, class TimeIter>
+inline rate_samples<RateIter, TimeIter> make_rate_samples(
+        RateIter rate_begin, RateIter rate_end, TimeIter time_begin)
+{
+    return rate_samples<RateIter, TimeIter>(rate_begin, rate_end,
+            time_begin);
+}
+
+template<class VolIter>
+inline interval_samples<VolIter> make_interval_samples(
+        VolIter vol_begin, VolIter vol_end,
+        double time_initial, double time_step)
+{
+    return interval_samples<VolIter>(vol_begin, vol_end, time_initial,
+            time_step);
+}
+
+// x kept within [lo, hi]; lo when x is not a number
+inline double clamp_seed(double x, double lo, double hi) noexcept
+{
+    return x > lo ? (x < hi ? x : hi) : lo;
+}
+
+}
+
+}
+
+#endif
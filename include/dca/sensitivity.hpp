@@ -0,0 +1,274 @@
+#ifndef SENSITIVITY_HPP
+#define SENSITIVITY_HPP
+
+#include "parallel.hpp"
+#include "tuple_tools.hpp"
+#include "convex.hpp"
+#include "decline.hpp"
+#include "duong.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <array>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dca {
+
+struct eur_query {
+    double economic_limit;
+    double max_time;
+};
+
+struct eur_result {
+    double eur;
+    double time; // to the economic limit, or max_time
+};
+
+namespace detail {
+
+// whether a model's rate never rises, as eur_batch's root-find assumes
+template<class Decline>
+struct non_increasing_rate : std::true_type { };
+
+template<>
+struct non_increasing_rate<duong> : std::false_type { };
+
+}
+
+/*
+ * EUR and time to limit for many (decline, query) cases at once: the same
+ * answer as dca::eur, but found by a bracketed root-find on rate(t) = limit
+ * (Arps rates are non-increasing in time) run in lockstep across the whole
+ * batch, in place of one Nelder-Mead search per case. models whose rates
+ * climb (Duong's) take their own time_to_rate instead.
+ */
+template<class Decline>
+inline std::vector<eur_result> eur_batch(
+        const std::vector<Decline>& declines,
+        const std::vector<eur_query>& queries,
+        double time_eps = 1e-10, int max_iter = 200)
+{
+    const std::size_t n = declines.size();
+    const double max_bracket = 1e4; // years, give or take
+
+    std::vector<double> lo(n, 0.0), hi(n), f_lo(n), f_hi(n);
+    std::vector<eur_result> result(n);
+    std::vector<std::size_t> active;
+    active.reserve(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& q = queries[i];
+        if (!detail::non_increasing_rate<Decline>::value) {
+            result[i].time = time_to_rate(declines[i], q.economic_limit);
+            continue;
+        }
+        f_lo[i] = declines[i].rate(0.0) - q.economic_limit;
+        if (f_lo[i] <= 0.0 || q.max_time <= 0.0) {
+            result[i].time = 0.0;
+        } else {
+            hi[i] = std::min(1.0, q.max_time);
+            f_hi[i] = declines[i].rate(hi[i]) - q.economic_limit;
+            active.push_back(i);
+        }
+    }
+
+    // double until the limit is bracketed, or max_time is reached
+    for (std::size_t i : active) {
+        const double cap = std::min(queries[i].max_time, max_bracket);
+        while (f_hi[i] > 0.0 && hi[i] < cap) {
+            lo[i] = hi[i];
+            f_lo[i] = f_hi[i];
+            hi[i] = std::min(2.0 * hi[i], cap);
+            f_hi[i] = declines[i].rate(hi[i]) - queries[i].economic_limit;
+        }
+    }
+
+    // Illinois-modified regula falsi, all unconverged cases per iteration
+    std::vector<int> side(n, 0);
+    for (int iter = 0; iter < max_iter && !active.empty(); ++iter) {
+        std::size_t still_active = 0;
+        for (std::size_t i : active) {
+            if (f_hi[i] > 0.0) { // still above the limit at max_time
+                result[i].time = hi[i];
+                continue;
+            }
+
+            double t = lo[i] + (hi[i] - lo[i]) * f_lo[i] / (f_lo[i] - f_hi[i]);
+            if (!(t > lo[i] && t < hi[i]))
+                t = 0.5 * (lo[i] + hi[i]);
+            if (hi[i] - lo[i] <= time_eps * (1.0 + hi[i])) {
+                result[i].time = t;
+                continue;
+            }
+
+            double f = declines[i].rate(t) - queries[i].economic_limit;
+            if (f == 0.0) {
+                result[i].time = t;
+                continue;
+            } else if (f > 0.0) {
+                lo[i] = t;
+                f_lo[i] = f;
+                if (side[i] == -1)
+                    f_hi[i] *= 0.5;
+                side[i] = -1;
+            } else {
+                hi[i] = t;
+                f_hi[i] = f;
+                if (side[i] == 1)
+                    f_lo[i] *= 0.5;
+                side[i] = 1;
+            }
+
+            active[still_active++] = i;
+        }
+        active.resize(still_active);
+    }
+
+    for (std::size_t i : active)
+        result[i].time = 0.5 * (lo[i] + hi[i]);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        result[i].time = std::min(result[i].time, queries[i].max_time);
+        result[i].eur = declines[i].cumulative(result[i].time);
+    }
+
+    return result;
+}
+
+struct eur_perturbation {
+    // index into the decline's parameter tuple, or one of these
+    static const std::size_t economic_limit = static_cast<std::size_t>(-1);
+    static const std::size_t max_time = static_cast<std::size_t>(-2);
+
+    std::size_t input;
+    double low;  // relative change, e.g. -0.1 for -10%
+    double high; // e.g. +0.1 for +10%
+};
+
+struct tornado_bar {
+    eur_perturbation perturbation;
+    bool valid; // false if the decline rejected either perturbed case
+    eur_result low;
+    eur_result high;
+    double low_delta;  // low.eur - base EUR
+    double high_delta; // high.eur - base EUR
+    double elasticity; // (dEUR / EUR) / (dx / x), central difference
+};
+
+struct eur_tornado {
+    eur_result base;
+    std::vector<tornado_bar> bars; // widest swing first
+};
+
+/*
+ * EUR sensitivity of one decline to relative changes in its parameters,
+ * the economic limit and max_time; every perturbed case is evaluated in
+ * one eur_batch. perturbed parameter sets the decline rejects give NaN
+ * results and an invalid bar.
+ */
+template<class Decline, class... Params>
+inline eur_tornado eur_sensitivity(const std::tuple<Params...>& params,
+        double economic_limit, double max_time,
+        const std::vector<eur_perturbation>& perturbations)
+{
+    using params_type = std::tuple<Params...>;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    auto base = convex::detail::tuple_to_array(params);
+    auto base_decline = tuple::construct<Decline>(params);
+
+    std::vector<Decline> declines;
+    std::vector<eur_query> queries;
+    std::vector<std::size_t> case_index; // into declines, or -1 if invalid
+
+    auto add_case = [&](const eur_perturbation& p, double change) {
+        eur_query q { economic_limit, max_time };
+        if (p.input == eur_perturbation::economic_limit) {
+            q.economic_limit *= 1.0 + change;
+            declines.push_back(base_decline);
+        } else if (p.input == eur_perturbation::max_time) {
+            q.max_time *= 1.0 + change;
+            declines.push_back(base_decline);
+        } else {
+            auto perturbed = base;
+            perturbed.at(p.input) *= 1.0 + change;
+            try {
+                declines.push_back(tuple::construct<Decline>(
+                    convex::detail::array_to_tuple<params_type>(perturbed)));
+            } catch (...) {
+                case_index.push_back(static_cast<std::size_t>(-1));
+                return;
+            }
+        }
+        queries.push_back(q);
+        case_index.push_back(declines.size() - 1);
+    };
+
+    declines.push_back(base_decline);
+    queries.push_back(eur_query { economic_limit, max_time });
+    for (const auto& p : perturbations) {
+        add_case(p, p.low);
+        add_case(p, p.high);
+    }
+
+    auto results = eur_batch(declines, queries);
+    auto lookup = [&](std::size_t c) {
+        std::size_t i = case_index[c];
+        return i == static_cast<std::size_t>(-1)
+            ? eur_result { nan, nan } : results[i];
+    };
+
+    eur_tornado tornado;
+    tornado.base = results[0];
+    for (std::size_t k = 0; k < perturbations.size(); ++k) {
+        tornado_bar bar;
+        bar.perturbation = perturbations[k];
+        bar.low = lookup(2 * k);
+        bar.high = lookup(2 * k + 1);
+        bar.valid = case_index[2 * k] != static_cast<std::size_t>(-1)
+            && case_index[2 * k + 1] != static_cast<std::size_t>(-1);
+        bar.low_delta = bar.low.eur - tornado.base.eur;
+        bar.high_delta = bar.high.eur - tornado.base.eur;
+        bar.elasticity = (bar.high.eur - bar.low.eur) / tornado.base.eur
+            / (bar.perturbation.high - bar.perturbation.low);
+        tornado.bars.push_back(bar);
+    }
+
+    std::stable_sort(tornado.bars.begin(), tornado.bars.end(),
+            [](const tornado_bar& a, const tornado_bar& b) {
+                if (a.valid != b.valid)
+                    return a.valid;
+                return std::abs(a.high_delta - a.low_delta)
+                    > std::abs(b.high_delta - b.low_delta);
+            });
+
+    return tornado;
+}
+
+// as above for many wells' parameter tuples, in parallel across wells
+template<class Decline, class ParamIter, class OutIter>
+inline OutIter eur_sensitivity(ParamIter params_begin, ParamIter params_end,
+        double economic_limit, double max_time,
+        const std::vector<eur_perturbation>& perturbations, OutIter out,
+        unsigned threads = 0)
+{
+    std::vector<typename std::iterator_traits<ParamIter>::value_type>
+        params(params_begin, params_end);
+    std::vector<eur_tornado> tornados(params.size());
+
+    parallel_for(params.size(), [&](std::size_t i) {
+        tornados[i] = eur_sensitivity<Decline>(params[i], economic_limit,
+                max_time, perturbations);
+    }, threads);
+
+    return std::move(tornados.begin(), tornados.end(), out);
+}
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef SERIALIZE_HPP
+#define SERIALIZE_HPP
+
+#include "any_decline.hpp"
+#include "codec.hpp"
+#include "exponential.hpp"
+#include "hyperbolic.hpp"
+#include "hyptoexp.hpp"
+#include "stretched.hpp"
+#include "duong.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace dca {
+
+/*
+ * declines in binary, to pass fits between pipeline stages without parsing.
+ * a batch is native-endian and laid out so that a mapped file (or any
+ * 8-byte aligned buffer) can be used in place:
+ *
+ *     "DCAD", u32 version, u64 count, u32 width, u32 reserved (0)
+ *     u32 tag per decline, zero-padded to a multiple of 8 bytes
+ *     width columns of count doubles: parameter p of every decline
+ *
+ * parameters are in constructor order; width is the most any decline in
+ * the batch has, and narrower declines' extra columns are zero. so a batch
+ * of one model holds its parameters as SoA arrays, as the batch fitters
+ * and kernels take them.
+ */
+const std::uint32_t decline_binary_version = 1;
+
+// dca::any in batches: whichever model it holds, decoded by tag
+template<>
+struct decline_codec<any> {
+    static decline_tag tag(const any& d) noexcept
+    {
+        return d.tag();
+    }
+
+    static std::size_t encode(const any& d, double* params) noexcept
+    {
+        return d.encode(params);
+    }
+
+    static any decode(decline_tag tag, const double* params)
+    {
+        switch (tag) {
+            case decline_tag::arps_exponential:
+                return decline_codec<arps_exponential>::decode(tag, params);
+            case decline_tag::arps_hyperbolic:
+                return decline_codec<arps_hyperbolic>::decode(tag, params);
+            case decline_tag::arps_hyperbolic_to_exponential:
+                return decline_codec<arps_hyperbolic_to_exponential>::decode(
+                        tag, params);
+            case decline_tag::stretched_exponential:
+                return decline_codec<stretched_exponential>::decode(tag,
+                        params);
+            case decline_tag::duong:
+                return decline_codec<duong>::decode(tag, params);
+            default:
+                throw std::invalid_argument("Unknown decline type.");
+        }
+    }
+};
+
+namespace detail {
+
+// the parameters a tag's model has; 0 for tags no model has
+inline std::size_t tag_width(decline_tag tag) noexcept
+{
+    switch (tag) {
+        case decline_tag::arps_exponential:
+            return decline_codec<arps_exponential>::width;
+        case decline_tag::arps_hyperbolic:
+            return decline_codec<arps_hyperbolic>::width;
+        case decline_tag::arps_hyperbolic_to_exponential:
+            return decline_codec<arps_hyperbolic_to_exponential>::width;
+        case decline_tag::stretched_exponential:
+            return decline_codec<stretched_exponential>::width;
+        case decline_tag::duong:
+            return decline_codec<duong>::width;
+        default:
+            return 0;
+    }
+}
+
+const std::size_t decline_batch_header = 24;
+
+inline std::size_t decline_batch_tags(std::size_t count) noexcept
+{
+    return (count * sizeof(std::uint32_t) + 7) / 8 * 8;
+}
+
+}
+
+// the bytes in a batch of count declines of up to width parameters
+inline std::size_t decline_batch_size(std::size_t count,
+        std::size_t width) noexcept
+{
+    return detail::decline_batch_header + detail::decline_batch_tags(count)
+        + width * count * sizeof(double);
+}
+
+/*
+ * append [begin, end) to out as a batch. the declines may be of any model
+ * with a codec, or dca::any holding one; throws std::invalid_argument for
+ * one without an encoding.
+ */
+template<class DeclineIter>
+inline void serialize_declines(DeclineIter begin, DeclineIter end,
+        std::vector<char>& out)
+{
+    using decline_type =
+        typename std::iterator_traits<DeclineIter>::value_type;
+    using codec = decline_codec<decline_type>;
+
+    std::vector<std::uint32_t> tags;
+    std::vector<std::array<double, max_decline_params>> params;
+    std::size_t width = 0;
+    for (; begin != end; ++begin) {
+        decline_tag tag = codec::tag(*begin);
+        if (tag == decline_tag::none)
+            throw std::invalid_argument("Decline has no binary encoding.");
+        std::array<double, max_decline_params> p {};
+        width = std::max(width, codec::encode(*begin, p.data()));
+        tags.push_back(static_cast<std::uint32_t>(tag));
+        params.push_back(p);
+    }
+
+    const std::size_t count = tags.size();
+    std::size_t offset = out.size();
+    out.resize(offset + decline_batch_size(count, width));
+    char* p = out.data() + offset;
+
+    const std::uint32_t version = decline_binary_version;
+    const std::uint64_t count64 = count;
+    const std::uint32_t width32 = static_cast<std::uint32_t>(width);
+    const std::uint32_t reserved = 0;
+    std::memcpy(p, "DCAD", 4);
+    std::memcpy(p + 4, &version, 4);
+    std::memcpy(p + 8, &count64, 8);
+    std::memcpy(p + 16, &width32, 4);
+    std::memcpy(p + 20, &reserved, 4);
+    p += detail::decline_batch_header;
+
+    std::memset(p, 0, detail::decline_batch_tags(count));
+    if (count)
+        std::memcpy(p, tags.data(), count * sizeof(std::uint32_t));
+    p += detail::decline_batch_tags(count);
+
+    for (std::size_t c = 0; c < width; ++c)
+        for (std::size_t i = 0; i < count; ++i, p += sizeof(double))
+            std::memcpy(p, &params[i][c], sizeof(double));
+}
+
+/*
+ * a batch in memory (e.g. a mapped file), used in place: the buffer must be
+ * 8-byte aligned and outlive the view. the constructor checks the header
+ * and size, throwing std::invalid_argument.
+ */
+class decline_batch_view {
+    public:
+        decline_batch_view(const void* data, std::size_t size);
+
+        std::size_t size() const noexcept { return count_; }
+        std::size_t width() const noexcept { return width_; }
+
+        decline_tag tag(std::size_t i) const noexcept
+        {
+            return static_cast<decline_tag>(tags_[i]);
+        }
+
+        // parameter p of every decline, p < width()
+        const double* column(std::size_t p) const noexcept
+        {
+            return columns_ + p * count_;
+        }
+
+        // the i'th decline, as Decline (or dca::any); throws
+        // std::invalid_argument if width() is short of its tag's model
+        template<class Decline>
+        Decline get(std::size_t i) const;
+
+    private:
+        const std::uint32_t* tags_;
+        const double* columns_;
+        std::size_t count_;
+        std::size_t width_;
+};
+
+inline decline_batch_view::decline_batch_view(const void* data,
+        std::size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    if (reinterpret_cast<std::uintptr_t>(p) % alignof(double) != 0)
+        throw std::invalid_argument("Decline batch is misaligned.");
+    if (size < detail::decline_batch_header || std::memcmp(p, "DCAD", 4))
+        throw std::invalid_argument("Not a decline batch.");
+
+    std::uint32_t version, width;
+    std::uint64_t count;
+    std::memcpy(&version, p + 4, 4);
+    std::memcpy(&count, p + 8, 8);
+    std::memcpy(&width, p + 16, 4);
+    if (version != decline_binary_version)
+        throw std::invalid_argument("Unsupported decline batch version.");
+    if (width > max_decline_params
+            || count > (size - detail::decline_batch_header) / 4
+            || size < decline_batch_size(count, width))
+        throw std::invalid_argument("Truncated decline batch.");
+
+    count_ = static_cast<std::size_t>(count);
+    width_ = width;
+    tags_ = reinterpret_cast<const std::uint32_t*>(
+            p + detail::decline_batch_header);
+    columns_ = reinterpret_cast<const double*>(p
+            + detail::decline_batch_header
+            + detail::decline_batch_tags(count_));
+}
+
+template<class Decline>
+inline Decline decline_batch_view::get(std::size_t i) const
+{
+    if (detail::tag_width(tag(i)) > width_)
+        throw std::invalid_argument("Decline batch is too narrow.");
+    std::array<double, max_decline_params> params {};
+    for (std::size_t p = 0; p < width_; ++p)
+        params[p] = column(p)[i];
+    return decline_codec<Decline>::decode(tag(i), params.data());
+}
+
+// every decline in a batch, as Decline (or dca::any), to out
+template<class Decline, class OutIter>
+inline OutIter deserialize_declines(const decline_batch_view& batch,
+        OutIter out)
+{
+    for (std::size_t i = 0; i < batch.size(); ++i)
+        *out++ = batch.get<Decline>(i);
+    return out;
+}
+
+}
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef STRETCHED_HPP
+#define STRETCHED_HPP
+
+#include "codec.hpp"
+#include "profile.hpp"
+#include <stdexcept>
+#include <cmath>
+#ifndef DCA_NO_IOSTREAMS
+#include <iostream>
+#endif
+
+namespace dca {
+
+/*
+ * stretched exponential (Valko): q = qi exp(-(t / tau)^n), 0 < n <= 1, with
+ * cumulative
+ *
+ *     Np = qi tau / n * gamma(1 / n, (t / tau)^n)
+ *
+ * gamma the lower incomplete gamma function; n = 1 is exponential with
+ * D = 1 / tau.
+ */
+template<class Real>
+class basic_stretched_exponential {
+    public:
+        basic_stretched_exponential(Real qi, Real tau, Real n);
+
+        const Real& qi() const noexcept;
+        const Real& tau() const noexcept;
+        const Real& n() const noexcept;
+
+        Real rate(Real time) const noexcept;
+        Real cumulative(Real time) const noexcept;
+        Real D(Real time) const noexcept;
+
+    private:
+        Real qi_;
+        Real tau_;
+        Real n_;
+};
+
+using stretched_exponential = basic_stretched_exponential<double>;
+
+namespace detail {
+
+// ln Gamma(s) for s >= 1/2 (Lanczos, g = 7)
+template<class Real>
+inline Real log_gamma(const Real& s) noexcept
+{
+    using std::log;
+
+    static const double c[] = {
+        0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+        771.32342877765313, -176.61502916214059, 12.507343278686905,
+        -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7
+    };
+    const double half_log_2pi = 0.91893853320467274;
+
+    Real x = s - 1.0;
+    Real sum = c[0];
+    for (int i = 1; i < 9; ++i)
+        sum += c[i] / (x + double(i));
+    Real t = x + 7.5;
+    return half_log_2pi + (x + 0.5) * log(t) - t + log(sum);
+}
+
+/*
+ * lower incomplete gamma(s, x) for s >= 1/2, x >= 0: by its power series
+ * below x = s + 1, else as Gamma(s) less the upper function's continued
+ * fraction (modified Lentz). both converge in a few dozen terms.
+ */
+template<class Real>
+inline Real lower_gamma(const Real& s, const Real& x) noexcept
+{
+    using std::abs;
+    using std::exp;
+    using std::log;
+
+    const double eps = 1e-16, tiny = 1e-300;
+    const int max_terms = 500;
+
+    if (x <= 0.0)
+        return Real(0.0);
+
+    Real scale = exp(s * log(x) - x); // x^s e^-x
+
+    if (x < s + 1.0) {
+        Real term = 1.0 / s, sum = term;
+        for (int k = 1; k < max_terms; ++k) {
+            term *= x / (s + double(k));
+            sum += term;
+            if (term < sum * eps)
+                break;
+        }
+        return scale * sum;
+    }
+
+    Real b = x + 1.0 - s, c = 1.0 / tiny, d = 1.0 / b, h = d;
+    for (int i = 1; i < max_terms; ++i) {
+        Real a = -double(i) * (double(i) - s);
+        b += 2.0;
+        d = a * d + b;
+        if (abs(d) < tiny)
+            d = tiny;
+        c = b + a / c;
+        if (abs(c) < tiny)
+            c = tiny;
+        d = 1.0 / d;
+        Real delta = d * c;
+        h *= delta;
+        if (abs(delta - 1.0) < eps)
+            break;
+    }
+    return exp(log_gamma(s)) - scale * h;
+}
+
+}
+
+template<class Real>
+inline basic_stretched_exponential<Real>::basic_stretched_exponential(
+        Real qi, Real tau, Real n)
+    : qi_(qi), tau_(tau), n_(n)
+{
+    if (qi_ < 0.0)
+        throw std::out_of_range("qi must be non-negative.");
+    if (!(tau_ > 0.0))
+        throw std::out_of_range("tau must be positive.");
+    if (!(n_ > 0.0))
+        throw std::out_of_range("n must be positive.");
+    if (n_ > 1.0)
+        throw std::out_of_range("n must not exceed 1.");
+}
+
+template<class Real>
+inline const Real& basic_stretched_exponential<Real>::qi() const noexcept
+{
+    return qi_;
+}
+
+template<class Real>
+inline const Real& basic_stretched_exponential<Real>::tau() const noexcept
+{
+    return tau_;
+}
+
+template<class Real>
+inline const Real& basic_stretched_exponential<Real>::n() const noexcept
+{
+    return n_;
+}
+
+template<class Real>
+inline Real basic_stretched_exponential<Real>::rate(Real time) const noexcept
+{
+    using std::exp;
+    using std::pow;
+
+    DCA_PROFILE_COUNT(rate);
+    if (time < 0.0) return 0.0;
+    if (time <= 0.0) return qi_; // (t / tau)^n has no n-derivative at 0
+    return qi_ * exp(-pow(time / tau_, n_));
+}
+
+template<class Real>
+inline Real basic_stretched_exponential<Real>::cumulative(Real time) const
+  noexcept
+{
+    using std::pow;
+
+    DCA_PROFILE_COUNT(cumulative);
+    if (time <= 0.0) return 0.0;
+    return qi_ * tau_ / n_ *
+        detail::lower_gamma(1.0 / n_, pow(time / tau_, n_));
+}
+
+template<class Real>
+inline Real basic_stretched_exponential<Real>::D(Real time) const noexcept
+{
+    using std::pow;
+
+    return n_ / tau_ * pow(time / tau_, n_ - 1.0);
+}
+
+#ifndef DCA_NO_IOSTREAMS
+template<class Real>
+inline std::ostream& operator<<(std::ostream& os,
+        const basic_stretched_exponential<Real>& d)
+{
+    return os << "<Stretched exponential decline: (qi = " << d.qi()
+        << ", tau = " << d.tau() << ", n = " << d.n() << ")>";
+}
+#endif
+
+template<>
+struct decline_codec<stretched_exponential> {
+    static constexpr std::size_t width = 3;
+
+    static decline_tag tag(const stretched_exponential&) noexcept
+    {
+        return decline_tag::stretched_exponential;
+    }
+
+    static std::size_t encode(const stretched_exponential& d, double* params)
+        noexcept
+    {
+        params[0] = d.qi();
+        params[1] = d.tau();
+        params[2] = d.n();
+        return width;
+    }
+
+    static stretched_exponential decode(decline_tag tag, const double* params)
+    {
+        detail::check_tag(tag, decline_tag::stretched_exponential);
+        return stretched_exponential(params[0], params[1], params[2]);
+    }
+};
+
+#ifdef DCA_EXTERN_TEMPLATES // compiled into libdca.a
+extern template class basic_stretched_exponential<double>;
+#endif
+
+}
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef TABLE_HPP
+#define TABLE_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#ifndef DCA_NO_IOSTREAMS
+#include <iostream>
+#endif
+
+namespace dca {
+
+/*
+ * a decline (any type with rate and cumulative, including dca::any)
+ * sampled once onto a uniform time grid. between grid points cumulative is
+ * the cubic Hermite interpolant of the sampled cumulatives and rates, and
+ * rate is its derivative, so the two stay consistent and both are exact at
+ * the grid points. the interpolation error is measured at construction
+ * where the Hermite error terms peak (see cumulative_error, rate_error).
+ *
+ * tables are cheap to copy: copies share the samples. rates and volumes
+ * are proportional to qi for every decline model, so scaled() rescales a
+ * table (e.g. a type curve to a location's expected qi) without resampling.
+ */
+class forecast_table {
+    public:
+        // samples at time_begin + i * time_step, i in [0, intervals]
+        template<class Decline>
+        forecast_table(const Decline& decline, double time_begin,
+                double time_step, std::size_t intervals);
+
+        double time_begin() const noexcept;
+        double time_end() const noexcept;
+        double time_step() const noexcept;
+        std::size_t intervals() const noexcept;
+
+        // throw std::out_of_range outside [time_begin, time_end]
+        double rate(double time) const;
+        double cumulative(double time) const;
+
+        /*
+         * time at which cumulative reaches cum; throws std::out_of_range
+         * unless cumulative(time_begin) <= cum <= cumulative(time_end)
+         */
+        double time_to_cumulative(double cum) const;
+
+        // worst absolute interpolation errors over the table
+        double cumulative_error() const noexcept;
+        double rate_error() const noexcept;
+
+        // this table with rates and volumes multiplied by factor
+        forecast_table scaled(double factor) const;
+        double scale() const noexcept;
+
+    private:
+        struct samples {
+            double time_begin;
+            double time_step;
+            std::vector<double> rate;
+            std::vector<double> cumulative;
+            double cumulative_error;
+            double rate_error;
+        };
+
+        // interval containing time, and the position within it in [0, 1]
+        std::size_t locate(double time, double& s) const;
+        double interpolate_cumulative(std::size_t i, double s) const noexcept;
+        double interpolate_rate(std::size_t i, double s) const noexcept;
+
+        std::shared_ptr<const samples> samples_;
+        double scale_;
+};
+
+template<class Decline>
+inline forecast_table::forecast_table(const Decline& decline,
+        double time_begin, double time_step, std::size_t intervals)
+    : scale_(1.0)
+{
+    if (!(time_step > 0.0))
+        throw std::out_of_range("time_step must be positive.");
+    if (intervals == 0)
+        throw std::out_of_range("Forecast table needs at least one interval.");
+
+    std::shared_ptr<samples> s(new samples());
+    s->time_begin = time_begin;
+    s->time_step = time_step;
+    s->rate.reserve(intervals + 1);
+    s->cumulative.reserve(intervals + 1);
+    for (std::size_t i = 0; i <= intervals; ++i) {
+        double t = time_begin + i * time_step;
+        s->rate.push_back(decline.rate(t));
+        s->cumulative.push_back(decline.cumulative(t));
+    }
+
+    samples_ = s;
+
+    /*
+     * the cumulative error is (t - a)^2 (t - b)^2 Q''''(xi) / 4!, peaking at
+     * the midpoint; the rate error, its derivative, peaks at
+     * (1/2 -+ 1/(2 sqrt 3)) of the way through. measuring there bounds the
+     * error as far as the rate's third derivative is steady over one step.
+     */
+    const double offset = 0.5 - 0.5 / std::sqrt(3.0);
+    double cum_error = 0.0, rate_error = 0.0;
+    for (std::size_t i = 0; i < intervals; ++i) {
+        double t = time_begin + i * time_step;
+        cum_error = std::max(cum_error, std::abs(
+                    interpolate_cumulative(i, 0.5)
+                    - decline.cumulative(t + 0.5 * time_step)));
+        for (double at : { offset, 1.0 - offset })
+            rate_error = std::max(rate_error, std::abs(
+                        interpolate_rate(i, at)
+                        - decline.rate(t + at * time_step)));
+    }
+    s->cumulative_error = cum_error;
+    s->rate_error = rate_error;
+}
+
+inline double forecast_table::time_begin() const noexcept
+{
+    return samples_->time_begin;
+}
+
+inline double forecast_table::time_end() const noexcept
+{
+    return samples_->time_begin + intervals() * samples_->time_step;
+}
+
+inline double forecast_table::time_step() const noexcept
+{
+    return samples_->time_step;
+}
+
+inline std::size_t forecast_table::intervals() const noexcept
+{
+    return samples_->rate.size() - 1;
+}
+
+inline double forecast_table::rate(double time) const
+{
+    double s;
+    std::size_t i = locate(time, s);
+    return scale_ * interpolate_rate(i, s);
+}
+
+inline double forecast_table::cumulative(double time) const
+{
+    double s;
+    std::size_t i = locate(time, s);
+    return scale_ * interpolate_cumulative(i, s);
+}
+
+inline double forecast_table::time_to_cumulative(double cum) const
+{
+    const auto& q = samples_->cumulative;
+    cum /= scale_;
+    if (cum < q.front() || cum > q.back())
+        throw std::out_of_range("Cumulative outside forecast table.");
+
+    // first interval ending at or past cum
+    auto found = std::lower_bound(q.begin() + 1, q.end(), cum);
+    std::size_t i = static_cast<std::size_t>(found - q.begin()) - 1;
+
+    // Newton's method on the cubic, kept inside the bracket by bisection
+    double lo = 0.0, hi = 1.0, s = 0.5;
+    const double h = samples_->time_step;
+    for (int iter = 0; iter < 60; ++iter) {
+        double f = interpolate_cumulative(i, s) - cum;
+        if (f == 0.0)
+            break;
+        if (f < 0.0)
+            lo = s;
+        else
+            hi = s;
+
+        double df = h * interpolate_rate(i, s);
+        double next = s - f / df;
+        if (!(df > 0.0) || next <= lo || next >= hi)
+            next = 0.5 * (lo + hi);
+        if (std::abs(next - s) < 1e-15)
+            break;
+        s = next;
+    }
+
+    return samples_->time_begin + (i + s) * h;
+}
+
+inline double forecast_table::cumulative_error() const noexcept
+{
+    return std::abs(scale_) * samples_->cumulative_error;
+}
+
+inline double forecast_table::rate_error() const noexcept
+{
+    return std::abs(scale_) * samples_->rate_error;
+}
+
+inline forecast_table forecast_table::scaled(double factor) const
+{
+    if (!(factor > 0.0))
+        throw std::out_of_range("Scale factor must be positive.");
+    forecast_table result(*this);
+    result.scale_ *= factor;
+    return result;
+}
+
+inline double forecast_table::scale() const noexcept
+{
+    return scale_;
+}
+
+inline std::size_t forecast_table::locate(double time, double& s) const
+{
+    double x = (time - samples_->time_begin) / samples_->time_step;
+    const auto n = intervals();
+    // forgive rounding in grid arithmetic, e.g. 600 * (1.0 / 12.0)
+    const double slack = 1e-9 * static_cast<double>(n);
+    if (x < -slack || x > static_cast<double>(n) + slack)
+        throw std::out_of_range("Time outside forecast table.");
+    x = std::min(std::max(x, 0.0), static_cast<double>(n));
+
+    auto i = std::min(static_cast<std::size_t>(x), n - 1);
+    s = x - static_cast<double>(i);
+    return i;
+}
+
+inline double forecast_table::interpolate_cumulative(std::size_t i, double s)
+  const noexcept
+{
+    const auto& q = samples_->rate;
+    const auto& cum = samples_->cumulative;
+    const double h = samples_->time_step;
+    double s2 = s * s, s3 = s2 * s;
+    return (2.0 * s3 - 3.0 * s2 + 1.0) * cum[i]
+        + (s3 - 2.0 * s2 + s) * h * q[i]
+        + (3.0 * s2 - 2.0 * s3) * cum[i + 1]
+        + (s3 - s2) * h * q[i + 1];
+}
+
+inline double forecast_table::interpolate_rate(std::size_t i, double s)
+  const noexcept
+{
+    const auto& q = samples_->rate;
+    const auto& cum = samples_->cumulative;
+    const double h = samples_->time_step;
+    double s2 = s * s;
+    return 6.0 * (s - s2) * (cum[i + 1] - cum[i]) / h
+        + (3.0 * s2 - 4.0 * s + 1.0) * q[i]
+        + (3.0 * s2 - 2.0 * s) * q[i + 1];
+}
+
+#ifndef DCA_NO_IOSTREAMS
+inline std::ostream& operator<<(std::ostream& os, const forecast_table& t)
+{
+    return os << "<Forecast table: (" << t.intervals() << " intervals, "
+        << t.time_begin() << " to " << t.time_end() << ", scale = "
+        << t.scale() << ")>";
+}
+#endif
+
+}
+
+#endif
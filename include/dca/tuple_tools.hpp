@@ -137,7 +137,7 @@ auto shuffle_left(const std::tuple<Params...>& tuple)
     return detail::shuffle_left_impl(tuple);
 }
 
-template<>
+template<> inline
 auto shuffle_left(const std::tuple<>& tuple)
 {
     return tuple;
@@ -149,7 +149,7 @@ auto shuffle_right(const std::tuple<Params...>& tuple)
     return detail::shuffle_right_impl(tuple);
 }
 
-template<>
+template<> inline
 auto shuffle_right(const std::tuple<>& tuple)
 {
     return tuple;
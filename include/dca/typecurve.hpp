@@ -0,0 +1,109 @@
+#ifndef TYPECURVE_HPP
+#define TYPECURVE_HPP
+
+#include "bestfit.hpp"
+#include "parallel.hpp"
+#include "production.hpp"
+
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace dca {
+
+template<class Key, class Decline>
+struct type_curve {
+    Key key;
+    std::size_t wells;
+    std::vector<double> type_well; // aggregated interval volumes
+    Decline decline; // best fit to type_well
+};
+
+/*
+ * type curves for every group of wells at once: keys[i] is the group of the
+ * i'th production range (as for aggregate_production), and each group's
+ * type well uses at least floor(min_fraction * wells in group) streams, and
+ * at least one, per month. groups are aggregated and fit (as
+ * best_from_interval_volume, with options) in parallel, on up to `threads`
+ * threads (0: one per hardware thread), each reusing its own scratch
+ * buffers. results are ordered by key; groups whose type well is shorter
+ * than the decline's parameter count are omitted.
+ */
+template<class Decline, class KeyIter, class ProdRangeIter, class AggFn>
+inline std::vector<type_curve<
+    typename std::iterator_traits<KeyIter>::value_type, Decline>>
+grouped_type_curves(KeyIter key_begin, KeyIter key_end,
+        ProdRangeIter prod_begin, double min_fraction, AggFn aggregate,
+        double time_initial, double time_step,
+        const fit_options& options = fit_options {}, unsigned threads = 0)
+{
+    using key_type = typename std::iterator_traits<KeyIter>::value_type;
+    using prod_range =
+        typename std::iterator_traits<ProdRangeIter>::value_type;
+    using params_type = typename detail::decline_traits<Decline>::params;
+
+    std::vector<key_type> keys(key_begin, key_end);
+    std::vector<prod_range> ranges(prod_begin,
+            std::next(prod_begin, keys.size()));
+
+    // well indices sorted by group: [group_begin[g], group_begin[g + 1])
+    std::vector<std::size_t> order(keys.size());
+    step_series(order.begin(), order.end(), std::size_t(0), std::size_t(1));
+    std::stable_sort(order.begin(), order.end(),
+            [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+
+    std::vector<std::size_t> group_begin;
+    for (std::size_t i = 0; i < order.size(); ++i)
+        if (i == 0 || keys[order[i - 1]] < keys[order[i]])
+            group_begin.push_back(i);
+    const std::size_t groups = group_begin.size();
+    group_begin.push_back(order.size());
+
+    std::vector<std::vector<double>> type_wells(groups);
+    std::vector<std::vector<Decline>> fits(groups); // empty or one
+
+    // scratch buffers for each worker thread, reused from group to group
+    unsigned workers = parallel_threads(groups, threads);
+    std::vector<std::vector<prod_range>> streams(workers);
+    std::vector<std::vector<double>> prod(workers);
+
+    parallel_for_worker(groups, [&](std::size_t g, unsigned w) {
+        auto& group = streams[w];
+        group.clear();
+        for (std::size_t i = group_begin[g]; i < group_begin[g + 1]; ++i)
+            group.push_back(ranges[order[i]]);
+
+        auto min_streams = static_cast<std::size_t>(
+                std::floor(min_fraction * group.size()));
+        auto& type_well = type_wells[g];
+        detail::aggregate_streams(group, prod[w],
+                std::back_inserter(type_well), min_streams, aggregate);
+
+        if (type_well.size() >= std::tuple_size<params_type>::value)
+            fits[g].push_back(best_from_interval_volume<Decline>(
+                    type_well.begin(), type_well.end(),
+                    time_initial, time_step, options));
+    }, workers);
+
+    std::vector<type_curve<key_type, Decline>> result;
+    for (std::size_t g = 0; g < groups; ++g) {
+        if (fits[g].empty())
+            continue;
+        result.push_back(type_curve<key_type, Decline> {
+            keys[order[group_begin[g]]],
+            group_begin[g + 1] - group_begin[g],
+            std::move(type_wells[g]),
+            fits[g].front()
+        });
+    }
+
+    return result;
+}
+
+}
+
+#endif
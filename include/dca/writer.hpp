@@ -0,0 +1,304 @@
+#ifndef WRITER_HPP
+#define WRITER_HPP
+
+#include "format.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef DCA_NO_IOSTREAMS
+#include <ostream>
+#endif
+
+namespace dca {
+
+/*
+ * tsv: one row per well-month, "id\tmonth\tcolumn...\n", months numbered
+ * from 0, values in shortest round-trip form.
+ *
+ * binary: native-endian, column-major per well. the optional header is
+ * "DCAF", u32 version, u32 columns, then per column a u32 length and its
+ * name; each well is a u32 length and its id, u32 months, u32 columns, then
+ * months doubles for each column in turn.
+ */
+enum class forecast_format { tsv, binary };
+
+const std::uint32_t forecast_binary_version = 1;
+
+// formatted forecast rows for some wells: one per worker thread, say
+class forecast_buffer {
+    public:
+        explicit forecast_buffer(forecast_format format = forecast_format::tsv)
+            : format_(format) { }
+
+        // months values from each column iterator
+        template<class... ColIters>
+        void append(const std::string& id, std::size_t months,
+                ColIters... columns);
+
+        const char* data() const noexcept { return data_.data(); }
+        std::size_t size() const noexcept { return data_.size(); }
+        void clear() noexcept { data_.clear(); } // keeps capacity
+
+    private:
+        friend class forecast_writer;
+
+        char* grow(std::size_t n);
+        void put(const char* p, std::size_t n);
+        void put(char c) { data_.push_back(c); }
+        void put_u32(std::uint32_t value);
+        void put_text(std::size_t value);
+        void put_text(double value);
+
+        forecast_format format_;
+        std::vector<char> data_;
+};
+
+/*
+ * buffers formatted forecasts and hands them to a sink (e.g. fwrite or
+ * ostream::write) in large sequential writes. wells formatted on worker
+ * threads (write_parallel) are emitted in well order, never interleaved.
+ */
+class forecast_writer {
+    public:
+        using sink_type = std::function<void(const char*, std::size_t)>;
+
+        explicit forecast_writer(sink_type sink,
+                forecast_format format = forecast_format::tsv,
+                std::size_t buffer_bytes = std::size_t(1) << 22);
+#ifndef DCA_NO_IOSTREAMS
+        explicit forecast_writer(std::ostream& os,
+                forecast_format format = forecast_format::tsv,
+                std::size_t buffer_bytes = std::size_t(1) << 22);
+#endif
+        ~forecast_writer() noexcept; // flushes, ignoring sink errors
+
+        forecast_writer(const forecast_writer&) = delete;
+        forecast_writer& operator=(const forecast_writer&) = delete;
+
+        // column names (strings), for the value columns to come
+        template<class NameIter>
+        void header(NameIter begin, NameIter end);
+
+        template<class... ColIters>
+        void write(const std::string& id, std::size_t months,
+                ColIters... columns);
+
+        /*
+         * call fn(i, forecast_buffer&) for each well i in [0, wells) on up
+         * to `threads` threads (0: one per hardware thread), grain wells at
+         * a time; fn appends well i's forecast to the buffer. each buffer
+         * is written out in well order once its batch is done, so memory
+         * stays bounded however many wells there are.
+         */
+        template<class Fn>
+        void write_parallel(std::size_t wells, Fn fn, unsigned threads = 0,
+                std::size_t grain = 64);
+
+        void flush();
+
+    private:
+        void emit(const char* p, std::size_t n);
+
+        sink_type sink_;
+        std::size_t capacity_;
+        forecast_buffer buffer_;
+};
+
+template<class... ColIters>
+inline void forecast_buffer::append(const std::string& id,
+        std::size_t months, ColIters... columns)
+{
+    const auto n_columns = sizeof...(ColIters);
+
+    if (format_ == forecast_format::binary) {
+        put_u32(static_cast<std::uint32_t>(id.size()));
+        put(id.data(), id.size());
+        put_u32(static_cast<std::uint32_t>(months));
+        put_u32(static_cast<std::uint32_t>(n_columns));
+
+        auto put_column = [&](auto it) {
+            char* p = grow(months * sizeof(double));
+            for (std::size_t i = 0; i < months; ++i, ++it) {
+                double value = *it;
+                std::memcpy(p + i * sizeof(double), &value, sizeof(double));
+            }
+            return 0;
+        };
+        (void)std::initializer_list<int> { 0, put_column(columns)... };
+        return;
+    }
+
+    for (std::size_t i = 0; i < months; ++i) {
+        put(id.data(), id.size());
+        put('\t');
+        put_text(i);
+        (void)std::initializer_list<int> {
+            0, (put('\t'), put_text(static_cast<double>(*columns++)), 0)...
+        };
+        put('\n');
+    }
+}
+
+inline char* forecast_buffer::grow(std::size_t n)
+{
+    std::size_t old = data_.size();
+    data_.resize(old + n);
+    return data_.data() + old;
+}
+
+inline void forecast_buffer::put(const char* p, std::size_t n)
+{
+    data_.insert(data_.end(), p, p + n);
+}
+
+inline void forecast_buffer::put_u32(std::uint32_t value)
+{
+    std::memcpy(grow(sizeof(value)), &value, sizeof(value));
+}
+
+inline void forecast_buffer::put_text(std::size_t value)
+{
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    put(p, static_cast<std::size_t>(digits + sizeof(digits) - p));
+}
+
+inline void forecast_buffer::put_text(double value)
+{
+    char* p = grow(max_formatted_length);
+    data_.resize(data_.size() - max_formatted_length
+            + format_shortest(value, p));
+}
+
+inline forecast_writer::forecast_writer(sink_type sink,
+        forecast_format format, std::size_t buffer_bytes)
+    : sink_(std::move(sink)),
+      capacity_(std::max<std::size_t>(buffer_bytes, 1)), buffer_(format)
+{
+    buffer_.data_.reserve(capacity_);
+}
+
+#ifndef DCA_NO_IOSTREAMS
+inline forecast_writer::forecast_writer(std::ostream& os,
+        forecast_format format, std::size_t buffer_bytes)
+    : forecast_writer([&os](const char* p, std::size_t n) {
+            os.write(p, static_cast<std::streamsize>(n));
+        }, format, buffer_bytes) { }
+#endif
+
+inline forecast_writer::~forecast_writer() noexcept
+{
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+template<class NameIter>
+inline void forecast_writer::header(NameIter begin, NameIter end)
+{
+    forecast_buffer& b = buffer_;
+    if (b.format_ == forecast_format::binary) {
+        b.put("DCAF", 4);
+        b.put_u32(forecast_binary_version);
+        b.put_u32(static_cast<std::uint32_t>(std::distance(begin, end)));
+        for (; begin != end; ++begin) {
+            const std::string& name = *begin;
+            b.put_u32(static_cast<std::uint32_t>(name.size()));
+            b.put(name.data(), name.size());
+        }
+    } else {
+        b.put("Well\tMonth", 10);
+        for (; begin != end; ++begin) {
+            const std::string& name = *begin;
+            b.put('\t');
+            b.put(name.data(), name.size());
+        }
+        b.put('\n');
+    }
+
+    if (b.size() >= capacity_)
+        flush();
+}
+
+template<class... ColIters>
+inline void forecast_writer::write(const std::string& id, std::size_t months,
+        ColIters... columns)
+{
+    buffer_.append(id, months, columns...);
+    if (buffer_.size() >= capacity_)
+        flush();
+}
+
+template<class Fn>
+inline void forecast_writer::write_parallel(std::size_t wells, Fn fn,
+        unsigned threads, std::size_t grain)
+{
+    if (threads == 0)
+        threads = default_threads();
+    if (grain == 0)
+        grain = 1;
+
+    // a few chunks per thread per batch, to even out uneven wells
+    const std::size_t batch_chunks = std::size_t(4) * threads;
+    std::vector<forecast_buffer> chunks(batch_chunks,
+            forecast_buffer(buffer_.format_));
+
+    for (std::size_t first = 0; first < wells;
+            first += batch_chunks * grain) {
+        std::size_t n = std::min(batch_chunks,
+                (wells - first + grain - 1) / grain);
+
+        parallel_for(n, [&](std::size_t c) {
+            auto& chunk = chunks[c];
+            chunk.clear();
+            std::size_t begin = first + c * grain;
+            std::size_t end = std::min(begin + grain, wells);
+            for (std::size_t i = begin; i < end; ++i)
+                fn(i, chunk);
+        }, threads);
+
+        for (std::size_t c = 0; c < n; ++c)
+            emit(chunks[c].data(), chunks[c].size());
+    }
+}
+
+inline void forecast_writer::flush()
+{
+    if (buffer_.size() == 0)
+        return;
+    DCA_PROFILE_SCOPE(write);
+    sink_(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+inline void forecast_writer::emit(const char* p, std::size_t n)
+{
+    if (buffer_.size() + n > capacity_)
+        flush();
+    if (n >= capacity_) { // no point copying
+        DCA_PROFILE_SCOPE(write);
+        sink_(p, n);
+    } else {
+        buffer_.put(p, n);
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,11 @@
+// explicit instantiations for libdca.a (see the end of bestfit.hpp)
+
+#include "dca/duong.hpp"
+#include "dca/bestfit.hpp"
+
+namespace dca {
+
+template class basic_duong<double>;
+DCA_INSTANTIATE_MODEL(, basic_duong, 3)
+
+}
@@ -0,0 +1,11 @@
+// explicit instantiations for libdca.a (see the end of bestfit.hpp)
+
+#include "dca/hyperbolic.hpp"
+#include "dca/bestfit.hpp"
+
+namespace dca {
+
+template class basic_arps_hyperbolic<double>;
+DCA_INSTANTIATE_MODEL(, basic_arps_hyperbolic, 3)
+
+}
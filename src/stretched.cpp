@@ -0,0 +1,11 @@
+// explicit instantiations for libdca.a (see the end of bestfit.hpp)
+
+#include "dca/stretched.hpp"
+#include "dca/bestfit.hpp"
+
+namespace dca {
+
+template class basic_stretched_exponential<double>;
+DCA_INSTANTIATE_MODEL(, basic_stretched_exponential, 3)
+
+}
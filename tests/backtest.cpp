@@ -0,0 +1,132 @@
+#include "dca/backtest.hpp"
+
+#define BOOST_TEST_MODULE backtest
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using range = std::pair<std::vector<double>::const_iterator,
+      std::vector<double>::const_iterator>;
+
+// monthly volumes of some hyperbolic wells, scaled by noise (or 1)
+std::vector<std::vector<double>> make_wells(std::size_t months,
+        double noise)
+{
+    std::vector<std::vector<double>> wells;
+    for (int w = 0; w < 6; ++w) {
+        dca::arps_hyperbolic decl(800.0 + 100.0 * w, 0.8 + 0.1 * w,
+                0.4 + 0.2 * w);
+        std::vector<double> vol;
+        for (std::size_t i = 0; i < months; ++i)
+            vol.push_back((decl.cumulative((i + 1) / 12.0)
+                        - decl.cumulative(i / 12.0))
+                    * (1.0 + noise * std::sin(1.7 * i + w)));
+        wells.push_back(vol);
+    }
+    return wells;
+}
+
+std::vector<range> ranges_of(const std::vector<std::vector<double>>& wells)
+{
+    std::vector<range> result;
+    for (const auto& w : wells)
+        result.emplace_back(w.begin(), w.end());
+    return result;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( hindcast )
+
+BOOST_AUTO_TEST_CASE( exact_data )
+{
+    auto wells = make_wells(24, 0.0);
+    for (auto start : { dca::backtest_start::cold,
+            dca::backtest_start::warm }) {
+        dca::backtest_options options;
+        options.start = start;
+        options.min_history = 6;
+        auto result = dca::backtest_interval_volume<dca::arps_hyperbolic>(
+                ranges_of(wells), 0.0, 1.0 / 12.0, options);
+
+        BOOST_REQUIRE_EQUAL(result.size(), wells.size());
+        for (const auto& steps : result) {
+            BOOST_REQUIRE_EQUAL(steps.size(), 24u - 6u);
+            BOOST_CHECK_EQUAL(steps.front().history, 6u);
+            BOOST_CHECK_EQUAL(steps.back().history, 23u);
+            BOOST_CHECK_EQUAL(steps.front().eur_drift, 0.0);
+            for (const auto& s : steps) {
+                BOOST_CHECK_SMALL(s.holdout_mape, 1.0);
+                BOOST_CHECK_SMALL(s.holdout_error, 1e-2);
+                BOOST_CHECK_SMALL(s.eur_drift, 1e-2);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( warm_tracks_cold )
+{
+    auto wells = make_wells(36, 0.05);
+    dca::backtest_options options;
+    options.start = dca::backtest_start::cold;
+    auto cold = dca::summarize_backtest(
+            dca::backtest_interval_volume<dca::arps_hyperbolic>(
+                ranges_of(wells), 0.0, 1.0 / 12.0, options));
+    options.start = dca::backtest_start::warm;
+    auto warm = dca::summarize_backtest(
+            dca::backtest_interval_volume<dca::arps_hyperbolic>(
+                ranges_of(wells), 0.0, 1.0 / 12.0, options));
+
+    BOOST_CHECK_EQUAL(cold.wells, wells.size());
+    BOOST_CHECK_EQUAL(cold.refits, wells.size() * (36 - 3));
+    BOOST_CHECK_EQUAL(warm.refits, cold.refits);
+    BOOST_CHECK(warm.holdout_mape < 2.0 * cold.holdout_mape + 1.0);
+    BOOST_CHECK(warm.holdout_abs_error < 2.0 * cold.holdout_abs_error + 0.02);
+}
+
+BOOST_AUTO_TEST_CASE( threads_and_short_wells )
+{
+    auto wells = make_wells(18, 0.05);
+    wells[2].resize(3); // no holdout after min_history
+    dca::backtest_options options;
+    options.threads = 1;
+    auto serial = dca::backtest_interval_volume<dca::arps_exponential>(
+            ranges_of(wells), 0.0, 1.0 / 12.0, options);
+    options.threads = 4;
+    auto parallel = dca::backtest_interval_volume<dca::arps_exponential>(
+            ranges_of(wells), 0.0, 1.0 / 12.0, options);
+
+    BOOST_CHECK(serial[2].empty());
+    BOOST_REQUIRE_EQUAL(serial.size(), parallel.size());
+    for (std::size_t w = 0; w < serial.size(); ++w) {
+        BOOST_REQUIRE_EQUAL(serial[w].size(), parallel[w].size());
+        for (std::size_t i = 0; i < serial[w].size(); ++i)
+            BOOST_CHECK_EQUAL(serial[w][i].eur, parallel[w][i].eur);
+    }
+    BOOST_CHECK_EQUAL(dca::summarize_backtest(serial).wells,
+            wells.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE( summary )
+{
+    std::vector<std::vector<dca::backtest_step>> wells(3);
+    wells[0].push_back({ 3, dca::fit_status::complete, 10.0, 0.2, 1.0, 0.0 });
+    wells[0].push_back({ 4, dca::fit_status::complete, 6.0, -0.1, 1.1, 0.1 });
+    wells[2].push_back({ 3, dca::fit_status::complete, 2.0, -0.4, 2.0, 0.0 });
+
+    auto s = dca::summarize_backtest(wells);
+    BOOST_CHECK_EQUAL(s.wells, 2u);
+    BOOST_CHECK_EQUAL(s.refits, 3u);
+    BOOST_CHECK_CLOSE(s.holdout_mape, 6.0, 1e-9);
+    BOOST_CHECK_CLOSE(s.holdout_bias, -0.1, 1e-9);
+    BOOST_CHECK_CLOSE(s.holdout_abs_error, 0.7 / 3.0, 1e-9);
+    BOOST_CHECK_CLOSE(s.eur_drift, 0.1, 1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
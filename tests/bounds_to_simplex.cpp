@@ -65,3 +65,27 @@ BOOST_AUTO_TEST_CASE( dim_4 )
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( seeded_simplex )
+
+BOOST_AUTO_TEST_CASE( steps_toward_farther_limit )
+{
+    auto ss = convex::seeded_simplex(std::make_tuple(2.0, 8.0, 0.0),
+            std::make_pair(std::make_tuple(0.0, 0.0, 0.0),
+                std::make_tuple(10.0, 10.0, 4.0)));
+    BOOST_CHECK(ss[0] == std::make_tuple(2.0, 8.0, 0.0));
+    BOOST_CHECK(ss[1] == std::make_tuple(4.5, 8.0, 0.0));
+    BOOST_CHECK(ss[2] == std::make_tuple(2.0, 5.5, 0.0));
+    BOOST_CHECK(ss[3] == std::make_tuple(2.0, 8.0, 1.0));
+}
+
+BOOST_AUTO_TEST_CASE( degenerate_range )
+{
+    auto ss = convex::seeded_simplex(std::make_tuple(4.0, 1.0),
+            std::make_pair(std::make_tuple(4.0, 0.0),
+                std::make_tuple(4.0, 2.0)), 0.5);
+    BOOST_CHECK(ss[1] == std::make_tuple(6.0, 1.0));
+    BOOST_CHECK(ss[2] == std::make_tuple(4.0, 2.0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
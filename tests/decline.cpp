@@ -2,6 +2,9 @@
 #include "dca/exponential.hpp"
 #include "dca/hyperbolic.hpp"
 #include "dca/hyptoexp.hpp"
+#include "dca/stretched.hpp"
+#include "dca/duong.hpp"
+#include "dca/any_decline.hpp"
 
 #define BOOST_TEST_MODULE decline
 #include <boost/test/unit_test.hpp>
@@ -9,9 +12,21 @@
 
 #include <random>
 #include <cmath>
+#include <limits>
 
 const double tolerance_pct = 2e-2;
 
+// Simpson's rule, for checking cumulatives against rates
+template<class Decline>
+double integrate_rate(const Decline& decl, double t0, double t1,
+        int steps = 20000)
+{
+    double h = (t1 - t0) / steps, sum = decl.rate(t0) + decl.rate(t1);
+    for (int i = 1; i < steps; ++i)
+        sum += (i % 2 ? 4.0 : 2.0) * decl.rate(t0 + i * h);
+    return sum * h / 3.0;
+}
+
 BOOST_AUTO_TEST_SUITE( conversions )
 
 BOOST_AUTO_TEST_CASE( hyperbolic )
@@ -233,3 +248,173 @@ BOOST_AUTO_TEST_CASE( random_eur )
                 tolerance_pct);
     }
 }
+
+BOOST_AUTO_TEST_SUITE( models )
+
+// qi (1 - exp(-D t)) / D for any D t, including tiny D and huge t
+BOOST_AUTO_TEST_CASE( exponential_cumulative )
+{
+    const double qi = 1000.0;
+    for (double D : { 0.0, 1e-12, 9e-6, 1e-3, 0.5 }) {
+        dca::arps_exponential decl(qi, D);
+        for (double t : { 1e-3, 1.0, 30.0, 3e5, 1e9 }) {
+            double np = D == 0.0 ? qi * t : qi / D * -std::expm1(-D * t);
+            BOOST_CHECK_CLOSE(decl.cumulative(t), np, 1e-9);
+        }
+    }
+}
+
+// the unified hyperbolic form against the textbook special cases
+BOOST_AUTO_TEST_CASE( hyperbolic_kernel )
+{
+    const double qi = 1000.0;
+    for (double Di : { 0.05, 0.7, 3.0 }) {
+        for (double b : { 0.0, 0.3, 0.5, 1.0, 1.7, 2.0, 5.0 }) {
+            dca::arps_hyperbolic decl(qi, Di, b);
+            for (double t : { 1e-3, 0.5, 1.0, 10.0, 50.0 }) {
+                double x = Di * t, q, np;
+                if (b == 0.0) {
+                    q = qi * std::exp(-x);
+                    np = qi / Di * -std::expm1(-x);
+                } else if (b == 1.0) {
+                    q = qi / (1.0 + x);
+                    np = qi / Di * std::log1p(x);
+                } else {
+                    q = qi * std::pow(1.0 + b * x, -1.0 / b);
+                    np = qi / ((1.0 - b) * Di)
+                        * (1.0 - std::pow(1.0 + b * x, 1.0 - 1.0 / b));
+                }
+                BOOST_CHECK_CLOSE(decl.rate(t), q, 1e-9);
+                BOOST_CHECK_CLOSE(decl.cumulative(t), np, 1e-9);
+            }
+            BOOST_CHECK_EQUAL(decl.rate(-1.0), 0.0);
+            BOOST_CHECK_EQUAL(decl.cumulative(-1.0), 0.0);
+            BOOST_CHECK_EQUAL(decl.cumulative(0.0), 0.0);
+        }
+    }
+
+    // continuous through b = 0 and b = 1, where the textbook form cancels
+    for (double b : { 0.0, 1.0 }) {
+        dca::arps_hyperbolic at(qi, 0.7, b);
+        for (double db : { -1e-9, 1e-9 }) {
+            if (b + db < 0.0)
+                continue;
+            dca::arps_hyperbolic near(qi, 0.7, b + db);
+            for (double t : { 1e-3, 1.0, 50.0 }) {
+                BOOST_CHECK_CLOSE(near.rate(t), at.rate(t), 1e-3);
+                BOOST_CHECK_CLOSE(near.cumulative(t), at.cumulative(t), 1e-3);
+            }
+        }
+    }
+
+    // no decline to speak of: Np = qi t (1 - Di t / 2 + ...)
+    for (double b : { 0.0, 1.0, 2.5 }) {
+        dca::arps_hyperbolic flat(qi, 1e-9, b);
+        BOOST_CHECK_CLOSE(flat.cumulative(10.0), qi * 10.0 * (1.0 - 5e-9),
+                1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( stretched_exponential )
+{
+    std::mt19937 rng;
+    std::uniform_real_distribution<> tau_dist(0.05, 10.0);
+    std::uniform_real_distribution<> n_dist(0.05, 1.0);
+    for (int i = 0; i < 200; ++i) {
+        dca::stretched_exponential decl(1000.0, tau_dist(rng), n_dist(rng));
+        for (double t : { 0.1, 1.0, 5.0, 30.0 })
+            BOOST_CHECK_CLOSE(decl.cumulative(t),
+                    decl.cumulative(t / 2.0)
+                    + integrate_rate(decl, t / 2.0, t), 1e-6);
+    }
+
+    // n = 1 is exponential, D = 1 / tau
+    dca::stretched_exponential stretched(1000.0, 2.0, 1.0);
+    dca::arps_exponential exponential(1000.0, 0.5);
+    for (double t : { 0.0, 0.5, 3.0, 40.0 }) {
+        BOOST_CHECK_CLOSE(stretched.rate(t), exponential.rate(t), 1e-10);
+        BOOST_CHECK_CLOSE(stretched.cumulative(t) + 1.0,
+                exponential.cumulative(t) + 1.0, 1e-10);
+    }
+
+    BOOST_CHECK_CLOSE(stretched.D(1.0), 0.5, 1e-10);
+    BOOST_CHECK_EQUAL(stretched.rate(-1.0), 0.0);
+    BOOST_CHECK_EQUAL(stretched.cumulative(-1.0), 0.0);
+    BOOST_CHECK_THROW(dca::stretched_exponential(1.0, 1.0, 1.5),
+            std::out_of_range);
+    BOOST_CHECK_THROW(dca::stretched_exponential(1.0, 0.0, 0.5),
+            std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE( duong )
+{
+    std::mt19937 rng;
+    std::uniform_real_distribution<> a_dist(0.2, 3.0);
+    std::uniform_real_distribution<> m_dist(0.5, 1.8);
+    for (int i = 0; i < 200; ++i) {
+        dca::duong decl(1000.0, a_dist(rng), m_dist(rng));
+        for (double t : { 0.5, 1.0, 5.0, 30.0 })
+            BOOST_CHECK_CLOSE(decl.cumulative(t) - decl.cumulative(0.1),
+                    integrate_rate(decl, 0.1, t), 1e-6);
+        // q / Np = a t^-m, when Np starts from zero at t = 0
+        if (decl.m() >= 1.0)
+            BOOST_CHECK_CLOSE(decl.rate(2.0) / decl.cumulative(2.0),
+                    decl.a() * std::pow(2.0, -decl.m()), 1e-8);
+    }
+
+    // m = 1 is a power law, q = q1 t^(a - 1)
+    dca::duong power(1000.0, 0.6, 1.0);
+    BOOST_CHECK_CLOSE(power.rate(4.0), 1000.0 * std::pow(4.0, -0.4), 1e-8);
+    BOOST_CHECK_CLOSE(power.cumulative(4.0),
+            1000.0 / 0.6 * std::pow(4.0, 0.6), 1e-8);
+
+    BOOST_CHECK_EQUAL(power.rate(0.0), 0.0);
+    BOOST_CHECK_EQUAL(power.cumulative(0.0), 0.0);
+    BOOST_CHECK_THROW(dca::duong(1.0, 0.0, 1.2), std::out_of_range);
+    BOOST_CHECK_THROW(dca::duong(1.0, 1.0, 3.5), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE( eur_and_any )
+{
+    // the first time past the peak that the rate falls below limit, by a
+    // scan of the rate; max_time if it doesn't
+    auto scan = [](const auto& decl, double limit, double max_time) {
+        const int steps = 300000;
+        double h = max_time / steps, peak = 0.0;
+        for (int i = 1; i <= steps; ++i) {
+            double q = decl.rate(i * h);
+            if (q > peak)
+                peak = q;
+            else if (q < limit)
+                return (i - 0.5) * h;
+        }
+        return max_time;
+    };
+
+    auto check = [&](const auto& decl, double limit) {
+        double time, ultimate = dca::eur(decl, limit, 30.0, &time);
+        double expected = scan(decl, limit, 30.0);
+        BOOST_CHECK_CLOSE(time, expected, tolerance_pct);
+        BOOST_CHECK_CLOSE(ultimate, decl.cumulative(expected), tolerance_pct);
+
+        dca::any erased(decl);
+        BOOST_CHECK_EQUAL(erased.rate(2.0), decl.rate(2.0));
+        BOOST_CHECK_EQUAL(erased.cumulative(2.0), decl.cumulative(2.0));
+    };
+
+    check(dca::stretched_exponential(365.25 * 500.0, 0.8, 0.4), 365.25);
+    // climbing to a peak at 0.77 years, and above 1 bbl/d at 30
+    check(dca::duong(365.25 * 500.0, 1.2, 1.3), 365.25);
+    check(dca::duong(365.25 * 500.0, 1.2, 1.3), 365.25 * 100.0);
+    check(dca::duong(365.25 * 500.0, 0.5, 0.9), 365.25 * 200.0);
+
+    // never above the limit, and falling to a trough at 0.06 years
+    dca::duong low(365.25, 1.2, 1.3), trough(365.25 * 500.0, 2.0, 0.5);
+    BOOST_CHECK_EQUAL(dca::time_to_rate(low, 365.25 * 10.0), 0.0);
+    double time = dca::time_to_rate(trough, trough.rate(0.01));
+    BOOST_CHECK_CLOSE(time, 0.01, 1e-6);
+    BOOST_CHECK_EQUAL(dca::time_to_rate(trough, trough.rate(0.0625) * 0.5),
+            std::numeric_limits<double>::max());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,178 @@
+#include "dca/diagnostics.hpp"
+
+#define BOOST_TEST_MODULE diagnostics
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct rate_data {
+    std::vector<double> rate, time;
+};
+
+// a hyperbolic decline with alternating noise of +/- 3%
+rate_data noisy_rates(const dca::arps_hyperbolic& decl, std::size_t n)
+{
+    rate_data d;
+    for (std::size_t i = 0; i < n; ++i) {
+        double t = (i + 0.5) / 12.0;
+        d.time.push_back(t);
+        d.rate.push_back(decl.rate(t) * (i % 2 ? 0.97 : 1.03));
+    }
+    return d;
+}
+
+std::vector<double> noisy_volumes(const dca::arps_hyperbolic& decl,
+        std::size_t n)
+{
+    std::vector<double> vol;
+    for (std::size_t i = 0; i < n; ++i)
+        vol.push_back((decl.cumulative((i + 1) / 12.0)
+                    - decl.cumulative(i / 12.0)) * (i % 3 ? 0.98 : 1.04));
+    return vol;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( fit_result )
+
+BOOST_AUTO_TEST_CASE( rate_metrics )
+{
+    auto data = noisy_rates(dca::arps_hyperbolic(1200.0, 1.1, 1.2), 48);
+
+    for (auto solver : { dca::fit_solver::nelder_mead, dca::fit_solver::bfgs,
+            dca::fit_solver::differential_evolution }) {
+        dca::fit_options options;
+        options.solver = solver;
+        auto result = dca::fit_from_rate<dca::arps_hyperbolic>(
+                data.rate.begin(), data.rate.end(), data.time.begin(),
+                options, true);
+
+        // the same fit as best_from_rate, give or take a tied vertex
+        auto fit = dca::best_from_rate<dca::arps_hyperbolic>(
+                data.rate.begin(), data.rate.end(), data.time.begin(),
+                options);
+        const auto& decl = result.decline;
+        BOOST_CHECK_CLOSE(decl.qi(), fit.qi(), 1e-3);
+        BOOST_CHECK_CLOSE(decl.Di(), fit.Di(), 1e-3);
+        BOOST_CHECK_CLOSE(decl.b(), fit.b(), 1e-3);
+        BOOST_CHECK_EQUAL(std::get<2>(result.params), decl.b());
+        BOOST_CHECK(result.status == dca::fit_status::complete);
+        BOOST_CHECK(result.sse <= dca::detail::sse_against_rate(fit,
+                    data.rate.begin(), data.rate.end(), data.time.begin()));
+
+        // diagnostics as from a separate pass over the data
+        BOOST_REQUIRE_EQUAL(result.count, data.rate.size());
+        BOOST_REQUIRE_EQUAL(result.residuals.size(), data.rate.size());
+        double sse = 0.0, ape = 0.0, mean = 0.0, ss = 0.0;
+        for (std::size_t i = 0; i < data.rate.size(); ++i) {
+            double resid = data.rate[i] - decl.rate(data.time[i]);
+            BOOST_CHECK_CLOSE(result.residuals[i], resid, 1e-6);
+            sse += resid * resid;
+            ape += std::abs(resid / data.rate[i]);
+            mean += data.rate[i] / data.rate.size();
+        }
+        for (double q : data.rate)
+            ss += (q - mean) * (q - mean);
+
+        BOOST_CHECK_CLOSE(result.sse, sse, 1e-6);
+        BOOST_CHECK_CLOSE(result.rmse, std::sqrt(sse / data.rate.size()),
+                1e-6);
+        BOOST_CHECK_CLOSE(result.r_squared, 1.0 - sse / ss, 1e-6);
+        BOOST_CHECK_CLOSE(result.mape, 100.0 * ape / data.rate.size(), 1e-6);
+        BOOST_CHECK(result.r_squared > 0.95);
+        BOOST_CHECK(result.mape > 1.0 && result.mape < 5.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( interval_metrics )
+{
+    auto vol = noisy_volumes(dca::arps_hyperbolic(900.0, 0.9, 0.7), 60);
+    auto result = dca::fit_from_interval_volume<dca::arps_hyperbolic>(
+            vol.begin(), vol.end(), 0.0, 1.0 / 12.0);
+    BOOST_CHECK(result.residuals.empty()); // not asked for
+    BOOST_REQUIRE_EQUAL(result.count, vol.size());
+
+    double sse = 0.0;
+    for (std::size_t i = 0; i < vol.size(); ++i) {
+        double resid = vol[i] - (result.decline.cumulative((i + 1) / 12.0)
+                - result.decline.cumulative(i / 12.0));
+        sse += resid * resid;
+    }
+    BOOST_CHECK_CLOSE(result.sse, sse, 1e-6);
+    BOOST_CHECK(result.r_squared > 0.95);
+}
+
+BOOST_AUTO_TEST_CASE( warm_start )
+{
+    auto vol = noisy_volumes(dca::arps_hyperbolic(900.0, 0.9, 0.7), 60);
+    auto cold = dca::fit_from_interval_volume<dca::arps_hyperbolic>(
+            vol.begin(), vol.begin() + 36, 0.0, 1.0 / 12.0);
+    auto warm = dca::fit_from_interval_volume_bfgs<dca::arps_hyperbolic>(
+            vol.begin(), vol.end(), 0.0, 1.0 / 12.0, cold.params,
+            dca::fit_options {}, true);
+
+    BOOST_REQUIRE_EQUAL(warm.residuals.size(), vol.size());
+    BOOST_CHECK(warm.sse <= dca::detail::sse_against_interval(cold.decline,
+                vol.begin(), vol.end(), 0.0, 1.0 / 12.0));
+    BOOST_CHECK_CLOSE(warm.sse, dca::detail::sse_against_interval(
+                warm.decline, vol.begin(), vol.end(), 0.0, 1.0 / 12.0), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE( same_as_best_from )
+{
+    auto data = noisy_rates(dca::arps_hyperbolic(1200.0, 1.1, 1.2), 48);
+    auto vol = noisy_volumes(dca::arps_hyperbolic(900.0, 0.9, 0.7), 60);
+    dca::fit_options options;
+
+    auto check = [](const dca::arps_hyperbolic& fit,
+            const dca::arps_hyperbolic& best) {
+        BOOST_CHECK_EQUAL(fit.qi(), best.qi());
+        BOOST_CHECK_EQUAL(fit.Di(), best.Di());
+        BOOST_CHECK_EQUAL(fit.b(), best.b());
+    };
+    for (auto solver : { dca::fit_solver::nelder_mead,
+            dca::fit_solver::bfgs, dca::fit_solver::differential_evolution }) {
+        options.solver = solver;
+        check(dca::fit_from_rate<dca::arps_hyperbolic>(data.rate.begin(),
+                    data.rate.end(), data.time.begin(), options).decline,
+                dca::best_from_rate<dca::arps_hyperbolic>(data.rate.begin(),
+                    data.rate.end(), data.time.begin(), options));
+        check(dca::fit_from_interval_volume<dca::arps_hyperbolic>(
+                    vol.begin(), vol.end(), 0.0, 1.0 / 12.0,
+                    options).decline,
+                dca::best_from_interval_volume<dca::arps_hyperbolic>(
+                    vol.begin(), vol.end(), 0.0, 1.0 / 12.0, options));
+    }
+
+    auto initial = std::make_tuple(800.0, 0.5, 0.5);
+    check(dca::fit_from_rate_bfgs<dca::arps_hyperbolic>(data.rate.begin(),
+                data.rate.end(), data.time.begin(), initial).decline,
+            dca::best_from_rate_bfgs<dca::arps_hyperbolic>(data.rate.begin(),
+                data.rate.end(), data.time.begin(), initial));
+    check(dca::fit_from_interval_volume_bfgs<dca::arps_hyperbolic>(
+                vol.begin(), vol.end(), 0.0, 1.0 / 12.0, initial).decline,
+            dca::best_from_interval_volume_bfgs<dca::arps_hyperbolic>(
+                vol.begin(), vol.end(), 0.0, 1.0 / 12.0, initial));
+}
+
+BOOST_AUTO_TEST_CASE( out_of_budget )
+{
+    auto data = noisy_rates(dca::arps_hyperbolic(1200.0, 1.1, 1.2), 48);
+    dca::fit_options options;
+    options.max_evaluations = 5;
+    auto result = dca::fit_from_rate<dca::arps_hyperbolic>(
+            data.rate.begin(), data.rate.end(), data.time.begin(),
+            options);
+    BOOST_CHECK(result.status == dca::fit_status::evaluation_limit);
+    BOOST_CHECK_CLOSE(result.sse, dca::detail::sse_against_rate(
+                result.decline, data.rate.begin(), data.rate.end(),
+                data.time.begin()), 1e-6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,221 @@
+#include "dca/dual.hpp"
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+#include "dca/stretched.hpp"
+#include "dca/duong.hpp"
+#include "dca/bestfit.hpp"
+
+#define BOOST_TEST_MODULE dual
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <vector>
+
+const double tolerance_pct = 1e-1;
+
+// central differences of f against each element of a parameter tuple
+template<class F>
+std::array<double, 3> numeric_gradient(F f,
+        std::tuple<double, double, double> p)
+{
+    std::array<double, 3> grad;
+    auto x = convex::detail::tuple_to_array(p);
+    for (std::size_t i = 0; i < 3; ++i) {
+        double h = 1e-6 * std::max(1.0, std::abs(x[i]));
+        auto up = x, down = x;
+        up[i] += h;
+        down[i] -= h;
+        grad[i] = (f(convex::detail::array_to_tuple<decltype(p)>(up))
+                - f(convex::detail::array_to_tuple<decltype(p)>(down)))
+            / (2.0 * h);
+    }
+    return grad;
+}
+
+BOOST_AUTO_TEST_SUITE( arithmetic )
+
+BOOST_AUTO_TEST_CASE( elementary )
+{
+    using dca::dual;
+
+    dual<2> x(3.0, 0), y(0.5, 1);
+
+    auto f = x * x / y + 2.0 * exp(y) - log(x) + pow(x, y);
+    double dfdx = 2.0 * 3.0 / 0.5 - 1.0 / 3.0
+        + 0.5 * std::pow(3.0, -0.5);
+    double dfdy = -9.0 / 0.25 + 2.0 * std::exp(0.5)
+        + std::pow(3.0, 0.5) * std::log(3.0);
+
+    BOOST_CHECK_CLOSE(f.value(),
+            9.0 / 0.5 + 2.0 * std::exp(0.5) - std::log(3.0)
+            + std::pow(3.0, 0.5),
+            tolerance_pct);
+    BOOST_CHECK_CLOSE(f.gradient(0), dfdx, tolerance_pct);
+    BOOST_CHECK_CLOSE(f.gradient(1), dfdy, tolerance_pct);
+
+    auto g = expm1(y) * log1p(x) - sqrt(x) - abs(-y);
+    BOOST_CHECK_CLOSE(g.gradient(0),
+            std::expm1(0.5) / 4.0 - 0.5 / std::sqrt(3.0), tolerance_pct);
+    BOOST_CHECK_CLOSE(g.gradient(1),
+            std::exp(0.5) * std::log1p(3.0) - 1.0, tolerance_pct);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( objective_gradient )
+
+BOOST_AUTO_TEST_CASE( hyperbolic )
+{
+    dca::arps_hyperbolic truth(1000.0, 1.2, 1.4);
+    std::vector<double> rate, time, vol;
+    for (int i = 0; i < 36; ++i) {
+        time.push_back(i / 12.0);
+        rate.push_back(truth.rate(i / 12.0) * (1.0 + 0.05 * std::sin(i)));
+        vol.push_back(truth.cumulative((i + 1) / 12.0)
+                - truth.cumulative(i / 12.0));
+    }
+
+    auto params = std::make_tuple(800.0, 0.9, 1.1);
+
+    std::array<double, 3> grad;
+    double sse = dca::detail::sse_gradient_against_rate<dca::arps_hyperbolic>(
+            params, rate.begin(), rate.end(), time.begin(), grad);
+    auto expected = numeric_gradient([&](const auto& p) {
+        return dca::detail::sse_against_rate(
+                tuple::construct<dca::arps_hyperbolic>(p),
+                rate.begin(), rate.end(), time.begin());
+    }, params);
+
+    BOOST_CHECK_CLOSE(sse, (dca::detail::sse_against_rate(
+                tuple::construct<dca::arps_hyperbolic>(params),
+                rate.begin(), rate.end(), time.begin())), tolerance_pct);
+    for (std::size_t i = 0; i < 3; ++i)
+        BOOST_CHECK_CLOSE(grad[i], expected[i], tolerance_pct);
+
+    dca::detail::sse_gradient_against_interval<dca::arps_hyperbolic>(
+            params, vol.begin(), vol.end(), 0.0, 1.0 / 12.0, grad);
+    expected = numeric_gradient([&](const auto& p) {
+        return dca::detail::sse_against_interval(
+                tuple::construct<dca::arps_hyperbolic>(p),
+                vol.begin(), vol.end(), 0.0, 1.0 / 12.0);
+    }, params);
+    for (std::size_t i = 0; i < 3; ++i)
+        BOOST_CHECK_CLOSE(grad[i], expected[i], tolerance_pct);
+
+    // through the series at b = 1
+    params = std::make_tuple(800.0, 0.9, 1.0);
+    dca::detail::sse_gradient_against_interval<dca::arps_hyperbolic>(
+            params, vol.begin(), vol.end(), 0.0, 1.0 / 12.0, grad);
+    expected = numeric_gradient([&](const auto& p) {
+        return dca::detail::sse_against_interval(
+                tuple::construct<dca::arps_hyperbolic>(p),
+                vol.begin(), vol.end(), 0.0, 1.0 / 12.0);
+    }, params);
+    for (std::size_t i = 0; i < 3; ++i)
+        BOOST_CHECK_CLOSE(grad[i], expected[i], tolerance_pct);
+}
+
+// the incomplete gamma and the m = 1 special case carry derivatives too
+BOOST_AUTO_TEST_CASE( stretched_and_duong )
+{
+    std::vector<double> vol(36);
+    for (int i = 0; i < 36; ++i)
+        vol[i] = 100.0 * std::exp(-0.05 * i) * (1.0 + 0.05 * std::sin(i));
+
+    auto check = [&](auto model, std::tuple<double, double, double> params) {
+        using decline_type = decltype(model);
+        std::array<double, 3> grad;
+        dca::detail::sse_gradient_against_interval<decline_type>(
+                params, vol.begin(), vol.end(), 0.0, 1.0 / 12.0, grad);
+        auto expected = numeric_gradient([&](const auto& p) {
+            return dca::detail::sse_against_interval(
+                    tuple::construct<decline_type>(p),
+                    vol.begin(), vol.end(), 0.0, 1.0 / 12.0);
+        }, params);
+        for (std::size_t i = 0; i < 3; ++i)
+            BOOST_CHECK_CLOSE(grad[i], expected[i], tolerance_pct);
+    };
+
+    check(dca::stretched_exponential(1.0, 1.0, 1.0),
+            std::make_tuple(2000.0, 0.8, 0.4));
+    check(dca::stretched_exponential(1.0, 1.0, 1.0),
+            std::make_tuple(1500.0, 3.0, 0.9));
+    check(dca::duong(1.0, 1.0, 1.0), std::make_tuple(900.0, 1.5, 1.2));
+    check(dca::duong(1.0, 1.0, 1.0), std::make_tuple(900.0, 1.5, 0.8));
+    check(dca::duong(1.0, 1.0, 1.0), std::make_tuple(900.0, 1.5, 1.0));
+}
+
+BOOST_AUTO_TEST_CASE( eur )
+{
+    auto params = std::make_tuple(1000.0 * 365.25, 1.5, 1.2);
+    double ultimate;
+    auto grad = dca::eur_gradient<dca::arps_hyperbolic>(params, 365.25, 50.0,
+            &ultimate);
+    auto expected = numeric_gradient([](const auto& p) {
+        return dca::eur(tuple::construct<dca::arps_hyperbolic>(p),
+                365.25, 50.0);
+    }, params);
+
+    BOOST_CHECK_CLOSE(ultimate,
+            (dca::eur(tuple::construct<dca::arps_hyperbolic>(params),
+                      365.25, 50.0)),
+            tolerance_pct);
+    for (std::size_t i = 0; i < 3; ++i)
+        BOOST_CHECK_CLOSE(grad[i], expected[i], 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( bfgs )
+
+BOOST_AUTO_TEST_CASE( rosenbrock )
+{
+    auto res = convex::bfgs([](const std::tuple<double, double>& t,
+                std::array<double, 2>& grad) {
+            double x = std::get<0>(t), y = std::get<1>(t);
+            grad[0] = -2.0 * (1.0 - x) - 400.0 * x * (y - x * x);
+            grad[1] = 200.0 * (y - x * x);
+            return (1.0 - x) * (1.0 - x) + 100.0 * (y - x * x) * (y - x * x);
+        }, std::make_tuple(-1.2, 1.0), 500, 1e-12);
+
+    BOOST_CHECK_CLOSE(std::get<0>(res), 1.0, tolerance_pct);
+    BOOST_CHECK_CLOSE(std::get<1>(res), 1.0, tolerance_pct);
+}
+
+BOOST_AUTO_TEST_CASE( exponential_fit )
+{
+    dca::arps_exponential decl(93653.76, 0.2886);
+    std::vector<double> rate, time;
+    for (int j = 0; j < 60; ++j) {
+        time.push_back(j / 12.0);
+        rate.push_back(decl.rate(j / 12.0));
+    }
+
+    auto fit = dca::best_from_rate_bfgs<dca::arps_exponential>(
+            rate.begin(), rate.end(), time.begin());
+    BOOST_CHECK_CLOSE(decl.qi(), fit.qi(), tolerance_pct);
+    BOOST_CHECK_CLOSE(decl.D(), fit.D(), tolerance_pct);
+}
+
+BOOST_AUTO_TEST_CASE( hyperbolic_refit )
+{
+    dca::arps_hyperbolic decl(15000.0, 1.8, 1.2);
+    std::vector<double> vol;
+    for (int j = 0; j < 60; ++j)
+        vol.push_back(decl.cumulative((j + 1) / 12.0)
+                - decl.cumulative(j / 12.0));
+
+    auto fit = dca::best_from_interval_volume_bfgs<dca::arps_hyperbolic>(
+            vol.begin(), vol.end(), 0.0, 1.0 / 12.0,
+            std::make_tuple(10000.0, 1.0, 0.8));
+    BOOST_CHECK_CLOSE(decl.qi(), fit.qi(), tolerance_pct);
+    BOOST_CHECK_CLOSE(decl.Di(), fit.Di(), tolerance_pct);
+    BOOST_CHECK_CLOSE(decl.b(), fit.b(), tolerance_pct);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+#include "dca/convex.hpp"
+#include "dca/bestfit.hpp"
+#include "dca/decline.hpp"
+#include "dca/hyptoexp.hpp"
+
+#define BOOST_TEST_MODULE evolution
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// many local minima; the global one is at (1, -2)
+double rastrigin(const std::tuple<double, double>& t)
+{
+    const double pi = 3.14159265358979323846;
+    double x = std::get<0>(t) - 1.0, y = std::get<1>(t) + 2.0;
+    return 20.0 + x * x - 10.0 * std::cos(2.0 * pi * x)
+        + y * y - 10.0 * std::cos(2.0 * pi * y);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( differential_evolution )
+
+BOOST_AUTO_TEST_CASE( global_minimum )
+{
+    auto bounds = std::make_pair(std::make_tuple(-5.12, -5.12),
+            std::make_tuple(5.12, 5.12));
+
+    // Nelder-Mead from the usual inner simplex stops at a local minimum
+    auto local = convex::nelder_mead(rastrigin, convex::inner_simplex(bounds),
+            300);
+    BOOST_CHECK_GT(rastrigin(local), 0.5);
+
+    auto best = convex::differential_evolution(rastrigin, bounds, 500, 40);
+    BOOST_CHECK_SMALL(std::get<0>(best) - 1.0, 1e-4);
+    BOOST_CHECK_SMALL(std::get<1>(best) + 2.0, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE( deterministic )
+{
+    auto bounds = std::make_pair(std::make_tuple(-5.12, -5.12),
+            std::make_tuple(5.12, 5.12));
+
+    auto serial = convex::differential_evolution(rastrigin, bounds, 50, 20,
+            0.8, 0.9, 0, 1);
+    auto threaded = convex::differential_evolution(rastrigin, bounds, 50, 20,
+            0.8, 0.9, 0, 4);
+    BOOST_CHECK(serial == threaded);
+
+    // the batch form sees whole generations
+    std::size_t batches = 0, largest = 0;
+    auto batched = convex::differential_evolution_batch(
+            [&](const std::vector<std::tuple<double, double>>& points,
+                std::vector<double>& values) {
+                ++batches;
+                largest = std::max(largest, points.size());
+                values.resize(points.size());
+                for (std::size_t i = 0; i < points.size(); ++i)
+                    values[i] = rastrigin(points[i]);
+            }, bounds, 50, 20, 0.8, 0.9, 0);
+    BOOST_CHECK(serial == batched);
+    BOOST_CHECK_EQUAL(largest, 20u);
+    BOOST_CHECK_LE(batches, 51u);
+}
+
+BOOST_AUTO_TEST_CASE( within_bounds )
+{
+    // minimum outside the box: the best point is on its edge
+    auto best = convex::differential_evolution(
+            [](const std::tuple<double, double>& t) {
+                double x = std::get<0>(t) - 10.0, y = std::get<1>(t);
+                return x * x + y * y;
+            },
+            std::make_pair(std::make_tuple(0.0, -1.0),
+                std::make_tuple(2.0, 1.0)), 200, 0, 0.8, 0.9, 0);
+    BOOST_CHECK_LE(std::get<0>(best), 2.0);
+    BOOST_CHECK_GT(std::get<0>(best), 1.99);
+    BOOST_CHECK_SMALL(std::get<1>(best), 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE( hyperbolic_to_exponential )
+{
+    const double df = dca::decline<dca::tangent_effective>(0.05);
+    dca::arps_hyperbolic_to_exponential truth(50000.0, 2.5, 1.3, df);
+    std::vector<double> vols;
+    dca::interval_volumes(truth, std::back_inserter(vols), 0.0, 1.0 / 12.0,
+            48);
+
+    auto sse = [&](const std::tuple<double, double, double>& t) {
+        try {
+            return dca::detail::sse_against_interval(
+                    dca::arps_hyperbolic_to_exponential(std::get<0>(t),
+                        std::get<1>(t), std::get<2>(t), df),
+                    vols.begin(), vols.end(), 0.0, 1.0 / 12.0);
+        } catch (...) {
+            return std::numeric_limits<double>::infinity();
+        }
+    };
+
+    auto best = convex::differential_evolution(sse,
+            std::make_pair(std::make_tuple(0.0, 0.0, 0.0),
+                std::make_tuple(200000.0, 10.0, 3.0)), 300, 0, 0.8, 0.9,
+            500, 4);
+    BOOST_CHECK_CLOSE(std::get<0>(best), 50000.0, 1.0);
+    BOOST_CHECK_CLOSE(std::get<1>(best), 2.5, 1.0);
+    BOOST_CHECK_CLOSE(std::get<2>(best), 1.3, 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,17 +2,23 @@
 #include "dca/exponential.hpp"
 #include "dca/hyperbolic.hpp"
 #include "dca/hyptoexp.hpp"
+#include "dca/stretched.hpp"
+#include "dca/duong.hpp"
 #include "dca/bestfit.hpp"
 
 #define BOOST_TEST_MODULE fit
 #include <boost/test/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
 
+#include <chrono>
 #include <random>
 #include <cmath>
 #include <utility>
 #include <vector>
+#include <array>
 #include <algorithm>
+#include <iterator>
+#include <tuple>
 
 const double tolerance_pct = 1e-2;
 const int n_test = 100;
@@ -79,4 +85,336 @@ BOOST_AUTO_TEST_CASE( hyptoexp )
     std::mt19937 rng;
 }
 
+BOOST_AUTO_TEST_CASE( stretched_exponential )
+{
+    std::mt19937 rng;
+
+    std::uniform_real_distribution<> qi_log_dist(3.0, 7.0);
+    std::uniform_real_distribution<> tau_dist(0.2, 5.0);
+    std::uniform_real_distribution<> n_dist(0.2, 0.9);
+    for (int i = 0; i < n_test; ++i) {
+        dca::stretched_exponential decl(std::pow(10.0, qi_log_dist(rng)),
+                tau_dist(rng), n_dist(rng));
+        std::vector<double> vols;
+        dca::interval_volumes(decl, std::back_inserter(vols), 0.0,
+                1.0 / 12.0, 60);
+        auto fit = dca::best_from_interval_volume<
+            dca::stretched_exponential>(begin(vols), end(vols), 0.0,
+                    1.0 / 12.0);
+        BOOST_CHECK_CLOSE(decl.qi(), fit.qi(), tolerance_pct);
+        BOOST_CHECK_CLOSE(decl.tau(), fit.tau(), tolerance_pct);
+        BOOST_CHECK_CLOSE(decl.n(), fit.n(), tolerance_pct);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( duong )
+{
+    std::mt19937 rng;
+
+    std::uniform_real_distribution<> q1_log_dist(3.0, 7.0);
+    std::uniform_real_distribution<> a_dist(0.3, 2.0);
+    std::uniform_real_distribution<> m_dist(1.0, 1.6);
+    for (int i = 0; i < n_test; ++i) {
+        dca::duong decl(std::pow(10.0, q1_log_dist(rng)), a_dist(rng),
+                m_dist(rng));
+        std::vector<double> vols;
+        dca::interval_volumes(decl, std::back_inserter(vols), 0.0,
+                1.0 / 12.0, 60);
+        auto fit = dca::best_from_interval_volume<dca::duong>(
+                begin(vols), end(vols), 0.0, 1.0 / 12.0);
+        BOOST_CHECK_CLOSE(decl.q1(), fit.q1(), tolerance_pct);
+        BOOST_CHECK_CLOSE(decl.a(), fit.a(), tolerance_pct);
+        BOOST_CHECK_CLOSE(decl.m(), fit.m(), tolerance_pct);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( seeding )
+
+BOOST_AUTO_TEST_CASE( exponential_log_linear )
+{
+    dca::arps_exponential decl(5000.0, 0.7);
+    auto projection = forecast(decl, 0.0, 0.5, 20);
+    auto seed = dca::detail::decline_traits<dca::arps_exponential>::seed(
+            dca::detail::make_rate_samples(begin(projection.first),
+                end(projection.first), begin(projection.second)));
+    // exact for exponential data
+    BOOST_CHECK_CLOSE(std::get<0>(seed), 5000.0, tolerance_pct);
+    BOOST_CHECK_CLOSE(std::get<1>(seed), 0.7, tolerance_pct);
+}
+
+BOOST_AUTO_TEST_CASE( harmonic_inverse_rate )
+{
+    dca::arps_hyperbolic decl(800.0, 2.0, 1.0);
+    auto projection = forecast(decl, 0.0, 1.0 / 12.0, 36);
+    auto seed = dca::detail::decline_traits<dca::arps_hyperbolic>::seed(
+            dca::detail::make_rate_samples(begin(projection.first),
+                end(projection.first), begin(projection.second)));
+    // exact for harmonic data
+    BOOST_CHECK_CLOSE(std::get<0>(seed), 800.0, tolerance_pct);
+    BOOST_CHECK_CLOSE(std::get<1>(seed), 2.0, tolerance_pct);
+    BOOST_CHECK_CLOSE(std::get<2>(seed), 1.0, tolerance_pct);
+}
+
+BOOST_AUTO_TEST_CASE( hyperbolic_loss_ratio )
+{
+    dca::arps_hyperbolic decl(30000.0, 1.8, 0.6);
+    std::vector<double> vol;
+    dca::interval_volumes(decl, std::back_inserter(vol), 0.0, 1.0 / 12.0,
+            48);
+    auto seed = dca::detail::decline_traits<dca::arps_hyperbolic>::seed(
+            dca::detail::make_interval_samples(begin(vol), end(vol), 0.0,
+                1.0 / 12.0));
+    // close enough to start from: within a few percent
+    BOOST_CHECK_CLOSE(std::get<0>(seed), 30000.0, 5.0);
+    BOOST_CHECK_CLOSE(std::get<1>(seed), 1.8, 5.0);
+    BOOST_CHECK_CLOSE(std::get<2>(seed), 0.6, 5.0);
+
+    auto h2e = dca::detail::decline_traits<
+        dca::arps_hyperbolic_to_exponential>::seed(
+            dca::detail::make_interval_samples(begin(vol), end(vol), 0.0,
+                1.0 / 12.0));
+    BOOST_CHECK_GT(std::get<3>(h2e), 0.0);
+    BOOST_CHECK_LT(std::get<3>(h2e), std::get<1>(h2e));
+}
+
+BOOST_AUTO_TEST_CASE( no_decline )
+{
+    // flat or empty data still seed a valid decline
+    std::vector<double> flat(12, 100.0), none;
+    auto seed = dca::detail::decline_traits<dca::arps_hyperbolic>::seed(
+            dca::detail::make_interval_samples(begin(flat), end(flat), 0.0,
+                1.0 / 12.0));
+    BOOST_CHECK_NO_THROW(tuple::construct<dca::arps_hyperbolic>(seed));
+    auto empty = dca::detail::decline_traits<
+        dca::arps_hyperbolic_to_exponential>::seed(
+            dca::detail::make_interval_samples(begin(none), end(none), 0.0,
+                1.0 / 12.0));
+    BOOST_CHECK_NO_THROW(
+            tuple::construct<dca::arps_hyperbolic_to_exponential>(empty));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( joint )
+
+BOOST_AUTO_TEST_CASE( shared_b )
+{
+    dca::arps_hyperbolic oil(12000, 1.5, 1.1), gas(40000, 1.2, 1.1);
+    std::vector<double> oil_vol, gas_vol;
+    for (int i = 0; i < 48; ++i) {
+        oil_vol.push_back(oil.cumulative((i + 1) / 12.0)
+                - oil.cumulative(i / 12.0));
+        gas_vol.push_back(gas.cumulative((i + 1) / 12.0)
+                - gas.cumulative(i / 12.0));
+    }
+
+    using range = std::pair<std::vector<double>::iterator,
+          std::vector<double>::iterator>;
+    std::array<range, 2> phases { {
+        { begin(oil_vol), end(oil_vol) },
+        { begin(gas_vol), end(gas_vol) }
+    } };
+
+    auto fit = dca::best_from_interval_volume_shared_b<dca::arps_hyperbolic>(
+            phases, 0.0, 1.0 / 12.0);
+    BOOST_CHECK_EQUAL(fit[0].b(), fit[1].b());
+    for (std::size_t p = 0; p < 2; ++p) {
+        const auto& truth = p == 0 ? oil : gas;
+        BOOST_CHECK_CLOSE(fit[p].qi(), truth.qi(), 0.1);
+        BOOST_CHECK_CLOSE(fit[p].Di(), truth.Di(), 0.1);
+        BOOST_CHECK_CLOSE(fit[p].b(), truth.b(), 0.1);
+    }
+
+    auto h2e_fit = dca::best_from_interval_volume_shared_b<
+        dca::arps_hyperbolic_to_exponential>(phases, 0.0, 1.0 / 12.0);
+    BOOST_CHECK_EQUAL(h2e_fit[0].b(), h2e_fit[1].b());
+}
+
+BOOST_AUTO_TEST_CASE( separate_b )
+{
+    dca::arps_hyperbolic oil(12000, 1.5, 1.1), gas(40000, 1.2, 0.6);
+    std::vector<double> oil_vol, gas_vol;
+    for (int i = 0; i < 48; ++i) {
+        oil_vol.push_back(oil.cumulative((i + 1) / 12.0)
+                - oil.cumulative(i / 12.0));
+        gas_vol.push_back(gas.cumulative((i + 1) / 12.0)
+                - gas.cumulative(i / 12.0));
+    }
+
+    using range = std::pair<std::vector<double>::iterator,
+          std::vector<double>::iterator>;
+    std::array<range, 2> phases { {
+        { begin(oil_vol), end(oil_vol) },
+        { begin(gas_vol), end(gas_vol) }
+    } };
+
+    auto fit = dca::best_from_interval_volume_joint<dca::arps_hyperbolic>(
+            phases, 0.0, 1.0 / 12.0);
+    for (std::size_t p = 0; p < 2; ++p) {
+        const auto& truth = p == 0 ? oil : gas;
+        BOOST_CHECK_CLOSE(fit[p].qi(), truth.qi(), 0.1);
+        BOOST_CHECK_CLOSE(fit[p].Di(), truth.Di(), 0.1);
+        BOOST_CHECK_CLOSE(fit[p].b(), truth.b(), 0.1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( one_phase )
+{
+    // from six months on, as sse_against_interval counts them: the first
+    // interval is the cumulative to 0.5 + 1/12
+    dca::arps_hyperbolic decl(30000, 1.8, 0.9);
+    std::vector<double> vol;
+    for (int i = 0; i < 36; ++i)
+        vol.push_back((decl.cumulative(0.5 + (i + 1) / 12.0)
+                    - (i ? decl.cumulative(0.5 + i / 12.0) : 0.0))
+                * (1.0 + 0.05 * std::sin(1.7 * i)));
+
+    std::array<std::pair<std::vector<double>::iterator,
+        std::vector<double>::iterator>, 1> phases { {
+            { begin(vol), end(vol) }
+        } };
+    auto single = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.5, 1.0 / 12.0);
+    for (const auto& fit : {
+            dca::best_from_interval_volume_shared_b<dca::arps_hyperbolic>(
+                phases, 0.5, 1.0 / 12.0)[0],
+            dca::best_from_interval_volume_joint<dca::arps_hyperbolic>(
+                phases, 0.5, 1.0 / 12.0)[0] }) {
+        // the same fit, to the solver's tolerance: the joint SSE is scaled
+        // by the phase weight, so it stops at a different absolute change
+        BOOST_CHECK_CLOSE(fit.qi(), single.qi(), 0.5);
+        BOOST_CHECK_CLOSE(fit.Di(), single.Di(), 0.5);
+        BOOST_CHECK_CLOSE(fit.b(), single.b(), 0.5);
+        BOOST_CHECK_CLOSE(dca::detail::sse_against_interval(fit, begin(vol),
+                    end(vol), 0.5, 1.0 / 12.0),
+                dca::detail::sse_against_interval(single, begin(vol),
+                    end(vol), 0.5, 1.0 / 12.0), 0.1);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( options )
+
+namespace {
+
+std::vector<double> monthly_volumes(const dca::arps_hyperbolic& decl,
+        int months)
+{
+    std::vector<double> vol;
+    for (int i = 0; i < months; ++i)
+        vol.push_back(decl.cumulative((i + 1) / 12.0)
+                - decl.cumulative(i / 12.0));
+    return vol;
+}
+
+double sse(const dca::arps_hyperbolic& decl, const std::vector<double>& vol)
+{
+    return dca::detail::sse_against_interval(decl, begin(vol), end(vol),
+            0.0, 1.0 / 12.0);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( defaults_unchanged )
+{
+    auto vol = monthly_volumes(dca::arps_hyperbolic(30000, 1.8, 0.9), 36);
+    for (std::size_t i = 0; i < vol.size(); ++i)
+        vol[i] *= 1.0 + 0.05 * std::sin(1.7 * i);
+
+    dca::fit_status status = dca::fit_status::deadline;
+    auto fit = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0, dca::fit_options {},
+            &status);
+    BOOST_CHECK(status == dca::fit_status::complete);
+
+    // from convex::nelder_mead(sse, simplex, 300) before fit_options, on
+    // the same seeded simplex
+    BOOST_CHECK_CLOSE(fit.qi(), 30437.347848435362, 1e-5);
+    BOOST_CHECK_CLOSE(fit.Di(), 1.8689938343751797, 1e-5);
+    BOOST_CHECK_CLOSE(fit.b(), 0.92190708091681473, 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE( evaluation_budget )
+{
+    auto vol = monthly_volumes(dca::arps_hyperbolic(30000, 1.8, 0.9), 36);
+    auto full = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0);
+
+    dca::fit_options options;
+    options.max_evaluations = 12;
+    dca::fit_status status;
+    auto cut = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0, options, &status);
+    BOOST_CHECK(status == dca::fit_status::evaluation_limit);
+    // the best point so far: no better than the full fit
+    BOOST_CHECK_GE(sse(cut, vol), sse(full, vol));
+
+    options.max_evaluations = 1000000;
+    auto roomy = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0, options, &status);
+    BOOST_CHECK(status == dca::fit_status::complete);
+    BOOST_CHECK_EQUAL(roomy.qi(), full.qi());
+}
+
+BOOST_AUTO_TEST_CASE( deadline )
+{
+    auto vol = monthly_volumes(dca::arps_hyperbolic(30000, 1.8, 0.9), 36);
+
+    // already past: a single evaluation, of the first starting point
+    dca::fit_options options;
+    options.deadline = std::chrono::steady_clock::now();
+    dca::fit_status status;
+    auto fit = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0, options, &status);
+    BOOST_CHECK(status == dca::fit_status::deadline);
+    BOOST_CHECK_GT(fit.qi(), 0.0);
+
+    std::array<std::pair<std::vector<double>::iterator,
+        std::vector<double>::iterator>, 2> phases { {
+            { begin(vol), end(vol) }, { begin(vol), end(vol) }
+        } };
+    dca::best_from_interval_volume_shared_b<dca::arps_hyperbolic>(
+            phases, 0.0, 1.0 / 12.0, options, &status);
+    BOOST_CHECK(status == dca::fit_status::deadline);
+    dca::best_from_interval_volume_joint<dca::arps_hyperbolic>(
+            phases, 0.0, 1.0 / 12.0, options, &status);
+    BOOST_CHECK(status == dca::fit_status::deadline);
+}
+
+BOOST_AUTO_TEST_CASE( solvers )
+{
+    auto vol = monthly_volumes(dca::arps_hyperbolic(30000, 1.8, 0.9), 36);
+
+    dca::fit_options options;
+    options.deadline = std::chrono::steady_clock::now();
+    auto start = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0, options);
+    options.deadline = std::chrono::steady_clock::time_point::max();
+
+    for (auto solver : { dca::fit_solver::nelder_mead, dca::fit_solver::bfgs,
+            dca::fit_solver::differential_evolution }) {
+        options.solver = solver;
+        dca::fit_status status;
+        auto fit = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+                begin(vol), end(vol), 0.0, 1.0 / 12.0, options, &status);
+        BOOST_TEST_CONTEXT("solver " << static_cast<int>(solver)) {
+            BOOST_CHECK(status == dca::fit_status::complete);
+            // up to rounding: evolution needn't visit the starting point
+            BOOST_CHECK_LE(sse(fit, vol), sse(start, vol) * (1.0 + 1e-12));
+        }
+    }
+
+    // a warm start within budget
+    options.max_evaluations = 5;
+    dca::fit_status status;
+    auto refit = dca::best_from_interval_volume_bfgs<dca::arps_hyperbolic>(
+            begin(vol), end(vol), 0.0, 1.0 / 12.0,
+            std::make_tuple(30000.0, 1.8, 0.9), options, &status);
+    BOOST_CHECK(status == dca::fit_status::evaluation_limit);
+    BOOST_CHECK_LE(sse(refit, vol), 1e-6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
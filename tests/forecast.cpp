@@ -0,0 +1,139 @@
+#include "dca/forecast.hpp"
+#include "dca/any_decline.hpp"
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+
+#define BOOST_TEST_MODULE forecast
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+const double tolerance_pct = 1e-1;
+
+namespace {
+
+// counts evaluations, to check laziness
+struct counted_exponential {
+    dca::arps_exponential decline;
+    std::size_t* calls;
+
+    double rate(double t) const { ++*calls; return decline.rate(t); }
+    double cumulative(double t) const
+    {
+        ++*calls;
+        return decline.cumulative(t);
+    }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE( forecast_range )
+
+BOOST_AUTO_TEST_CASE( matches_interval_volumes )
+{
+    dca::arps_hyperbolic hyp(1000.0, 1.5, 1.2);
+    std::vector<double> expected;
+    dca::interval_volumes(hyp, std::back_inserter(expected),
+            0.0, 1.0 / 12.0, 240);
+
+    auto range = dca::forecast(hyp, 0.0, 1.0 / 12.0, 240);
+    BOOST_CHECK_EQUAL(std::distance(range.begin(), range.end()), 240);
+
+    std::size_t i = 0;
+    for (const auto& step : range) {
+        BOOST_REQUIRE_LT(i, expected.size());
+        BOOST_CHECK_EQUAL(step.index, i);
+        BOOST_CHECK_CLOSE(step.time, (i + 1) / 12.0, 1e-9);
+        BOOST_CHECK_CLOSE(step.volume, expected[i], 1e-7);
+        BOOST_CHECK_CLOSE(step.rate, hyp.rate(step.time), 1e-9);
+        BOOST_CHECK_CLOSE(step.cumulative, hyp.cumulative(step.time), 1e-9);
+        ++i;
+    }
+
+    auto volumes = range.volumes();
+    BOOST_CHECK_CLOSE(std::accumulate(volumes.begin(), volumes.end(), 0.0),
+            hyp.cumulative(20.0), 1e-7);
+
+    BOOST_CHECK(dca::forecast(hyp, 0.0, 1.0, 0).begin()
+            == dca::forecast(hyp, 0.0, 1.0, 0).end());
+}
+
+BOOST_AUTO_TEST_CASE( economic_limit )
+{
+    // through dca::any, as stored e.g. in a decline_registry
+    dca::any h2e = dca::arps_hyperbolic_to_exponential(800.0 * 365.25, 2.0, 0.9,
+            dca::decline<dca::tangent_effective>(0.05));
+    double limit = 365.25 * 5.0;
+
+    auto range = dca::forecast(h2e, 0.0, 1.0 / 12.0).until_rate(limit);
+    double last = 0.0, total = 0.0;
+    std::size_t steps = 0;
+    for (const auto& step : range) {
+        BOOST_CHECK_GE(step.rate, limit);
+        last = step.time;
+        total += step.volume;
+        ++steps;
+    }
+
+    BOOST_REQUIRE_GT(steps, 0u);
+    BOOST_CHECK_LT(h2e.rate(last + 1.0 / 12.0), limit);
+    BOOST_CHECK_CLOSE(total, h2e.cumulative(last), 1e-7);
+
+    // the narrower bound wins
+    auto short_range = range.take(12);
+    BOOST_CHECK_EQUAL(
+            std::distance(short_range.begin(), short_range.end()), 12);
+}
+
+BOOST_AUTO_TEST_CASE( lazy )
+{
+    std::size_t calls = 0;
+    counted_exponential decl { dca::arps_exponential(1000.0, 0.5), &calls };
+
+    auto range = dca::forecast(decl, 0.0, 1.0 / 12.0);
+    BOOST_CHECK_EQUAL(calls, 0u);
+
+    // an unbounded forecast, consumed only as far as needed
+    auto it = std::find_if(range.begin(), range.end(),
+            [](const dca::forecast_step& s) { return s.rate < 500.0; });
+    BOOST_REQUIRE(it != range.end());
+    BOOST_CHECK_CLOSE(it->time, 17.0 / 12.0, 1e-9);
+    BOOST_CHECK_EQUAL(calls, 1u + 2u * 17u);
+}
+
+BOOST_AUTO_TEST_CASE( zip_and_sum )
+{
+    dca::arps_exponential a(1000.0, 0.5), b(400.0, 0.2);
+    std::vector<double> prices(36);
+    for (std::size_t i = 0; i < prices.size(); ++i)
+        prices[i] = 60.0 + i;
+
+    // revenue against a price deck, without an intermediate buffer
+    auto volumes = dca::forecast(a, 0.0, 1.0 / 12.0, prices.size()).volumes();
+    double revenue = std::inner_product(volumes.begin(), volumes.end(),
+            prices.begin(), 0.0);
+
+    std::vector<double> expected;
+    dca::interval_volumes(a, std::back_inserter(expected),
+            0.0, 1.0 / 12.0, prices.size());
+    BOOST_CHECK_CLOSE(revenue, std::inner_product(expected.begin(),
+                expected.end(), prices.begin(), 0.0), 1e-7);
+
+    // sum across wells
+    std::vector<double> total(24, 0.0);
+    for (const auto& range : { dca::forecast(a, 0.0, 1.0 / 12.0, 24),
+            dca::forecast(b, 0.0, 1.0 / 12.0, 24) })
+        for (const auto& step : range)
+            total[step.index] += step.volume;
+
+    BOOST_CHECK_CLOSE(std::accumulate(total.begin(), total.end(), 0.0),
+            a.cumulative(2.0) + b.cumulative(2.0), tolerance_pct);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
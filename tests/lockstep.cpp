@@ -0,0 +1,184 @@
+#include "dca/convex.hpp"
+#include "dca/bestfit.hpp"
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+
+#define BOOST_TEST_MODULE lockstep
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using point = std::tuple<double, double>;
+
+// a different problem per lane: some smooth, some with local minima
+double objective(std::size_t lane, const point& t)
+{
+    const double pi = 3.14159265358979323846;
+    double x = std::get<0>(t) - 0.5 * lane, y = std::get<1>(t) + lane;
+    if (lane % 2)
+        return 20.0 + x * x - 10.0 * std::cos(2.0 * pi * x)
+            + y * y - 10.0 * std::cos(2.0 * pi * y);
+    return x * x + 10.0 * y * y + x * y;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( nelder_mead_batch )
+
+BOOST_AUTO_TEST_CASE( matches_serial )
+{
+    const std::size_t lanes = 9;
+    std::vector<convex::simplex<double, double>> initial;
+    for (std::size_t w = 0; w < lanes; ++w)
+        initial.push_back(convex::inner_simplex(std::make_pair(
+                        std::make_tuple(-5.0 - w, -5.0),
+                        std::make_tuple(5.0, 5.0 + w))));
+
+    std::size_t calls = 0, evaluated = 0;
+    auto found = convex::nelder_mead_batch(
+            [&](const std::array<const double*, 2>& x, const char* active,
+                std::size_t size, double* values) {
+                BOOST_CHECK_EQUAL(size, lanes);
+                ++calls;
+                for (std::size_t w = 0; w < size; ++w) {
+                    if (active[w]) {
+                        ++evaluated;
+                        values[w] = objective(w,
+                                std::make_tuple(x[0][w], x[1][w]));
+                    }
+                }
+            }, initial, 500);
+    BOOST_REQUIRE_EQUAL(found.size(), lanes);
+
+    std::size_t serial_evaluated = 0;
+    for (std::size_t w = 0; w < lanes; ++w) {
+        auto serial = convex::nelder_mead([&](const point& t) {
+                    ++serial_evaluated;
+                    return objective(w, t);
+                }, initial[w], 500);
+        BOOST_CHECK_SMALL(std::get<0>(found[w]) - std::get<0>(serial), 1e-9);
+        BOOST_CHECK_SMALL(std::get<1>(found[w]) - std::get<1>(serial), 1e-9);
+    }
+
+    // each lane takes the branches (and so the evaluations) it would alone,
+    // in a handful of batches per iteration
+    BOOST_CHECK_EQUAL(evaluated, serial_evaluated);
+    BOOST_CHECK_LT(calls, serial_evaluated / 2);
+}
+
+BOOST_AUTO_TEST_CASE( converged_lanes_drop_out )
+{
+    // one trivially easy lane, one slow one
+    std::vector<convex::simplex<double, double>> initial {
+        convex::inner_simplex(std::make_pair(std::make_tuple(-1.0, -1.0),
+                    std::make_tuple(1.0, 1.0))),
+        convex::inner_simplex(std::make_pair(std::make_tuple(-1e3, -1e3),
+                    std::make_tuple(1e3, 1e3)))
+    };
+
+    std::array<std::size_t, 2> evaluated { { 0, 0 } };
+    auto found = convex::nelder_mead_batch(
+            [&](const std::array<const double*, 2>& x, const char* active,
+                std::size_t size, double* values) {
+                for (std::size_t w = 0; w < size; ++w) {
+                    if (!active[w])
+                        continue;
+                    ++evaluated[w];
+                    double a = x[0][w] - 0.25, b = x[1][w] + 0.5;
+                    values[w] = w == 0 ? a * a + b * b
+                        : std::pow(a * a + b * b, 0.25);
+                }
+            }, initial, 1000);
+
+    BOOST_CHECK_LT(evaluated[0], evaluated[1]);
+    for (const auto& p : found) {
+        BOOST_CHECK_SMALL(std::get<0>(p) - 0.25, 1e-3);
+        BOOST_CHECK_SMALL(std::get<1>(p) + 0.5, 1e-3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( no_lanes )
+{
+    auto found = convex::nelder_mead_batch(
+            [](const std::array<const double*, 2>&, const char*,
+                std::size_t, double*) { },
+            std::vector<convex::simplex<double, double>>(), 100);
+    BOOST_CHECK(found.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( batch_fit )
+
+BOOST_AUTO_TEST_CASE( matches_per_well_fits )
+{
+    std::vector<std::vector<double>> volumes;
+    for (std::size_t w = 0; w < 11; ++w) {
+        dca::arps_hyperbolic truth(1e4 * (w + 1),
+                dca::decline<dca::nominal>(0.4 + 0.1 * w), 0.2 * (w % 6));
+        std::vector<double> vols;
+        dca::interval_volumes(truth, std::back_inserter(vols), 0.0,
+                1.0 / 12.0, 24 + w);
+        volumes.push_back(std::move(vols));
+    }
+
+    using range = std::pair<std::vector<double>::const_iterator,
+          std::vector<double>::const_iterator>;
+    std::vector<range> wells;
+    for (const auto& v : volumes)
+        wells.emplace_back(v.cbegin(), v.cend());
+
+    auto batch = dca::best_from_interval_volume_batch<dca::arps_hyperbolic>(
+            wells, 0.0, 1.0 / 12.0, dca::fit_options {}, 2, 4);
+    BOOST_REQUIRE_EQUAL(batch.size(), wells.size());
+
+    for (std::size_t w = 0; w < wells.size(); ++w) {
+        auto single = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+                wells[w].first, wells[w].second, 0.0, 1.0 / 12.0);
+        BOOST_CHECK_CLOSE(batch[w].qi(), single.qi(), 1e-6);
+        BOOST_CHECK_CLOSE(batch[w].Di(), single.Di(), 1e-6);
+        BOOST_CHECK_SMALL(batch[w].b() - single.b(), 1e-9);
+    }
+}
+
+// models without a batch kernel go lane by lane through their cumulative
+BOOST_AUTO_TEST_CASE( fallback_matches_per_well_fits )
+{
+    std::vector<std::vector<double>> volumes;
+    for (std::size_t w = 0; w < 7; ++w) {
+        dca::arps_exponential truth(1e4 * (w + 1), 0.2 + 0.15 * w);
+        std::vector<double> vols;
+        dca::interval_volumes(truth, std::back_inserter(vols), 0.0,
+                1.0 / 12.0, 12 + 3 * w);
+        volumes.push_back(std::move(vols));
+    }
+
+    using range = std::pair<std::vector<double>::const_iterator,
+          std::vector<double>::const_iterator>;
+    std::vector<range> wells;
+    for (const auto& v : volumes)
+        wells.emplace_back(v.cbegin(), v.cend());
+
+    auto batch = dca::best_from_interval_volume_batch<dca::arps_exponential>(
+            wells, 0.0, 1.0 / 12.0, dca::fit_options {}, 1, 3);
+    BOOST_REQUIRE_EQUAL(batch.size(), wells.size());
+
+    for (std::size_t w = 0; w < wells.size(); ++w) {
+        auto single = dca::best_from_interval_volume<dca::arps_exponential>(
+                wells[w].first, wells[w].second, 0.0, 1.0 / 12.0);
+        BOOST_CHECK_CLOSE(batch[w].qi(), single.qi(), 1e-6);
+        BOOST_CHECK_CLOSE(batch[w].D(), single.D(), 1e-6);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,142 @@
+#include "dca/parse.hpp"
+
+#define BOOST_TEST_MODULE parse
+#include <boost/test/unit_test.hpp>
+
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool parse(const char* text, double& value)
+{
+    return dca::parse_double(text, text + std::strlen(text), value);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( numbers )
+
+BOOST_AUTO_TEST_CASE( valid )
+{
+    const char* cases[] = {
+        "0", "-0", "12", "+12", "1234.5", "-0.001", ".5", "5.", "1e3",
+        "2.5E-3", "123456789012345678", "0.1", "1.7976931348623157e308",
+        "4.9e-324", "12345678901234567890123", "3.14159265358979323846"
+    };
+
+    for (auto text : cases) {
+        double value;
+        BOOST_CHECK_MESSAGE(parse(text, value), text);
+        BOOST_CHECK_EQUAL(value, std::strtod(text, nullptr));
+    }
+}
+
+BOOST_AUTO_TEST_CASE( invalid )
+{
+    const char* cases[] = {
+        "", "-", ".", "abc", "12abc", "1.2.3", "1e", "1e+", "--1", "1,000"
+    };
+
+    for (auto text : cases) {
+        double value;
+        BOOST_CHECK_MESSAGE(!parse(text, value), text);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( round_trip )
+{
+    std::mt19937_64 rand(42);
+    std::uniform_real_distribution<> volume(0.0, 1e5);
+    for (int i = 0; i < 10000; ++i) {
+        std::ostringstream os;
+        os.precision(i % 17 + 1);
+        os << volume(rand);
+        auto text = os.str();
+
+        double value;
+        BOOST_REQUIRE(parse(text.c_str(), value));
+        BOOST_REQUIRE_EQUAL(value, std::strtod(text.c_str(), nullptr));
+    }
+}
+
+// the strtod fallback, under a locale with a decimal comma (if installed)
+BOOST_AUTO_TEST_CASE( locale_independent )
+{
+    std::string saved = std::setlocale(LC_NUMERIC, nullptr);
+    bool comma = false;
+    for (auto name : { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8" })
+        if (std::setlocale(LC_NUMERIC, name)) {
+            comma = *std::localeconv()->decimal_point == ',';
+            break;
+        }
+
+    double value;
+    BOOST_CHECK(parse("3.14159265358979323846", value));
+    BOOST_CHECK_EQUAL(value, 3.14159265358979323846);
+    BOOST_CHECK(parse("1.5e-300", value));
+    BOOST_CHECK_EQUAL(value, 1.5e-300);
+    if (comma)
+        BOOST_CHECK(!parse("1,5", value));
+
+    std::setlocale(LC_NUMERIC, saved.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( columns )
+
+BOOST_AUTO_TEST_CASE( missing_and_errors )
+{
+    const std::vector<std::string> text {
+        "100", " 200.5 ", "", "NA", "garbage", "-3"
+    };
+
+    std::vector<double> values;
+    std::vector<std::size_t> errors;
+    dca::parse_options options;
+    options.missing_value = -1.0;
+    options.error_value = -2.0;
+    dca::parse_column(text.begin(), text.end(), std::back_inserter(values),
+            std::back_inserter(errors), options);
+
+    const std::vector<double> expected { 100, 200.5, -1, -1, -2, -3 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+            expected.begin(), expected.end());
+    BOOST_REQUIRE_EQUAL(errors.size(), 1u);
+    BOOST_CHECK_EQUAL(errors[0], 4u);
+
+    values.clear();
+    try {
+        dca::parse_column(text.begin(), text.end(),
+                std::back_inserter(values));
+        BOOST_ERROR("expected a parse_error");
+    } catch (const dca::parse_error& e) {
+        BOOST_CHECK_EQUAL(e.index(), 4u);
+        BOOST_CHECK_EQUAL(e.text(), "garbage");
+    }
+}
+
+BOOST_AUTO_TEST_CASE( block )
+{
+    const std::string text = "1\t2.5\tNA\n4e1\tx\t6\n";
+
+    std::vector<double> values;
+    std::vector<std::size_t> errors;
+    dca::parse_block(text.data(), text.data() + text.size(), '\t',
+            std::back_inserter(values), std::back_inserter(errors));
+
+    const std::vector<double> expected { 1, 2.5, 0, 40, 0, 6 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(),
+            expected.begin(), expected.end());
+    BOOST_REQUIRE_EQUAL(errors.size(), 1u);
+    BOOST_CHECK_EQUAL(errors[0], 4u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
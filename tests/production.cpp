@@ -0,0 +1,194 @@
+#include "dca/production.hpp"
+
+#define BOOST_TEST_MODULE production
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+using range = std::pair<std::vector<double>::const_iterator,
+      std::vector<double>::const_iterator>;
+
+BOOST_AUTO_TEST_SUITE( cleaning )
+
+BOOST_AUTO_TEST_CASE( single_stream )
+{
+    const std::vector<double> oil {
+        0, 0, 500, 1200, 900, 0, 700, 600, 0, 0
+    };
+
+    std::size_t offset;
+    auto view = dca::clean_production(oil.begin(), oil.end(),
+            dca::cleaning_options {}, &offset);
+    BOOST_CHECK_EQUAL(offset, 3u);
+    BOOST_CHECK(view.first == oil.begin() + 3);
+    BOOST_CHECK(view.second == oil.begin() + 8);
+
+    dca::cleaning_options no_shift;
+    no_shift.shift_to_peak = false;
+    view = dca::clean_production(oil.begin(), oil.end(), no_shift, &offset);
+    BOOST_CHECK_EQUAL(offset, 2u);
+    BOOST_CHECK(view.first == oil.begin() + 2);
+
+    no_shift.trim_trailing = false;
+    no_shift.trim_leading = false;
+    view = dca::clean_production(oil.begin(), oil.end(), no_shift);
+    BOOST_CHECK(view.first == oil.begin());
+    BOOST_CHECK(view.second == oil.end());
+
+    const std::vector<double> dry(5, 0.0);
+    auto empty = dca::clean_production(dry.begin(), dry.end());
+    BOOST_CHECK(empty.first == empty.second);
+}
+
+BOOST_AUTO_TEST_CASE( tied_streams )
+{
+    const std::vector<double> oil { 0, 800, 1000, 700, 500, 0 };
+    const std::vector<double> gas { 100, 4000, 3500, 3000, 0, 0, 0 };
+
+    std::size_t offset;
+    auto views = dca::clean_production(std::array<range, 2> { {
+                { oil.begin(), oil.end() },
+                { gas.begin(), gas.end() }
+            } }, dca::cleaning_options {}, &offset);
+
+    // both streams share the oil peak as time origin
+    BOOST_CHECK_EQUAL(offset, 2u);
+    BOOST_CHECK(views[0].first == oil.begin() + 2);
+    BOOST_CHECK(views[0].second == oil.begin() + 5);
+    BOOST_CHECK(views[1].first == gas.begin() + 2);
+    BOOST_CHECK(views[1].second == gas.begin() + 4);
+
+    // and feed aggregate_production as-is
+    std::vector<double> type_well;
+    std::vector<range> ranges(views.begin(), views.end());
+    dca::aggregate_production(ranges.begin(), ranges.end(),
+            std::back_inserter(type_well), 2, dca::mean {});
+    BOOST_REQUIRE_EQUAL(type_well.size(), 2u);
+    BOOST_CHECK_EQUAL(type_well[0], (1000.0 + 3500.0) / 2.0);
+}
+
+BOOST_AUTO_TEST_CASE( flags )
+{
+    const std::vector<double> oil {
+        1000, 950, 0, 900, 8000, 850, 800, 20, 750, 700
+    };
+
+    std::vector<std::size_t> shut_in, outliers;
+    dca::shut_in_months(oil.begin(), oil.end(), std::back_inserter(shut_in));
+    dca::flag_outliers(oil.begin(), oil.end(), std::back_inserter(outliers));
+
+    BOOST_REQUIRE_EQUAL(shut_in.size(), 1u);
+    BOOST_CHECK_EQUAL(shut_in[0], 2u);
+    BOOST_REQUIRE_EQUAL(outliers.size(), 2u);
+    BOOST_CHECK_EQUAL(outliers[0], 4u);
+    BOOST_CHECK_EQUAL(outliers[1], 7u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( well_index )
+
+BOOST_AUTO_TEST_CASE( grouped )
+{
+    const std::vector<std::string> ids { "A", "A", "B", "B", "B", "C" };
+    dca::well_index wells(ids.begin(), ids.end());
+
+    BOOST_CHECK(wells.contiguous());
+    BOOST_REQUIRE_EQUAL(wells.size(), 3u);
+    BOOST_CHECK_EQUAL(wells.rows(), 6u);
+    BOOST_CHECK_EQUAL(wells[1].offset, 2u);
+    BOOST_CHECK_EQUAL(wells[1].length, 3u);
+    BOOST_CHECK_EQUAL(ids[wells.row(2)], "C");
+}
+
+BOOST_AUTO_TEST_CASE( interleaved )
+{
+    const std::vector<std::string> ids { "A", "B", "A", "C", "B", "A" };
+    const std::vector<double> oil { 10, 20, 11, 30, 21, 12 };
+    dca::well_index wells(ids.begin(), ids.end());
+
+    BOOST_CHECK(!wells.contiguous());
+    BOOST_REQUIRE_EQUAL(wells.size(), 3u);
+
+    std::vector<double> by_well;
+    wells.gather(oil.begin(), std::back_inserter(by_well));
+    const std::vector<double> expected { 10, 11, 12, 20, 21, 30 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(by_well.begin(), by_well.end(),
+            expected.begin(), expected.end());
+
+    auto b = wells.rows_of(1, by_well.cbegin());
+    BOOST_CHECK_EQUAL(std::distance(b.first, b.second), 2);
+    BOOST_CHECK_EQUAL(*b.first, 20.0);
+    BOOST_CHECK_EQUAL(ids[wells.row(1)], "B");
+    BOOST_CHECK_EQUAL(wells.row(0, 2), 5u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( aggregation )
+
+BOOST_AUTO_TEST_CASE( parallel_matches_serial )
+{
+    std::mt19937 gen(39);
+    std::uniform_int_distribution<std::size_t> length(0, 120);
+    std::uniform_real_distribution<double> volume(0.0, 5000.0);
+
+    std::vector<std::vector<double>> wells(300);
+    for (auto& well : wells)
+        std::generate_n(std::back_inserter(well), length(gen),
+                [&]() { return volume(gen); });
+    std::vector<range> ranges;
+    for (const auto& well : wells)
+        ranges.emplace_back(well.begin(), well.end());
+
+    for (std::size_t min_streams : { 0, 1, 50, 150, 299, 300, 301 }) {
+        for (unsigned threads : { 1u, 3u, 8u }) {
+            std::vector<double> serial, parallel;
+            dca::aggregate_production(ranges.begin(), ranges.end(),
+                    std::back_inserter(serial), min_streams,
+                    dca::percentile(0.9));
+            dca::parallel_aggregate_production(ranges.begin(), ranges.end(),
+                    std::back_inserter(parallel), min_streams,
+                    dca::percentile(0.9), threads);
+            BOOST_CHECK(serial == parallel);
+
+            serial.clear();
+            parallel.clear();
+            dca::aggregate_production(wells.begin(), wells.end(),
+                    std::back_inserter(serial), min_streams, dca::mean {});
+            dca::parallel_aggregate_production(wells.begin(), wells.end(),
+                    std::back_inserter(parallel), min_streams, dca::mean {},
+                    threads);
+            BOOST_CHECK(serial == parallel);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( min_streams_cutoff )
+{
+    const std::vector<std::vector<double>> prod {
+        { 4000, 3000, 2000, 1000, 500, 100 },
+        { 1000, 750, 650 },
+        { 2500, 2000, 1250, 750 }
+    };
+
+    std::vector<double> all, two;
+    dca::parallel_aggregate_production(prod.begin(), prod.end(),
+            std::back_inserter(all), 0, dca::mean {});
+    dca::parallel_aggregate_production(prod.begin(), prod.end(),
+            std::back_inserter(two), 2, dca::mean {});
+
+    // while any stream remains, or while at least two do
+    BOOST_REQUIRE_EQUAL(all.size(), 6u);
+    BOOST_CHECK_EQUAL(all[5], 100.0);
+    BOOST_REQUIRE_EQUAL(two.size(), 4u);
+    BOOST_CHECK_EQUAL(two[3], (1000.0 + 750.0) / 2.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
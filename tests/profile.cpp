@@ -0,0 +1,125 @@
+#ifndef DCA_PROFILE
+#define DCA_PROFILE
+#endif
+#include "dca/profile.hpp"
+#include "dca/bestfit.hpp"
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/parallel.hpp"
+
+#define BOOST_TEST_MODULE profile
+#include <boost/test/unit_test.hpp>
+
+#include <array>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::uint64_t counted(dca::profile::probe p)
+{
+    return dca::profile::snapshot()[p].count;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( profile )
+
+BOOST_AUTO_TEST_CASE( counts_across_threads )
+{
+    dca::profile::reset();
+
+    dca::arps_hyperbolic hyp(1000.0, 1.5, 1.2);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&]() {
+            double sum = 0.0;
+            for (int i = 0; i < 1000; ++i)
+                sum += hyp.rate(i / 12.0) + hyp.cumulative(i / 12.0);
+            BOOST_CHECK_GT(sum, 0.0);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    // exited threads' counts are kept
+    BOOST_CHECK_EQUAL(counted(dca::profile::rate), 4000u);
+    BOOST_CHECK_EQUAL(counted(dca::profile::cumulative), 4000u);
+
+    // live threads' counts are merged in
+    hyp.rate(1.0);
+    BOOST_CHECK_EQUAL(counted(dca::profile::rate), 4001u);
+
+    dca::convert_decline<dca::nominal, dca::tangent_effective>(0.5);
+    BOOST_CHECK_EQUAL(counted(dca::profile::convert_decline), 1u);
+
+    dca::profile::reset();
+    BOOST_CHECK_EQUAL(counted(dca::profile::rate), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( fits )
+{
+    dca::profile::reset();
+
+    dca::arps_hyperbolic hyp(1000.0, 1.5, 1.2);
+    std::vector<double> vols;
+    dca::interval_volumes(hyp, std::back_inserter(vols), 0.0, 1.0 / 12.0,
+            36);
+
+    dca::parallel_for(4, [&](std::size_t) {
+        dca::best_from_interval_volume<dca::arps_hyperbolic>(
+                vols.begin(), vols.end(), 0.0, 1.0 / 12.0);
+    }, 4);
+
+    auto report = dca::profile::snapshot();
+    BOOST_CHECK_EQUAL(report[dca::profile::fit].count, 4u);
+    BOOST_CHECK_EQUAL(report[dca::profile::optimize].count, 4u);
+    BOOST_CHECK_GT(report[dca::profile::fit].seconds, 0.0);
+    BOOST_CHECK_GE(report[dca::profile::fit].seconds,
+            report[dca::profile::optimize].seconds);
+    BOOST_CHECK_GT(report[dca::profile::objective].count, 4u);
+    // every objective evaluation runs the model once per month or throws
+    BOOST_CHECK_GE(report[dca::profile::cumulative].count,
+            36 * (report[dca::profile::objective].count
+                - report[dca::profile::infeasible].count));
+
+#ifndef DCA_NO_IOSTREAMS
+    std::ostringstream os;
+    dca::profile::print(os, report);
+    BOOST_CHECK(os.str().find("objective") != std::string::npos);
+    BOOST_CHECK(os.str().find("time_solve") == std::string::npos);
+#endif
+}
+
+// finite-difference gradients are charged for every SSE they take
+BOOST_AUTO_TEST_CASE( shared_b_budget )
+{
+    dca::arps_hyperbolic oil(1000.0, 1.5, 1.2), gas(3000.0, 1.1, 1.2);
+    std::vector<double> oil_vol, gas_vol;
+    dca::interval_volumes(oil, std::back_inserter(oil_vol), 0.0, 1.0 / 12.0,
+            36);
+    dca::interval_volumes(gas, std::back_inserter(gas_vol), 0.0, 1.0 / 12.0,
+            36);
+    using range = std::pair<std::vector<double>::iterator,
+          std::vector<double>::iterator>;
+    std::array<range, 2> phases { {
+        { oil_vol.begin(), oil_vol.end() },
+        { gas_vol.begin(), gas_vol.end() }
+    } };
+
+    dca::fit_options options;
+    options.solver = dca::fit_solver::bfgs;
+    options.max_evaluations = 40;
+    dca::fit_status status;
+    dca::profile::reset();
+    dca::best_from_interval_volume_shared_b<dca::arps_hyperbolic>(phases,
+            0.0, 1.0 / 12.0, options, &status);
+    BOOST_CHECK(status == dca::fit_status::evaluation_limit);
+    BOOST_CHECK_LE(counted(dca::profile::objective), 40u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
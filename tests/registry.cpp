@@ -0,0 +1,157 @@
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/registry.hpp"
+
+#define BOOST_TEST_MODULE registry
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+const double tolerance_pct = 1e-1;
+
+BOOST_AUTO_TEST_SUITE( registry )
+
+BOOST_AUTO_TEST_CASE( publish_and_lookup )
+{
+    dca::decline_registry reg(4);
+
+    std::vector<std::string> names { "A", "B", "C", "A" };
+    std::vector<dca::decline_registry::id_type> ids;
+    reg.intern(names.begin(), names.end(), std::back_inserter(ids));
+    BOOST_CHECK_EQUAL(reg.size(), 3u);
+    BOOST_CHECK_EQUAL(ids[0], ids[3]);
+    BOOST_CHECK_EQUAL(reg.intern("B"), ids[1]);
+
+    reg.publish(ids[0], dca::arps_exponential(1000.0, 0.5));
+    reg.publish("B", dca::arps_hyperbolic(2000.0, 1.0, 1.2));
+
+    auto reader = reg.make_reader();
+    double rate = 0.0;
+    BOOST_CHECK(reader.with(ids[0], [&](const dca::any& d) {
+                rate = d.rate(0.0);
+            }));
+    BOOST_CHECK_CLOSE(rate, 1000.0, tolerance_pct);
+
+    dca::decline_registry::id_type id = 0;
+    BOOST_REQUIRE(reader.find("B", id));
+    BOOST_CHECK(reader.with(id, [&](const dca::any& d) {
+                rate = d.rate(0.0);
+            }));
+    BOOST_CHECK_CLOSE(rate, 2000.0, tolerance_pct);
+
+    BOOST_CHECK(!reader.find("D", id));
+    BOOST_CHECK(!reader.with(ids[2], [](const dca::any&) { }));
+    BOOST_CHECK(!reader.with(1000, [](const dca::any&) { }));
+    BOOST_CHECK_THROW(reg.publish(1000, dca::arps_exponential(1.0, 1.0)),
+            std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE( reclamation )
+{
+    dca::decline_registry reg(2);
+    auto id = reg.intern("A");
+    reg.publish(id, dca::arps_exponential(1000.0, 0.5));
+    reg.reclaim();
+
+    auto reader = reg.make_reader();
+    auto other = reg.make_reader();
+    BOOST_CHECK_THROW(reg.make_reader(), std::out_of_range);
+
+    // a reader inside with() pins the snapshot it's looking at
+    reader.with(id, [&](const dca::any& d) {
+        reg.publish(id, dca::arps_exponential(500.0, 0.5));
+        BOOST_CHECK_EQUAL(reg.reclaim(), 0u);
+        BOOST_CHECK_CLOSE(d.rate(0.0), 1000.0, tolerance_pct);
+    });
+    BOOST_CHECK_EQUAL(reg.reclaim(), 1u);
+
+    reader.with(id, [&](const dca::any& d) {
+        BOOST_CHECK_CLOSE(d.rate(0.0), 500.0, tolerance_pct);
+    });
+}
+
+BOOST_AUTO_TEST_CASE( bulk_load )
+{
+    // as forecast_server loads its declines: intern all, then publish by ID
+    const std::size_t wells = 5000;
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < wells; ++i)
+        names.push_back("well-" + std::to_string(i));
+
+    dca::decline_registry reg(2);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<dca::decline_registry::id_type> ids;
+    reg.intern(names.begin(), names.end(), std::back_inserter(ids));
+    for (std::size_t i = 0; i < wells; ++i)
+        reg.publish(ids[i], dca::arps_exponential(1000.0 + i, 0.5));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // milliseconds; a table copy per well took about a second
+    BOOST_CHECK(elapsed < std::chrono::milliseconds(250));
+    BOOST_CHECK_EQUAL(reg.size(), wells);
+
+    // a replaced name table is freed as soon as no reader holds it
+    for (std::size_t i = 0; i < 100; ++i)
+        reg.intern("extra-" + std::to_string(i));
+    BOOST_CHECK_EQUAL(reg.reclaim(), 0u);
+
+    auto reader = reg.make_reader();
+    dca::decline_registry::id_type id = 0;
+    BOOST_REQUIRE(reader.find("well-4321", id));
+    BOOST_CHECK(reader.with(id, [&](const dca::any& d) {
+                BOOST_CHECK_CLOSE(d.rate(0.0), 5321.0, tolerance_pct);
+            }));
+}
+
+BOOST_AUTO_TEST_CASE( concurrent )
+{
+    const std::size_t wells = 100;
+    dca::decline_registry reg(8);
+    std::vector<dca::decline_registry::id_type> ids;
+    for (std::size_t i = 0; i < wells; ++i) {
+        ids.push_back(reg.intern(std::to_string(i)));
+        reg.publish(ids.back(), dca::arps_exponential(1.0, 0.5));
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> bad(0);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&]() {
+            auto reader = reg.make_reader();
+            while (!done) {
+                for (auto id : ids) {
+                    reader.with(id, [&](const dca::any& d) {
+                        double q = d.rate(0.0);
+                        if (q < 1.0 || q > 200.0 || q != static_cast<int>(q))
+                            ++bad;
+                    });
+                }
+            }
+        });
+    }
+
+    for (int version = 2; version <= 200; ++version)
+        for (auto id : ids)
+            reg.publish(id, dca::arps_exponential(version, 0.5));
+    done = true;
+    for (auto& t : readers)
+        t.join();
+
+    BOOST_CHECK_EQUAL(bad.load(), 0u);
+    reg.reclaim();
+
+    auto reader = reg.make_reader();
+    for (auto id : ids)
+        reader.with(id, [&](const dca::any& d) {
+            BOOST_CHECK_EQUAL(d.rate(0.0), 200.0);
+        });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
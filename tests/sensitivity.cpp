@@ -0,0 +1,160 @@
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+#include "dca/duong.hpp"
+#include "dca/sensitivity.hpp"
+
+#define BOOST_TEST_MODULE sensitivity
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+const double tolerance_pct = 1e-1;
+
+BOOST_AUTO_TEST_SUITE( batch )
+
+BOOST_AUTO_TEST_CASE( matches_eur )
+{
+    std::vector<dca::arps_hyperbolic> declines;
+    std::vector<dca::eur_query> queries;
+    for (int i = 0; i < 50; ++i) {
+        declines.emplace_back(1000.0 * (i + 1), 0.5 + 0.05 * i, 0.1 + 0.03 * i);
+        queries.push_back(dca::eur_query { 5.0 + i, (i % 2) ? 30.0
+                : std::numeric_limits<double>::infinity() });
+    }
+
+    auto results = dca::eur_batch(declines, queries);
+    for (std::size_t i = 0; i < declines.size(); ++i) {
+        double time;
+        double expected = dca::eur(declines[i], queries[i].economic_limit,
+                queries[i].max_time, &time);
+        BOOST_CHECK_CLOSE(results[i].eur, expected, tolerance_pct);
+        BOOST_CHECK_CLOSE(results[i].time, time, tolerance_pct);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( degenerate )
+{
+    std::vector<dca::arps_exponential> declines {
+        dca::arps_exponential(10.0, 0.5),
+        dca::arps_exponential(1000.0, 0.01)
+    };
+    std::vector<dca::eur_query> queries {
+        dca::eur_query { 20.0, 50.0 }, // starts below the limit
+        dca::eur_query { 1.0, 50.0 } // limited by max_time
+    };
+
+    auto results = dca::eur_batch(declines, queries);
+    BOOST_CHECK_EQUAL(results[0].time, 0.0);
+    BOOST_CHECK_EQUAL(results[0].eur, 0.0);
+    BOOST_CHECK_EQUAL(results[1].time, 50.0);
+    BOOST_CHECK_CLOSE(results[1].eur, declines[1].cumulative(50.0),
+            tolerance_pct);
+}
+
+BOOST_AUTO_TEST_CASE( duong )
+{
+    // rates that climb to a peak before declining
+    std::vector<dca::duong> declines {
+        dca::duong(365.25 * 500.0, 1.2, 1.3),
+        dca::duong(365.25 * 500.0, 1.2, 1.3),
+        dca::duong(365.25 * 500.0, 0.5, 0.9)
+    };
+    std::vector<dca::eur_query> queries {
+        dca::eur_query { 365.25, 30.0 }, // limited by max_time
+        dca::eur_query { 365.25 * 100.0, 30.0 },
+        dca::eur_query { 365.25 * 200.0, 30.0 }
+    };
+
+    auto results = dca::eur_batch(declines, queries);
+    BOOST_CHECK_EQUAL(results[0].time, 30.0);
+    BOOST_CHECK_CLOSE(results[0].eur, declines[0].cumulative(30.0),
+            tolerance_pct);
+    for (std::size_t i = 1; i < declines.size(); ++i) {
+        BOOST_CHECK(results[i].time > 1.0 && results[i].time < 30.0);
+        BOOST_CHECK_CLOSE(declines[i].rate(results[i].time),
+                queries[i].economic_limit, tolerance_pct);
+        BOOST_CHECK_CLOSE(results[i].eur,
+                declines[i].cumulative(results[i].time), tolerance_pct);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( tornado )
+
+BOOST_AUTO_TEST_CASE( elasticity )
+{
+    auto params = std::make_tuple(10000.0, 0.8, 1.1);
+    std::vector<dca::eur_perturbation> perturbations {
+        dca::eur_perturbation { 0, -0.1, 0.1 },
+        dca::eur_perturbation { 1, -0.1, 0.1 },
+        dca::eur_perturbation { dca::eur_perturbation::max_time, -0.1, 0.1 },
+        dca::eur_perturbation { 2, -2.0, 0.1 } // b < 0: invalid
+    };
+
+    // economic limit too low to bind: EUR is proportional to qi
+    auto tornado = dca::eur_sensitivity<dca::arps_hyperbolic>(params,
+            1e-6, 30.0, perturbations);
+
+    BOOST_CHECK_CLOSE(tornado.base.eur,
+            dca::arps_hyperbolic(10000.0, 0.8, 1.1).cumulative(30.0),
+            tolerance_pct);
+    BOOST_REQUIRE_EQUAL(tornado.bars.size(), perturbations.size());
+
+    for (const auto& bar : tornado.bars) {
+        if (bar.perturbation.input != 2)
+            BOOST_CHECK(bar.valid);
+        if (bar.perturbation.input == 0) {
+            BOOST_CHECK_CLOSE(bar.elasticity, 1.0, tolerance_pct);
+            BOOST_CHECK_CLOSE(bar.high_delta, -bar.low_delta, tolerance_pct);
+        } else if (bar.perturbation.input == 1) {
+            BOOST_CHECK_LT(bar.elasticity, 0.0);
+        } else if (bar.perturbation.input
+                == dca::eur_perturbation::max_time) {
+            BOOST_CHECK_GT(bar.elasticity, 0.0);
+        } else {
+            BOOST_CHECK(!bar.valid);
+        }
+    }
+
+    BOOST_CHECK(!tornado.bars.back().valid);
+    for (std::size_t i = 1; i + 1 < tornado.bars.size(); ++i)
+        BOOST_CHECK_GE(
+            std::abs(tornado.bars[i - 1].high_delta
+                - tornado.bars[i - 1].low_delta),
+            std::abs(tornado.bars[i].high_delta - tornado.bars[i].low_delta));
+}
+
+BOOST_AUTO_TEST_CASE( many_wells )
+{
+    std::vector<std::tuple<double, double, double>> wells;
+    for (int i = 0; i < 20; ++i)
+        wells.emplace_back(1000.0 + 100.0 * i, 0.5 + 0.1 * i, 0.5 + 0.05 * i);
+    std::vector<dca::eur_perturbation> perturbations {
+        dca::eur_perturbation { 0, -0.2, 0.2 },
+        dca::eur_perturbation { dca::eur_perturbation::economic_limit,
+            -0.2, 0.2 }
+    };
+
+    std::vector<dca::eur_tornado> tornados;
+    dca::eur_sensitivity<dca::arps_hyperbolic>(wells.begin(), wells.end(),
+            10.0, 50.0, perturbations, std::back_inserter(tornados), 4);
+
+    BOOST_REQUIRE_EQUAL(tornados.size(), wells.size());
+    for (std::size_t i = 0; i < wells.size(); ++i) {
+        auto single = dca::eur_sensitivity<dca::arps_hyperbolic>(wells[i],
+                10.0, 50.0, perturbations);
+        BOOST_CHECK_EQUAL(tornados[i].base.eur, single.base.eur);
+        BOOST_CHECK_CLOSE(tornados[i].base.eur,
+                dca::eur(tuple::construct<dca::arps_hyperbolic>(wells[i]),
+                    10.0, 50.0), tolerance_pct);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
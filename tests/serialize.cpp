@@ -0,0 +1,156 @@
+#include "dca/serialize.hpp"
+#include "dca/any_decline.hpp"
+
+#define BOOST_TEST_MODULE serialize
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// a decline the library doesn't know how to encode
+struct linear {
+    double rate(double time) const { return 100.0 - time; }
+    double cumulative(double time) const
+    {
+        return 100.0 * time - 0.5 * time * time;
+    }
+};
+
+#ifndef DCA_NO_IOSTREAMS
+std::ostream& operator<<(std::ostream& os, const linear&)
+{
+    return os << "<linear>";
+}
+#endif
+
+}
+
+BOOST_AUTO_TEST_SUITE( batch )
+
+BOOST_AUTO_TEST_CASE( typed_round_trip )
+{
+    std::vector<dca::arps_hyperbolic> declines;
+    for (int i = 0; i < 5; ++i)
+        declines.emplace_back(1000.0 * (i + 1), 0.3 + 0.1 * i, 0.25 * i);
+
+    std::vector<char> bytes;
+    dca::serialize_declines(declines.begin(), declines.end(), bytes);
+    BOOST_CHECK_EQUAL(bytes.size(), dca::decline_batch_size(5, 3));
+
+    dca::decline_batch_view view(bytes.data(), bytes.size());
+    BOOST_REQUIRE_EQUAL(view.size(), 5u);
+    BOOST_REQUIRE_EQUAL(view.width(), 3u);
+
+    // parameters as SoA columns
+    for (std::size_t i = 0; i < 5; ++i) {
+        BOOST_CHECK(view.tag(i) == dca::decline_tag::arps_hyperbolic);
+        BOOST_CHECK_EQUAL(view.column(0)[i], declines[i].qi());
+        BOOST_CHECK_EQUAL(view.column(1)[i], declines[i].Di());
+        BOOST_CHECK_EQUAL(view.column(2)[i], declines[i].b());
+    }
+
+    std::vector<dca::arps_hyperbolic> back;
+    dca::deserialize_declines<dca::arps_hyperbolic>(view,
+            std::back_inserter(back));
+    BOOST_REQUIRE_EQUAL(back.size(), declines.size());
+    for (std::size_t i = 0; i < back.size(); ++i)
+        BOOST_CHECK_EQUAL(back[i].cumulative(7.5),
+                declines[i].cumulative(7.5));
+
+    BOOST_CHECK_THROW(view.get<dca::arps_exponential>(0),
+            std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE( any_round_trip )
+{
+    std::vector<dca::any> declines {
+        dca::arps_exponential(500.0, 0.4),
+        dca::arps_hyperbolic(800.0, 1.1, 1.3),
+        dca::arps_hyperbolic_to_exponential(900.0, 1.5, 1.2, 0.08),
+        dca::stretched_exponential(700.0, 0.6, 0.35),
+        dca::duong(400.0, 1.4, 1.2)
+    };
+
+    std::vector<char> bytes;
+    dca::serialize_declines(declines.begin(), declines.end(), bytes);
+    dca::decline_batch_view view(bytes.data(), bytes.size());
+    BOOST_CHECK_EQUAL(view.width(), dca::max_decline_params);
+    BOOST_CHECK(view.tag(3) == dca::decline_tag::stretched_exponential);
+    BOOST_CHECK_EQUAL(view.column(3)[0], 0.0); // narrower, zero-padded
+
+    std::vector<dca::any> back;
+    dca::deserialize_declines<dca::any>(view, std::back_inserter(back));
+    BOOST_REQUIRE_EQUAL(back.size(), declines.size());
+    for (std::size_t i = 0; i < back.size(); ++i) {
+        BOOST_CHECK(back[i].tag() == declines[i].tag());
+        for (double t : { 0.5, 3.0, 20.0 }) {
+            BOOST_CHECK_EQUAL(back[i].rate(t), declines[i].rate(t));
+            BOOST_CHECK_EQUAL(back[i].cumulative(t),
+                    declines[i].cumulative(t));
+        }
+    }
+
+    // a typed read of one of them
+    auto duong = view.get<dca::duong>(4);
+    BOOST_CHECK_EQUAL(duong.m(), 1.2);
+}
+
+BOOST_AUTO_TEST_CASE( appends_and_empty )
+{
+    std::vector<char> bytes { 'x' };
+    std::vector<dca::arps_exponential> none;
+    dca::serialize_declines(none.begin(), none.end(), bytes);
+    BOOST_CHECK_EQUAL(bytes.size(), 1 + dca::decline_batch_size(0, 0));
+
+    std::vector<char> aligned(bytes.begin() + 1, bytes.end());
+    dca::decline_batch_view view(aligned.data(), aligned.size());
+    BOOST_CHECK_EQUAL(view.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE( rejects )
+{
+    std::vector<dca::any> unknown { linear() };
+    std::vector<char> bytes;
+    BOOST_CHECK(unknown[0].tag() == dca::decline_tag::none);
+    BOOST_CHECK_THROW(dca::serialize_declines(unknown.begin(), unknown.end(),
+                bytes), std::invalid_argument);
+
+    std::vector<dca::arps_exponential> declines {
+        dca::arps_exponential(500.0, 0.4)
+    };
+    dca::serialize_declines(declines.begin(), declines.end(), bytes);
+
+    BOOST_CHECK_THROW(dca::decline_batch_view(bytes.data(), 10),
+            std::invalid_argument);
+    BOOST_CHECK_THROW(dca::decline_batch_view(bytes.data(), bytes.size() - 8),
+            std::invalid_argument);
+
+    auto bad_version = bytes;
+    std::uint32_t version = dca::decline_binary_version + 1;
+    std::memcpy(bad_version.data() + 4, &version, 4);
+    BOOST_CHECK_THROW(dca::decline_batch_view(bad_version.data(),
+                bad_version.size()), std::invalid_argument);
+
+    auto bad_tag = bytes;
+    std::uint32_t tag = 99;
+    std::memcpy(bad_tag.data() + 24, &tag, 4);
+    dca::decline_batch_view view(bad_tag.data(), bad_tag.size());
+    BOOST_CHECK_THROW(view.get<dca::any>(0), std::invalid_argument);
+
+    // a hyperbolic tag in a batch only wide enough for qi and D
+    auto narrow = bytes;
+    tag = static_cast<std::uint32_t>(dca::decline_tag::arps_hyperbolic);
+    std::memcpy(narrow.data() + 24, &tag, 4);
+    dca::decline_batch_view narrow_view(narrow.data(), narrow.size());
+    BOOST_CHECK_EQUAL(narrow_view.width(), 2u);
+    BOOST_CHECK_THROW(narrow_view.get<dca::arps_hyperbolic>(0),
+            std::invalid_argument);
+    BOOST_CHECK_THROW(narrow_view.get<dca::any>(0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
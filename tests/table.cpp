@@ -0,0 +1,149 @@
+#include "dca/table.hpp"
+#include "dca/any_decline.hpp"
+#include "dca/decline.hpp"
+#include "dca/exponential.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/hyptoexp.hpp"
+
+#define BOOST_TEST_MODULE table
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+const double tolerance_pct = 1e-1;
+
+namespace {
+
+// the measured bounds hold (with a little slack) at arbitrary times
+template<class Decline>
+void check_bounds(const Decline& decl, const dca::forecast_table& table)
+{
+    std::mt19937 gen(36);
+    std::uniform_real_distribution<double> time(table.time_begin(),
+            table.time_end());
+
+    for (int i = 0; i < 10000; ++i) {
+        double t = time(gen);
+        BOOST_CHECK_LE(std::abs(table.cumulative(t) - decl.cumulative(t)),
+                1.01 * table.cumulative_error() + 1e-9);
+        BOOST_CHECK_LE(std::abs(table.rate(t) - decl.rate(t)),
+                1.01 * table.rate_error() + 1e-9);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( forecast_table )
+
+BOOST_AUTO_TEST_CASE( exact_on_grid )
+{
+    dca::arps_hyperbolic hyp(1000.0, 1.5, 1.2);
+    dca::forecast_table table(hyp, 0.0, 1.0 / 12.0, 600);
+
+    BOOST_CHECK_EQUAL(table.intervals(), 600u);
+    BOOST_CHECK_CLOSE(table.time_end(), 50.0, tolerance_pct);
+
+    for (std::size_t i = 0; i <= 600; i += 7) {
+        double t = i / 12.0;
+        BOOST_CHECK_CLOSE(table.rate(t), hyp.rate(t), 1e-9);
+        BOOST_CHECK_CLOSE(table.cumulative(t), hyp.cumulative(t), 1e-9);
+    }
+
+    // interval volumes on the table's own grid need no interpolation
+    std::vector<double> from_table, direct;
+    dca::interval_volumes(table, std::back_inserter(from_table),
+            0.0, 1.0 / 12.0, 600);
+    dca::interval_volumes(hyp, std::back_inserter(direct),
+            0.0, 1.0 / 12.0, 600);
+    for (std::size_t i = 0; i < direct.size(); ++i)
+        BOOST_CHECK_CLOSE(from_table[i], direct[i], 1e-7);
+}
+
+BOOST_AUTO_TEST_CASE( error_bounds )
+{
+    dca::arps_hyperbolic hyp(1000.0, 1.5, 1.2);
+    dca::forecast_table hyp_table(hyp, 0.0, 1.0 / 12.0, 600);
+    check_bounds(hyp, hyp_table);
+
+    dca::any h2e = dca::arps_hyperbolic_to_exponential(800.0, 2.0, 0.9,
+            dca::decline<dca::tangent_effective>(0.05));
+    dca::forecast_table h2e_table(h2e, 0.0, 1.0 / 12.0, 360);
+    check_bounds(h2e, h2e_table);
+
+    // small relative to the volumes involved
+    BOOST_CHECK_LT(hyp_table.cumulative_error(),
+            1e-4 * hyp.cumulative(1.0 / 12.0));
+
+    // fourth-order: halving the step cuts the error ~16x
+    dca::forecast_table fine(hyp, 0.0, 1.0 / 24.0, 1200);
+    BOOST_CHECK_LT(fine.cumulative_error(),
+            hyp_table.cumulative_error() / 8.0);
+}
+
+BOOST_AUTO_TEST_CASE( inverse_cumulative )
+{
+    dca::arps_exponential exp(500.0, 0.3);
+    dca::forecast_table table(exp, 0.0, 1.0 / 12.0, 360);
+
+    for (double t : { 0.0, 0.01, 1.0, 7.77, 29.5, 30.0 }) {
+        double cum = table.cumulative(t);
+        BOOST_CHECK_SMALL(table.time_to_cumulative(cum) - t, 1e-9);
+    }
+
+    // against the analytic inverse
+    double cum = 1000.0;
+    double t = -std::log(1.0 - cum * 0.3 / 500.0) / 0.3;
+    BOOST_CHECK_CLOSE(table.time_to_cumulative(cum), t, tolerance_pct);
+
+    BOOST_CHECK_THROW(table.time_to_cumulative(-1.0), std::out_of_range);
+    BOOST_CHECK_THROW(table.time_to_cumulative(exp.cumulative(31.0)),
+            std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE( scaling )
+{
+    dca::arps_hyperbolic hyp(1000.0, 1.2, 1.1);
+    dca::arps_hyperbolic hyp2(250.0, 1.2, 1.1);
+    dca::forecast_table table(hyp, 0.0, 1.0 / 12.0, 240);
+    auto quarter = table.scaled(0.25);
+
+    BOOST_CHECK_EQUAL(quarter.scale(), 0.25);
+    BOOST_CHECK_EQUAL(table.scale(), 1.0);
+    BOOST_CHECK_CLOSE(quarter.cumulative_error(),
+            0.25 * table.cumulative_error(), 1e-9);
+
+    for (double t : { 0.0, 0.3, 2.0, 11.1, 20.0 }) {
+        BOOST_CHECK_CLOSE(quarter.rate(t), hyp2.rate(t), tolerance_pct);
+        BOOST_CHECK_CLOSE(quarter.cumulative(t), hyp2.cumulative(t),
+                tolerance_pct);
+    }
+
+    double cum = hyp2.cumulative(5.0);
+    BOOST_CHECK_CLOSE(quarter.time_to_cumulative(cum), 5.0, tolerance_pct);
+
+    BOOST_CHECK_THROW(table.scaled(0.0), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE( bad_queries )
+{
+    dca::arps_exponential exp(500.0, 0.3);
+    BOOST_CHECK_THROW(dca::forecast_table(exp, 0.0, 0.0, 10),
+            std::out_of_range);
+    BOOST_CHECK_THROW(dca::forecast_table(exp, 0.0, 1.0, 0),
+            std::out_of_range);
+
+    dca::forecast_table table(exp, 1.0, 0.5, 10);
+    BOOST_CHECK_THROW(table.rate(0.5), std::out_of_range);
+    BOOST_CHECK_THROW(table.cumulative(6.5), std::out_of_range);
+    BOOST_CHECK_CLOSE(table.rate(6.0), exp.rate(6.0), 1e-9);
+
+    // usable wherever a decline is
+    dca::any wrapped = table;
+    BOOST_CHECK_CLOSE(wrapped.cumulative(3.3), table.cumulative(3.3), 1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
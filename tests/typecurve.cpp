@@ -0,0 +1,108 @@
+#include "dca/decline.hpp"
+#include "dca/hyperbolic.hpp"
+#include "dca/production.hpp"
+#include "dca/typecurve.hpp"
+
+#define BOOST_TEST_MODULE typecurve
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+const double tolerance_pct = 1e-1;
+
+BOOST_AUTO_TEST_SUITE( grouped )
+
+BOOST_AUTO_TEST_CASE( matches_per_group )
+{
+    std::vector<std::string> keys;
+    std::vector<std::vector<double>> prod;
+    for (int i = 0; i < 30; ++i) {
+        keys.push_back(i % 3 == 0 ? "north" : i % 3 == 1 ? "south" : "east");
+        dca::arps_hyperbolic decl(1000.0 * (1 + i % 3) + 10.0 * i,
+                0.8 + 0.01 * i, 1.0 + 0.2 * (i % 3));
+        prod.emplace_back();
+        dca::interval_volumes(decl, std::back_inserter(prod.back()),
+                0.0, 1.0 / 12, 24 + i % 5);
+    }
+    keys.push_back("lonely");
+    prod.push_back(std::vector<double> { 100.0 });
+
+    using range = std::pair<std::vector<double>::const_iterator,
+          std::vector<double>::const_iterator>;
+    std::vector<range> ranges;
+    for (const auto& p : prod)
+        ranges.emplace_back(p.begin(), p.end());
+
+    auto curves = dca::grouped_type_curves<dca::arps_hyperbolic>(
+            keys.begin(), keys.end(), ranges.begin(), 1.0 / 3.0,
+            dca::mean {}, 0.0, 1.0 / 12, dca::fit_options {}, 4);
+
+    // "lonely" has a single month: too short to fit
+    BOOST_REQUIRE_EQUAL(curves.size(), 3u);
+    BOOST_CHECK_EQUAL(curves[0].key, "east");
+    BOOST_CHECK_EQUAL(curves[1].key, "north");
+    BOOST_CHECK_EQUAL(curves[2].key, "south");
+
+    for (const auto& curve : curves) {
+        std::vector<range> group;
+        for (std::size_t i = 0; i < ranges.size(); ++i)
+            if (keys[i] == curve.key)
+                group.push_back(ranges[i]);
+        BOOST_CHECK_EQUAL(curve.wells, group.size());
+
+        std::vector<double> type_well;
+        dca::aggregate_production(group.begin(), group.end(),
+                std::back_inserter(type_well), group.size() / 3,
+                dca::mean {});
+        BOOST_REQUIRE_EQUAL(curve.type_well.size(), type_well.size());
+        for (std::size_t i = 0; i < type_well.size(); ++i)
+            BOOST_CHECK_CLOSE(curve.type_well[i], type_well[i], tolerance_pct);
+
+        auto fit = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+                type_well.begin(), type_well.end(), 0.0, 1.0 / 12);
+        BOOST_CHECK_CLOSE(curve.decline.qi(), fit.qi(), tolerance_pct);
+        BOOST_CHECK_CLOSE(curve.decline.Di(), fit.Di(), tolerance_pct);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( forwards_options )
+{
+    std::vector<int> keys;
+    std::vector<std::vector<double>> prod;
+    for (int i = 0; i < 12; ++i) {
+        keys.push_back(i % 4);
+        prod.emplace_back();
+        dca::interval_volumes(dca::arps_hyperbolic(1000.0 + 50.0 * i, 0.9,
+                    0.8 + 0.1 * (i % 4)), std::back_inserter(prod.back()),
+                0.0, 1.0 / 12, 36);
+    }
+
+    using range = std::pair<std::vector<double>::const_iterator,
+          std::vector<double>::const_iterator>;
+    std::vector<range> ranges;
+    for (const auto& p : prod)
+        ranges.emplace_back(p.begin(), p.end());
+
+    // a few iterations only: far from converged, so unlike the default fit
+    dca::fit_options options;
+    options.max_iter = 4;
+    auto curves = dca::grouped_type_curves<dca::arps_hyperbolic>(
+            keys.begin(), keys.end(), ranges.begin(), 1.0, dca::mean {},
+            0.0, 1.0 / 12, options, 2);
+
+    BOOST_REQUIRE_EQUAL(curves.size(), 4u);
+    for (const auto& curve : curves) {
+        auto fit = dca::best_from_interval_volume<dca::arps_hyperbolic>(
+                curve.type_well.begin(), curve.type_well.end(), 0.0, 1.0 / 12,
+                options);
+        BOOST_CHECK_EQUAL(curve.decline.qi(), fit.qi());
+        BOOST_CHECK_EQUAL(curve.decline.Di(), fit.Di());
+        BOOST_CHECK_EQUAL(curve.decline.b(), fit.b());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
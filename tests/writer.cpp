@@ -0,0 +1,166 @@
+#include "dca/writer.hpp"
+#include "dca/parse.hpp"
+
+#define BOOST_TEST_MODULE writer
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string format(double value)
+{
+    char text[dca::max_formatted_length];
+    return std::string(text, dca::format_shortest(value, text));
+}
+
+std::vector<double> forecast(std::size_t well, std::size_t months)
+{
+    std::vector<double> result;
+    for (std::size_t i = 0; i < months; ++i)
+        result.push_back(1000.0 / (well + 1) / (1.0 + 0.1 * i));
+    return result;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( shortest )
+
+BOOST_AUTO_TEST_CASE( known )
+{
+    BOOST_CHECK_EQUAL(format(0.0), "0");
+    BOOST_CHECK_EQUAL(format(-0.0), "-0");
+    BOOST_CHECK_EQUAL(format(0.1), "0.1");
+    BOOST_CHECK_EQUAL(format(0.3), "0.3");
+    BOOST_CHECK_EQUAL(format(1500.0), "1500");
+    BOOST_CHECK_EQUAL(format(-2.5), "-2.5");
+    BOOST_CHECK_EQUAL(format(123.456), "123.456");
+    BOOST_CHECK_EQUAL(format(0.000123), "0.000123");
+    BOOST_CHECK_EQUAL(format(1e-7), "1e-7");
+    BOOST_CHECK_EQUAL(format(1e21), "1e21");
+    BOOST_CHECK_EQUAL(format(5e-324), "5e-324");
+    BOOST_CHECK_EQUAL(format(1.7976931348623157e308),
+            "1.7976931348623157e308");
+}
+
+BOOST_AUTO_TEST_CASE( round_trip )
+{
+    std::mt19937_64 gen(35);
+    std::uniform_real_distribution<double> rates(0.0, 1e5);
+
+    for (int i = 0; i < 200000; ++i) {
+        std::uint64_t bits = gen();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (((bits >> 52) & 0x7FF) == 0x7FF) // inf, NaN
+            continue;
+
+        for (double v : { value, rates(gen) }) {
+            auto text = format(v);
+            BOOST_REQUIRE(text.size() <= dca::max_formatted_length);
+
+            double parsed;
+            BOOST_REQUIRE(dca::parse_double(text.data(),
+                        text.data() + text.size(), parsed));
+            BOOST_CHECK_MESSAGE(
+                    std::memcmp(&parsed, &v, sizeof(v)) == 0, text);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( forecast_writer )
+
+#ifndef DCA_NO_IOSTREAMS
+BOOST_AUTO_TEST_CASE( tsv )
+{
+    std::ostringstream os;
+    {
+        dca::forecast_writer writer(os);
+        std::vector<std::string> names { "Oil", "Gas" };
+        writer.header(names.begin(), names.end());
+        std::vector<double> oil { 100, 50.5 }, gas { 0.25, 1e-7 };
+        writer.write("W1", 2, oil.begin(), gas.begin());
+    }
+
+    BOOST_CHECK_EQUAL(os.str(),
+            "Well\tMonth\tOil\tGas\n"
+            "W1\t0\t100\t0.25\n"
+            "W1\t1\t50.5\t1e-7\n");
+}
+#endif
+
+BOOST_AUTO_TEST_CASE( binary )
+{
+    std::string out;
+    {
+        dca::forecast_writer writer([&](const char* p, std::size_t n) {
+            out.append(p, n);
+        }, dca::forecast_format::binary);
+        std::vector<double> oil { 100, 50.5, 25 };
+        writer.write("W12", 3, oil.begin());
+    }
+
+    std::uint32_t u32[3];
+    std::memcpy(&u32[0], out.data(), 4);
+    BOOST_CHECK_EQUAL(u32[0], 3u);
+    BOOST_CHECK_EQUAL(out.substr(4, 3), "W12");
+    std::memcpy(&u32[1], out.data() + 7, 8);
+    BOOST_CHECK_EQUAL(u32[1], 3u);
+    BOOST_CHECK_EQUAL(u32[2], 1u);
+    BOOST_REQUIRE_EQUAL(out.size(), 15 + 3 * sizeof(double));
+
+    double values[3];
+    std::memcpy(values, out.data() + 15, sizeof(values));
+    BOOST_CHECK_EQUAL(values[0], 100);
+    BOOST_CHECK_EQUAL(values[1], 50.5);
+    BOOST_CHECK_EQUAL(values[2], 25);
+}
+
+BOOST_AUTO_TEST_CASE( parallel_matches_serial )
+{
+    const std::size_t wells = 1000, months = 37;
+
+    for (auto fmt : { dca::forecast_format::tsv,
+            dca::forecast_format::binary }) {
+        std::string serial, parallel;
+        std::size_t writes = 0;
+
+        {
+            dca::forecast_writer writer([&](const char* p, std::size_t n) {
+                serial.append(p, n);
+            }, fmt);
+            for (std::size_t w = 0; w < wells; ++w) {
+                auto f = forecast(w, months);
+                writer.write("Well" + std::to_string(w), months,
+                        f.begin(), f.begin());
+            }
+        }
+
+        {
+            // small buffer: many sink writes, some chunks bypassing it
+            dca::forecast_writer writer([&](const char* p, std::size_t n) {
+                parallel.append(p, n);
+                ++writes;
+            }, fmt, 4096);
+            writer.write_parallel(wells,
+                    [&](std::size_t w, dca::forecast_buffer& buffer) {
+                        auto f = forecast(w, months);
+                        buffer.append("Well" + std::to_string(w), months,
+                                f.begin(), f.begin());
+                    }, 4, 7);
+        }
+
+        BOOST_CHECK(serial == parallel);
+        BOOST_CHECK(writes > 1);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()